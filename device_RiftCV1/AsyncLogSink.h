@@ -0,0 +1,242 @@
+#pragma once
+#include <array>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstdint>
+#include <cwchar>
+#include <functional>
+#include <string>
+#include <thread>
+
+enum LogLevel
+{
+	Log_Info,
+	Log_Warning,
+	Log_Error
+};
+
+// One place in the code that logs, rate-limited on its own
+// Make these static, the sink only keeps pointers to them
+struct LogSite
+{
+	LogSite(const wchar_t* _message, const LogLevel _level,
+	        const std::chrono::seconds _window = std::chrono::seconds(10)) :
+		message(_message), level(_level), window(_window)
+	{
+	}
+
+	const wchar_t* message;
+	LogLevel level;
+	std::chrono::seconds window; // At most one message per window, the rest get coalesced
+
+	std::atomic<long long> windowStart{0}; // steady_clock ticks, 0 = no window open
+	std::atomic<uint32_t> suppressed{0};
+	std::atomic<bool> registered{false};
+};
+
+// Hot-path logging without allocations or host calls on the calling thread
+// Messages go into a preallocated ring, a background thread hands them to the host
+class AsyncLogSink
+{
+public:
+	static constexpr size_t capacity = 256; // Power of two
+	static constexpr size_t max_message = 256;
+	static constexpr size_t max_sites = 64;
+
+	using Callback = std::function<void(std::wstring)>;
+
+	AsyncLogSink()
+	{
+		for (size_t i = 0; i < capacity; i++)
+			mEntries[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	~AsyncLogSink() { stop(); }
+
+	// The callbacks are the host's, they may be set up only after we're constructed
+	void start(Callback& info, Callback& warning, Callback& error)
+	{
+		stop();
+
+		mCallbacks = {&info, &warning, &error};
+		mStop = false;
+		mThread = std::thread([this] { drain_loop(); });
+	}
+
+	// Flushes everything that's left, returns within one drain period
+	void stop()
+	{
+		mStop = true;
+		if (mThread.joinable())
+			mThread.join();
+	}
+
+	// Logs the site's message, if its window allows
+	void log(LogSite& site)
+	{
+		if (admit(site))
+			push(site.level, L"%ls", site.message);
+	}
+
+	// Same, with printf-style details after the site's message ("message: details")
+	void log(LogSite& site, const wchar_t* format, ...)
+	{
+		if (!admit(site)) return;
+
+		wchar_t details[max_message];
+		va_list args;
+		va_start(args, format);
+		std::vswprintf(details, max_message, format, args);
+		va_end(args);
+
+		push(site.level, L"%ls: %ls", site.message, details);
+	}
+
+	[[nodiscard]] uint64_t dropped() const { return mDropped.load(std::memory_order_relaxed); }
+
+private:
+	struct Entry
+	{
+		std::atomic<size_t> sequence{0};
+		LogLevel level = Log_Info;
+		wchar_t text[max_message] = {};
+	};
+
+	static long long now_ticks()
+	{
+		return std::chrono::steady_clock::now().time_since_epoch().count();
+	}
+
+	bool admit(LogSite& site)
+	{
+		if (!site.registered.exchange(true, std::memory_order_relaxed))
+		{
+			if (const size_t slot = mSiteCount.fetch_add(1, std::memory_order_relaxed); slot < max_sites)
+				mSites[slot].store(&site, std::memory_order_release);
+		}
+
+		const long long now = now_ticks();
+		long long start = site.windowStart.load(std::memory_order_relaxed);
+
+		const long long window = std::chrono::duration_cast<std::chrono::steady_clock::duration>(site.window).count();
+		if (start != 0 && now - start < window)
+		{
+			site.suppressed.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+
+		// Only one thread gets to open the new window
+		if (!site.windowStart.compare_exchange_strong(start, now, std::memory_order_relaxed))
+		{
+			site.suppressed.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+
+		flush_suppressed(site);
+		return true;
+	}
+
+	// "... (repeated 900x in last 10 s)"
+	void flush_suppressed(LogSite& site)
+	{
+		if (const uint32_t repeated = site.suppressed.exchange(0, std::memory_order_relaxed); repeated > 0)
+			push(site.level, L"%ls (repeated %ux in last %lld s)", site.message, repeated,
+			     static_cast<long long>(site.window.count()));
+	}
+
+	void push(const LogLevel level, const wchar_t* format, ...)
+	{
+		// Bounded MPSC ring (Vyukov), producers never wait on the drain thread
+		size_t position = mHead.load(std::memory_order_relaxed);
+		Entry* entry;
+
+		for (;;)
+		{
+			entry = &mEntries[position & (capacity - 1)];
+			const size_t sequence = entry->sequence.load(std::memory_order_acquire);
+			const auto difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+
+			if (difference == 0)
+			{
+				if (mHead.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (difference < 0)
+			{
+				mDropped.fetch_add(1, std::memory_order_relaxed);
+				return; // Full
+			}
+			else
+				position = mHead.load(std::memory_order_relaxed);
+		}
+
+		entry->level = level;
+
+		va_list args;
+		va_start(args, format);
+		std::vswprintf(entry->text, max_message, format, args);
+		va_end(args);
+
+		entry->sequence.store(position + 1, std::memory_order_release);
+	}
+
+	void drain_loop()
+	{
+		for (;;)
+		{
+			const bool stopping = mStop;
+
+			// Windows that ran out with repeats pending get their summary now
+			const size_t sites = std::min<size_t>(mSiteCount.load(std::memory_order_relaxed), max_sites);
+			for (size_t i = 0; i < sites; i++)
+			{
+				LogSite* site = mSites[i].load(std::memory_order_acquire);
+				if (!site || site->suppressed.load(std::memory_order_relaxed) == 0)
+					continue;
+
+				const long long window = std::chrono::duration_cast<
+					std::chrono::steady_clock::duration>(site->window).count();
+				long long start = site->windowStart.load(std::memory_order_relaxed);
+				if (stopping)
+					flush_suppressed(*site);
+				// Closed, not restarted: the next message that comes along opens a window of its own
+				// (unless one already did, then that one flushed the repeats with it)
+				else if (start != 0 && now_ticks() - start >= window &&
+					site->windowStart.compare_exchange_strong(start, 0, std::memory_order_relaxed))
+					flush_suppressed(*site);
+			}
+
+			// Hand everything queued over to the host
+			for (;;)
+			{
+				Entry& entry = mEntries[mTail & (capacity - 1)];
+				if (entry.sequence.load(std::memory_order_acquire) != mTail + 1)
+					break;
+
+				if (const Callback* callback = mCallbacks[entry.level]; callback && *callback)
+					(*callback)(entry.text);
+
+				entry.sequence.store(mTail + capacity, std::memory_order_release);
+				mTail++;
+			}
+
+			if (stopping) return;
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		}
+	}
+
+	std::array<Entry, capacity> mEntries;
+	alignas(64) std::atomic<size_t> mHead{0};
+	alignas(64) size_t mTail = 0;
+
+	std::array<std::atomic<LogSite*>, max_sites> mSites{};
+	std::atomic<size_t> mSiteCount{0};
+
+	std::array<const Callback*, 3> mCallbacks{};
+	std::atomic<uint64_t> mDropped{0};
+
+	std::atomic<bool> mStop{false};
+	std::thread mThread;
+};
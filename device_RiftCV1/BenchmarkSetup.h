@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "PoseSource.h"
+
+// What every benchmark (IngestBenchmark.h, LoadBenchmark.h, ...) runs against
+// The plugin hooks its own filter and joints in, bench/pose_bench.cpp plain stand-ins
+struct BenchmarkSetup
+{
+	// Smoothing, runs right after acquisition
+	std::function<void(JointFrame&)> filter;
+
+	// Pushes the frame into joints, like apply_frame()
+	std::function<void(const JointFrame&)> apply;
+
+	// Both write every joint of the frame, see benchmark_conversion()
+	std::function<void(const JointFrame&)> convert_scalar;
+	std::function<void(const JointFrame&)> convert_batch;
+
+	// Heap allocations made so far, leave empty if there's no way to tell
+	std::function<uint64_t()> allocations;
+
+	// Where poses come from for a given object count, StubPoseSource if left empty
+	std::function<std::unique_ptr<IPoseSource>(uint32_t objects)> source;
+
+	uint32_t frames = 20000;
+	double prediction = 0.011; // Seconds, when prediction is on
+
+	[[nodiscard]] std::unique_ptr<IPoseSource> make_source(const uint32_t objects) const
+	{
+		if (source) return source(objects);
+		return std::make_unique<StubPoseSource>(objects);
+	}
+};
+
+// One JSON document out of whichever benchmarks ran, in the order they're added
+// Every benchmark has its to_json(result), see json_array() for the ones with several
+class BenchmarkReport
+{
+public:
+	explicit BenchmarkReport(const std::string& name) : mJson("{\"benchmark\": \"" + name + "\"")
+	{
+	}
+
+	// 'json' is the section's value, an object or array
+	void add(const std::string& key, const std::string& json)
+	{
+		mJson += ",\n\"" + key + "\": " + json;
+	}
+
+	[[nodiscard]] std::string json() const { return mJson + "}\n"; }
+
+private:
+	std::string mJson;
+};
+
+// "[\n  {...},\n  {...}\n]", each element by its to_json()
+template <class Result>
+std::string json_array(const std::vector<Result>& results)
+{
+	std::string json = "[\n";
+	for (size_t i = 0; i < results.size(); i++)
+		json += "  " + to_json(results[i]) + (i + 1 < results.size() ? ",\n" : "\n");
+	return json + "]";
+}
@@ -0,0 +1,190 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+// Linear map from the SDK clock (ovr_GetTimeInSeconds) to host time
+// (AME_API_GET_TIMESTAMP_NOW, system_clock microseconds)
+struct ClockMapping
+{
+	bool valid = false;
+	double sdkReference = 0.0; // s
+	long long hostReference = 0; // us
+	double rate = 1.0; // Host seconds per SDK second, 1 + drift
+
+	[[nodiscard]] long long to_host(const double sdk_time) const
+	{
+		return hostReference + std::llround((sdk_time - sdkReference) * rate * 1e6);
+	}
+};
+
+// Keeps estimating offset and drift between the two clocks from pairs of readings
+// taken back to back. Per time slot only the pair read the fastest is kept (a slow read
+// means we got preempted in between), and pairs that still don't fit the line get
+// rejected before the final fit. Host time is wall-clock time, so it can also jump
+// (NTP, someone setting the clock): the mapping moves along right away and the history
+// starts over. Not thread-safe, feed and read it from one thread
+class ClockMapper
+{
+public:
+	static constexpr double slot_seconds = 0.1;
+	static constexpr size_t slot_count = 64; // ~6 s of history
+	static constexpr size_t min_slots = 8; // Before the mapping is trusted
+	static constexpr long long step_us = 5000; // Off the line by more: the host clock jumped
+
+	// 'host_before'/'host_after' bracket the read of 'sdk_time'
+	void add(const double sdk_time, const long long host_before, const long long host_after)
+	{
+		const long long round_trip = std::max<long long>(host_after - host_before, 0);
+		const long long host_time = host_before + round_trip / 2;
+
+		const auto slot_index = static_cast<int64_t>(std::floor(sdk_time / slot_seconds));
+		if (slot_index != mSlotIndex)
+		{
+			// The previous slot is done, refit with it in
+			if (mCurrent.used)
+			{
+				step(mCurrent);
+				mSlots[mNext] = mCurrent;
+				mNext = (mNext + 1) % slot_count;
+				mFilled = std::min(mFilled + 1, slot_count);
+				fit();
+			}
+
+			mSlotIndex = slot_index;
+			mCurrent = {};
+		}
+
+		if (!mCurrent.used || round_trip < mCurrent.roundTrip)
+			mCurrent = {true, sdk_time, host_time, round_trip};
+	}
+
+	void reset() { *this = {}; }
+
+	[[nodiscard]] const ClockMapping& mapping() const { return mMapping; }
+
+	[[nodiscard]] double drift_ppm() const { return mMapping.valid ? (mMapping.rate - 1.0) * 1e6 : 0.0; }
+	[[nodiscard]] double residual_us() const { return mResidual; } // RMS of the pairs that were kept
+	[[nodiscard]] size_t rejected() const { return mRejected; } // In the last fit
+	[[nodiscard]] size_t steps() const { return mSteps; } // Host clock jumps followed
+
+private:
+	struct Pair
+	{
+		bool used = false;
+		double sdkTime = 0.0;
+		long long hostTime = 0;
+		long long roundTrip = 0;
+	};
+
+	// A pair that's way off the current mapping (and not because it was read slowly)
+	// means every older pair is on the old host clock: shift by the jump, drop those
+	void step(const Pair& pair)
+	{
+		if (!mMapping.valid) return;
+
+		const long long offset = pair.hostTime - mMapping.to_host(pair.sdkTime);
+		if (std::abs(offset) <= std::max(step_us, pair.roundTrip)) return;
+
+		mMapping.hostReference += offset;
+		mNext = 0;
+		mFilled = 0;
+		mSteps++;
+	}
+
+	void fit()
+	{
+		if (mFilled < min_slots) return;
+
+		// Relative to the newest pair, keeps the numbers small
+		const Pair& newest = mSlots[(mNext + slot_count - 1) % slot_count];
+
+		std::array<double, slot_count> x{}, y{};
+		std::array<bool, slot_count> keep{};
+		for (size_t i = 0; i < mFilled; i++)
+		{
+			x[i] = mSlots[i].sdkTime - newest.sdkTime;
+			y[i] = static_cast<double>(mSlots[i].hostTime - newest.hostTime) * 1e-6;
+			keep[i] = true;
+		}
+
+		double slope = 1.0, intercept = 0.0;
+		if (!line(x, y, keep, slope, intercept)) return;
+
+		// Throw out whatever's way off the first line, then fit again
+		std::array<double, slot_count> residuals{};
+		for (size_t i = 0; i < mFilled; i++)
+			residuals[i] = std::abs(y[i] - (intercept + slope * x[i]));
+
+		std::array<double, slot_count> sorted = residuals;
+		std::nth_element(sorted.begin(), sorted.begin() + mFilled / 2, sorted.begin() + mFilled);
+		const double limit = std::max(sorted[mFilled / 2] * 3.0 * 1.4826, 20e-6); // 3 sigma (MAD), 20 us floor
+
+		mRejected = 0;
+		for (size_t i = 0; i < mFilled; i++)
+			if (residuals[i] > limit)
+			{
+				keep[i] = false;
+				mRejected++;
+			}
+
+		if (!line(x, y, keep, slope, intercept)) return;
+
+		double squares = 0.0;
+		size_t kept = 0;
+		for (size_t i = 0; i < mFilled; i++)
+			if (keep[i])
+			{
+				const double residual = y[i] - (intercept + slope * x[i]);
+				squares += residual * residual;
+				kept++;
+			}
+
+		mResidual = std::sqrt(squares / std::max<size_t>(kept, 1)) * 1e6;
+
+		mMapping.valid = true;
+		mMapping.sdkReference = newest.sdkTime;
+		mMapping.hostReference = newest.hostTime + std::llround(intercept * 1e6);
+		mMapping.rate = slope;
+	}
+
+	// Least squares y = intercept + slope * x over the kept pairs
+	bool line(const std::array<double, slot_count>& x, const std::array<double, slot_count>& y,
+	          const std::array<bool, slot_count>& keep, double& slope, double& intercept) const
+	{
+		double n = 0, sx = 0, sy = 0, sxx = 0, sxy = 0;
+		for (size_t i = 0; i < mFilled; i++)
+		{
+			if (!keep[i]) continue;
+			n += 1;
+			sx += x[i];
+			sy += y[i];
+			sxx += x[i] * x[i];
+			sxy += x[i] * y[i];
+		}
+
+		const double denominator = n * sxx - sx * sx;
+		if (n < 2 || std::abs(denominator) < 1e-12) return false;
+
+		slope = (n * sxy - sx * sy) / denominator;
+		intercept = (sy - slope * sx) / n;
+
+		// The clocks can't really disagree by more than a fraction of a percent
+		if (std::abs(slope - 1.0) > 0.01)
+			slope = 1.0, intercept = (sy - sx) / n;
+		return true;
+	}
+
+	std::array<Pair, slot_count> mSlots{};
+	size_t mNext = 0;
+	size_t mFilled = 0;
+
+	Pair mCurrent;
+	int64_t mSlotIndex = INT64_MIN;
+
+	ClockMapping mMapping;
+	double mResidual = 0.0;
+	size_t mRejected = 0;
+	size_t mSteps = 0;
+};
@@ -0,0 +1,259 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Runs commands one after another on a single thread, right away or after a delay
+// Delays sit on a hashed timer wheel, any of them can be cancelled until it fires
+// Commands shouldn't block: split long sequences into steps that schedule each other,
+// so stop() never has to wait longer than one step
+class CommandWorker
+{
+public:
+	using Command = std::function<void()>;
+	using TimerId = uint64_t; // 0 is never handed out
+
+	static constexpr std::chrono::milliseconds tick{10};
+	static constexpr size_t wheel_slots = 256; // 2.56 s per turn, longer delays take more rounds
+
+	~CommandWorker() { stop(); }
+
+	// Whatever was posted or scheduled before this runs once it's up (delays count from when
+	// they were scheduled); starting a running worker restarts it, dropping its queue like stop()
+	void start()
+	{
+		if (running())
+			stop();
+
+		std::lock_guard lock(mMutex);
+		mStop = false;
+		if (mTimers.empty())
+		{
+			mStart = clock::now();
+			mTick = 0;
+		}
+		mThread = std::thread([this] { work_loop(); });
+	}
+
+	// Drops everything that's still pending, returns once the running command (if any) is done
+	void stop()
+	{
+		{
+			std::lock_guard lock(mMutex);
+			mStop = true;
+		}
+		mWake.notify_one();
+
+		if (mThread.joinable())
+			mThread.join();
+
+		std::lock_guard lock(mMutex);
+		mQueue.clear();
+		for (auto& slot : mWheel)
+			slot.clear();
+		mTimers.clear();
+	}
+
+	[[nodiscard]] bool running() const { return mThread.joinable(); }
+
+	// Runs the command as soon as the worker gets to it
+	void post(Command command)
+	{
+		{
+			std::lock_guard lock(mMutex);
+			mQueue.push_back(std::move(command));
+		}
+		mWake.notify_one();
+	}
+
+	// Runs the command after 'delay' (rounded up to whole ticks), then every 'period' if set
+	TimerId schedule(const std::chrono::milliseconds delay, Command command,
+	                 const std::chrono::milliseconds period = std::chrono::milliseconds(0))
+	{
+		TimerId id;
+		{
+			std::lock_guard lock(mMutex);
+			id = ++mLastId;
+			arm(Timer{id, 0, period, std::move(command)}, delay, true);
+		}
+		mWake.notify_one(); // In case the worker's idle
+		return id;
+	}
+
+	// Safe to call with timers that already fired, from any thread (also from a command)
+	void cancel(const TimerId id)
+	{
+		std::lock_guard lock(mMutex);
+		if (id == mFiring)
+			mFiringCancelled = true;
+
+		const auto found = mTimers.find(id);
+		if (found == mTimers.end()) return;
+
+		auto& slot = mWheel[found->second];
+		slot.erase(std::remove_if(slot.begin(), slot.end(),
+		                          [id](const Timer& timer) { return timer.id == id; }), slot.end());
+		mTimers.erase(found);
+	}
+
+	// Commands queued plus timers armed
+	[[nodiscard]] size_t pending() const
+	{
+		std::lock_guard lock(mMutex);
+		return mQueue.size() + mTimers.size();
+	}
+
+	// Times the worker woke up from waiting, to keep an eye on what idling costs
+	[[nodiscard]] uint64_t wakeups() const
+	{
+		std::lock_guard lock(mMutex);
+		return mWakeups;
+	}
+
+private:
+	using clock = std::chrono::steady_clock;
+
+	struct Timer
+	{
+		TimerId id = 0;
+		uint64_t rounds = 0; // Full turns of the wheel left before it fires
+		std::chrono::milliseconds period{0};
+		Command command;
+	};
+
+	// Call with mMutex held
+	// 'from_now': count from the tick we're in, the worker may be asleep with mTick a few behind
+	// (otherwise from mTick, for periodic timers re-armed while catching up)
+	void arm(Timer timer, const std::chrono::milliseconds delay, const bool from_now = false)
+	{
+		// The wheel stood still while nothing was armed, restart it from now
+		// (also when a posted command is the one arming, the worker never went to sleep then)
+		const auto now = clock::now();
+		if (mTimers.empty())
+			mStart = now - tick * mTick;
+
+		uint64_t ticks = std::max<uint64_t>((delay.count() + tick.count() - 1) / tick.count(), 1);
+		if (from_now)
+		{
+			const auto current = static_cast<uint64_t>((now - mStart) / tick);
+			ticks += current > mTick ? current - mTick : 0;
+		}
+		const size_t slot = (mTick + ticks) % wheel_slots;
+
+		timer.rounds = (ticks - 1) / wheel_slots;
+		mTimers[timer.id] = slot;
+		mWheel[slot].push_back(std::move(timer));
+	}
+
+	void work_loop()
+	{
+		std::unique_lock lock(mMutex);
+		while (!mStop)
+		{
+			// Everything posted goes first, in order
+			while (!mQueue.empty() && !mStop)
+			{
+				Command command = std::move(mQueue.front());
+				mQueue.pop_front();
+
+				lock.unlock();
+				command();
+				lock.lock();
+			}
+
+			// Catch up on every tick that's passed, even if a command took a while
+			const auto now = clock::now();
+			while (!mStop && mStart + tick * (mTick + 1) <= now)
+			{
+				mTick++;
+				fire_slot(lock, mTick % wheel_slots);
+			}
+
+			if (mStop || !mQueue.empty()) continue;
+
+			// Nothing armed: sleep until someone posts or schedules
+			if (mTimers.empty())
+				mWake.wait(lock, [this] { return mStop || !mQueue.empty() || !mTimers.empty(); });
+			// Otherwise until the next one is due, not every tick: the ticks in between get
+			// caught up on above (schedule() wakes us up for anything sooner)
+			else
+				mWake.wait_until(lock, mStart + tick * (mTick + ticks_to_next()));
+			mWakeups++;
+		}
+	}
+
+	// Ticks after mTick until the soonest armed timer fires, call with mMutex held
+	[[nodiscard]] uint64_t ticks_to_next() const
+	{
+		uint64_t next = UINT64_MAX;
+		for (uint64_t ahead = 1; ahead <= wheel_slots && ahead < next; ahead++)
+			for (const Timer& timer : mWheel[(mTick + ahead) % wheel_slots])
+				next = std::min<uint64_t>(next, ahead + timer.rounds * wheel_slots);
+		return next;
+	}
+
+	void fire_slot(std::unique_lock<std::mutex>& lock, const size_t slot)
+	{
+		// Pick the due ones first, commands may arm or cancel timers in this very slot
+		std::vector<TimerId> due;
+		for (Timer& timer : mWheel[slot])
+		{
+			if (timer.rounds > 0)
+				timer.rounds--;
+			else
+				due.push_back(timer.id);
+		}
+
+		for (const TimerId id : due)
+		{
+			if (mStop) return;
+			if (!mTimers.contains(id)) continue; // Cancelled meanwhile
+
+			auto& timers = mWheel[slot];
+			const auto found = std::find_if(timers.begin(), timers.end(),
+			                                [id](const Timer& timer) { return timer.id == id; });
+			Timer timer = std::move(*found);
+			timers.erase(found);
+			mTimers.erase(id);
+
+			mFiring = id;
+			mFiringCancelled = false;
+
+			lock.unlock();
+			timer.command();
+			lock.lock();
+
+			if (timer.period.count() > 0 && !mFiringCancelled && !mStop)
+			{
+				const auto period = timer.period;
+				arm(std::move(timer), period);
+			}
+			mFiring = 0;
+		}
+	}
+
+	mutable std::mutex mMutex;
+	std::condition_variable mWake;
+
+	std::deque<Command> mQueue;
+	std::vector<Timer> mWheel[wheel_slots];
+	std::unordered_map<TimerId, size_t> mTimers; // Armed timers, and their slot
+	TimerId mLastId = 0;
+	uint64_t mWakeups = 0;
+
+	clock::time_point mStart;
+	uint64_t mTick = 0; // Last tick that fired
+
+	TimerId mFiring = 0;
+	bool mFiringCancelled = false;
+
+	bool mStop = false;
+	std::thread mThread;
+};
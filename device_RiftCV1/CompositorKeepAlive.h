@@ -0,0 +1,97 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <algorithm>
+
+// Whatever submits the (empty) keep-alive frames to the compositor
+// Implemented by GuardianSystem, swap it for a fake one to measure without a headset
+class IFrameSubmitter
+{
+public:
+	virtual ~IFrameSubmitter() = default;
+
+	// Submits a single frame, may block until the compositor paces us
+	// Returns false if the submission failed
+	virtual bool submit_frame() = 0;
+
+	// Whether the compositor needs a frame right now to keep the session visible
+	virtual bool wants_frame() { return true; }
+};
+
+// Feeds the compositor from its own thread, so ovr_SubmitFrame's vsync pacing
+// never ends up on the tracking path
+class CompositorKeepAlive
+{
+public:
+	~CompositorKeepAlive() { stop(); }
+
+	// rate_hz == 0 means 'on demand': only submit when wants_frame() says so,
+	// but still at least once per second so the session never goes stale
+	void start(IFrameSubmitter* submitter, const uint32_t rate_hz)
+	{
+		stop();
+
+		mSubmitter = submitter;
+		mOnDemand = rate_hz == 0;
+		mPeriod = std::chrono::nanoseconds(
+			1'000'000'000 / (mOnDemand ? on_demand_check_hz : std::clamp<uint32_t>(rate_hz, 1, 240)));
+		mStop = false;
+
+		mThread = std::thread([this] { submit_loop(); });
+	}
+
+	void stop()
+	{
+		mStop = true;
+		if (mThread.joinable())
+			mThread.join();
+	}
+
+	[[nodiscard]] bool running() const { return mThread.joinable(); }
+
+	[[nodiscard]] uint64_t frames_submitted() const { return mSubmitted.load(std::memory_order_relaxed); }
+	[[nodiscard]] uint64_t frames_failed() const { return mFailed.load(std::memory_order_relaxed); }
+
+private:
+	static constexpr uint32_t on_demand_check_hz = 10;
+
+	void submit_loop()
+	{
+		using clock = std::chrono::steady_clock;
+		auto next = clock::now();
+		auto last_submit = clock::time_point{};
+
+		while (!mStop)
+		{
+			if (!mOnDemand || mSubmitter->wants_frame() ||
+				clock::now() - last_submit >= std::chrono::seconds(1))
+			{
+				if (mSubmitter->submit_frame())
+					mSubmitted.fetch_add(1, std::memory_order_relaxed);
+				else
+					mFailed.fetch_add(1, std::memory_order_relaxed);
+
+				last_submit = clock::now();
+			}
+
+			// Submission may have already waited for vsync, don't double up
+			next += mPeriod;
+			if (const auto now = clock::now(); next < now)
+				next = now;
+			else
+				std::this_thread::sleep_until(next);
+		}
+	}
+
+	IFrameSubmitter* mSubmitter = nullptr;
+	bool mOnDemand = false;
+	std::chrono::nanoseconds mPeriod{11'111'111};
+
+	std::atomic<uint64_t> mSubmitted{0};
+	std::atomic<uint64_t> mFailed{0};
+
+	std::atomic<bool> mStop{false};
+	std::thread mThread;
+};
@@ -0,0 +1,67 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "BenchmarkSetup.h"
+
+// Frame -> joint conversion only: raw K2TrackedJoint::update() per joint against JointBatch,
+// which also normalizes and lines up orientations, so 'batch' isn't expected to be the faster one
+struct ConversionBenchmarkResult
+{
+	uint32_t joints = 0;
+	uint32_t frames = 0;
+
+	double scalarNs = 0.0;
+	double batchNs = 0.0;
+};
+
+// Conversion alone for 2, 8 and 32 joints, over a set of recorded frames so
+// neither side gets to see the same numbers over and over
+inline std::vector<ConversionBenchmarkResult> benchmark_conversion(const BenchmarkSetup& setup)
+{
+	using clock = std::chrono::steady_clock;
+	std::vector<ConversionBenchmarkResult> results;
+	if (!setup.convert_scalar || !setup.convert_batch) return results;
+
+	for (const uint32_t joints : {2u, 8u, 32u})
+	{
+		const std::unique_ptr<IPoseSource> source = setup.make_source(joints - 2);
+
+		std::vector<JointFrame> recorded(64);
+		for (JointFrame& frame : recorded)
+			acquire_frame(*source, frame, setup.prediction, first_object_slots(joints - 2));
+
+		const auto time = [&](const std::function<void(const JointFrame&)>& convert)
+		{
+			for (const JointFrame& frame : recorded) convert(frame); // Warm up
+
+			const auto start = clock::now();
+			for (uint32_t i = 0; i < setup.frames; i++)
+				convert(recorded[i % recorded.size()]);
+
+			return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+				clock::now() - start).count()) / setup.frames;
+		};
+
+		ConversionBenchmarkResult& result = results.emplace_back();
+		result.joints = joints;
+		result.frames = setup.frames;
+		result.scalarNs = time(setup.convert_scalar);
+		result.batchNs = time(setup.convert_batch);
+	}
+	return results;
+}
+
+inline std::string to_json(const ConversionBenchmarkResult& result)
+{
+	char json[256];
+	std::snprintf(json, sizeof(json),
+	              "{\"joints\": %u, \"frames\": %u, \"scalar_ns\": %.1f, \"batch_ns\": %.1f}",
+	              result.joints, result.frames, result.scalarNs, result.batchNs);
+	return json;
+}
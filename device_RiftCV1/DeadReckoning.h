@@ -0,0 +1,217 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+
+#include <Eigen/Geometry>
+
+#include "JointFrame.h"
+
+// Keeps joints moving through short tracking losses, then lets go of them
+// A device that loses position tracking (status flags) is extrapolated from its last
+// good sample with exponentially damped velocity/acceleration and reported as inferred
+// (orientation tracked, position not). After 'budget' seconds it's reported lost and
+// holds still. When tracking comes back the gap between where we had it and where it
+// really is shrinks to nothing over 'blendSeconds' instead of snapping
+// Works on frames in place, host thread only
+class DeadReckoning
+{
+public:
+	struct Settings
+	{
+		double budget = 0.25; // s of extrapolation before a joint counts as lost, 0 = off
+		double damping = 0.1; // s, time constant velocity/acceleration die away with
+		double blendSeconds = 0.15; // s to ease back onto the tracked pose
+		double blendWithin = 1.0; // s, losses longer than this snap back instead
+	};
+
+	enum Phase
+	{
+		Phase_Tracked,
+		Phase_Reckoning, // Extrapolating, reported inferred
+		Phase_Lost, // Past the budget, reported not tracked
+		Phase_Blending // Tracked again, easing onto it
+	};
+
+	struct Stats
+	{
+		uint64_t losses = 0;
+		uint64_t expired = 0; // Ran out of budget
+		uint64_t blended = 0; // Came back and eased onto it
+	};
+
+	Settings settings;
+
+	DeadReckoning() { reset(); }
+
+	void reset()
+	{
+		for (Lane& lane : mLanes)
+			lane = {};
+		mStats = {};
+	}
+
+	[[nodiscard]] Phase phase(const int lane) const { return mLanes[lane].phase; }
+	[[nodiscard]] const Stats& stats() const { return mStats; }
+
+	// Replaces lost joints' samples with extrapolated (or held) ones, blends the rest
+	void apply(JointFrame& frame)
+	{
+		uint64_t objects = frame.objectMask;
+		for (uint32_t i = 0; i < frame.jointCount; i++)
+		{
+			int device = static_cast<int>(i);
+			if (i >= 2)
+			{
+				if (objects == 0) break;
+				device = 2 + std::countr_zero(objects);
+				objects &= objects - 1;
+			}
+
+			Lane& lane = mLanes[device];
+			JointSample& sample = frame.joints[i];
+
+			if ((sample.statusFlags & tracked) == tracked)
+				track(lane, sample, frame.frameTime);
+			else if (settings.budget > 0.0 && lane.known)
+				reckon(lane, sample, frame.frameTime);
+		}
+	}
+
+private:
+	static constexpr uint32_t tracked = status_orientation_tracked | status_position_tracked;
+
+	struct Lane
+	{
+		Phase phase = Phase_Tracked;
+		bool known = false; // Had a good sample since the last reset
+
+		JointSample last; // Last good sample, as it went out
+		double lastTime = 0.0; // Frame time of it
+		JointSample held; // Last sample that went out, good or not
+
+		double blendStart = 0.0;
+		Eigen::Vector3f positionOffset = Eigen::Vector3f::Zero(); // Held - tracked, when it came back
+		Eigen::Quaternionf orientationOffset = Eigen::Quaternionf::Identity();
+	};
+
+	void track(Lane& lane, JointSample& sample, const double time)
+	{
+		// Back from a loss: remember how far off we were, unless it's been too long
+		if (lane.phase == Phase_Reckoning || lane.phase == Phase_Lost)
+		{
+			if (time - lane.lastTime <= settings.blendWithin)
+			{
+				lane.positionOffset = position(lane.held) - position(sample);
+				lane.orientationOffset = (orientation(lane.held) * orientation(sample).conjugate()).normalized();
+				lane.blendStart = time;
+				lane.phase = Phase_Blending;
+				mStats.blended++;
+			}
+			else
+				lane.phase = Phase_Tracked;
+		}
+
+		if (lane.phase == Phase_Blending)
+		{
+			// Smoothstep from the whole offset to none
+			const double t = std::clamp((time - lane.blendStart) / std::max(settings.blendSeconds, 1e-6), 0.0, 1.0);
+			const auto weight = static_cast<float>(1.0 - t * t * (3.0 - 2.0 * t));
+
+			if (weight <= 0.f)
+				lane.phase = Phase_Tracked;
+			else
+			{
+				position(sample) += lane.positionOffset * weight;
+				orientation(sample) = (Eigen::Quaternionf::Identity().slerp(weight, lane.orientationOffset) *
+					orientation(sample)).normalized();
+			}
+		}
+
+		lane.known = true;
+		lane.last = sample;
+		lane.lastTime = time;
+		lane.held = sample;
+	}
+
+	void reckon(Lane& lane, JointSample& sample, const double time)
+	{
+		if (lane.phase == Phase_Tracked || lane.phase == Phase_Blending)
+		{
+			lane.phase = Phase_Reckoning;
+			mStats.losses++;
+		}
+
+		const double elapsed = std::max(time - lane.lastTime, 0.0);
+		if (elapsed > settings.budget)
+		{
+			if (lane.phase != Phase_Lost)
+			{
+				lane.phase = Phase_Lost;
+				mStats.expired++;
+			}
+
+			// Holds the last extrapolated pose, same sample time so only the state changes
+			sample = lane.held;
+			sample.statusFlags = 0;
+			return;
+		}
+
+		const JointSample& last = lane.last;
+		const bool orientation_tracked = sample.statusFlags & status_orientation_tracked;
+		const Eigen::Quaternionf live_orientation = orientation(sample); // Touch IMU, still good
+		sample = last;
+
+		// v(s) = (v0 + a0 s) e^(-s/T), integrated from 0 to t
+		const double T = std::max(settings.damping, 1e-6);
+		const double decay = std::exp(-elapsed / T);
+		const auto moved_v = static_cast<float>(T * (1.0 - decay));
+		const auto moved_a = static_cast<float>(T * T * (1.0 - decay) - T * elapsed * decay);
+
+		const Eigen::Vector3f v0 = Eigen::Map<const Eigen::Vector3f>(last.linearVelocity);
+		const Eigen::Vector3f a0 = Eigen::Map<const Eigen::Vector3f>(last.linearAcceleration);
+		position(sample) = position(last) + v0 * moved_v + a0 * moved_a;
+		Eigen::Map<Eigen::Vector3f>(sample.linearVelocity) = (v0 + a0 * static_cast<float>(elapsed)) *
+			static_cast<float>(decay);
+		Eigen::Map<Eigen::Vector3f>(sample.linearAcceleration) = a0 * static_cast<float>(decay);
+
+		// Orientation: whatever the IMU says if it's still there, otherwise the damped spin
+		const Eigen::Vector3f w0 = Eigen::Map<const Eigen::Vector3f>(last.angularVelocity);
+		if (orientation_tracked)
+			orientation(sample) = live_orientation;
+		else if (const float angle = w0.norm() * moved_v; angle > 1e-9f)
+			orientation(sample) = (Eigen::Quaternionf(Eigen::AngleAxisf(angle, w0.normalized())) *
+				orientation(last)).normalized();
+		Eigen::Map<Eigen::Vector3f>(sample.angularVelocity) = w0 * static_cast<float>(decay);
+
+		sample.sampleTime = last.sampleTime + elapsed;
+		sample.statusFlags = status_orientation_tracked; // Inferred
+		lane.held = sample;
+	}
+
+	static Eigen::Map<Eigen::Vector3f> position(JointSample& sample)
+	{
+		return Eigen::Map<Eigen::Vector3f>(sample.position);
+	}
+
+	static Eigen::Map<const Eigen::Vector3f> position(const JointSample& sample)
+	{
+		return Eigen::Map<const Eigen::Vector3f>(sample.position);
+	}
+
+	// x, y, z, w like LibOVR, which is how Eigen stores them too
+	static Eigen::Map<Eigen::Quaternionf> orientation(JointSample& sample)
+	{
+		return Eigen::Map<Eigen::Quaternionf>(sample.orientation);
+	}
+
+	static Eigen::Map<const Eigen::Quaternionf> orientation(const JointSample& sample)
+	{
+		return Eigen::Map<const Eigen::Quaternionf>(sample.orientation);
+	}
+
+	std::array<Lane, max_frame_joints> mLanes;
+	Stats mStats;
+};
@@ -3,11 +3,39 @@
 
 #include <iostream>
 #include <chrono>
+#include <cstring>
 #include <ppl.h>
 #include <thread>
+#include <crtdbg.h>
 #include <winreg.h>
 
 #include "Win32_DirectXAppUtil.h"
+#include "TrackingPoller.h"
+#include "CompositorKeepAlive.h"
+#include "KeepAliveTargets.h"
+#include "PoseFilterBank.h"
+#include "PoseHistory.h"
+#include "PoseExtrapolator.h"
+#include "PredictionTuner.h"
+#include "PoseRecording.h"
+#include "LatencyStats.h"
+#include "PoseSource.h"
+#include "SimulatedPoseSource.h"
+#include "IngestBenchmark.h"
+#include "LoadBenchmark.h"
+#include "ConversionBenchmark.h"
+#include "RecoveryBenchmark.h"
+#include "StreamBenchmark.h"
+#include "ReckoningBenchmark.h"
+#include "ExtrapolationBenchmark.h"
+#include "AsyncLogSink.h"
+#include "CommandWorker.h"
+#include "InitSequence.h"
+#include "SessionWatchdog.h"
+#include "PoseExport.h"
+#include "PoseStream.h"
+#include "TrackingQuality.h"
+#include "DeadReckoning.h"
 #include <OVR_CAPI_D3D.h>
 
 
@@ -15,26 +43,67 @@
 
 DirectX11 DIRECTX;
 
-class GuardianSystem
+// Per-stage timings, see report_counters()
+LatencyStats latency;
+
+// Every applied frame, for local tools (see SharedPoses.h)
+PoseExport pose_export;
+
+// Same frames over UDP, see DeviceHandler::sync_stream()
+PoseStreamSender pose_stream;
+
+// Jitter/dropouts/gaps per device, from the raw frames; shown in report_counters()
+TrackingQuality tracking_quality;
+
+// Anything that may log every frame goes through here, never straight to the host
+AsyncLogSink log_sink;
+LogSite submit_failed_log{L"ovr_SubmitFrame failed", Log_Error};
+LogSite device_poses_failed_log{L"CV1 Device: ovr_GetDevicePoses failed", Log_Warning};
+LogSite session_recreate_failed_log{L"CV1 Device: Recreating the session failed, retrying", Log_Warning};
+
+// Failed SDK calls since the watchdog last looked, from any thread
+std::atomic<uint32_t> sdk_errors = 0;
+
+class GuardianSystem : public IFrameSubmitter, public IKeepAliveGraphics
 {
 public:
 	GuardianSystem(DeviceHandler* _this) :
+		mHeadless(_this->headless_keep_alive),
 		logInfoMessage(_this->logInfoMessage),
 		logWarningMessage(_this->logWarningMessage),
-		logErrorMessage(_this->logErrorMessage),
-		m_result(_this->m_result)
+		logErrorMessage(_this->logErrorMessage)
 	{
 	}
 
-	void start_ovr();
-	void InitRenderTargets(const ovrHmdDesc& hmdDesc);
+	// Start-up stages, see DeviceHandler::initialize()
+	// The window and everything after it have to run on the same thread
+	bool start_runtime();
+	bool start_window();
+	bool start_device();
+	bool start_targets();
+	void stop_ovr();
+
+	// New session on the same runtime, device and window, see SessionWatchdog
+	bool restart_session();
+
+	bool InitRenderTargets(const ovrHmdDesc& hmdDesc);
+	void ReleaseRenderTargets();
 
 	void Render();
 
-	uint32_t vrObjects;
+	bool submit_frame() override;
+	bool wants_frame() override;
+
+	int create_color_chain(int eye, int width, int height) override;
+	bool create_depth_target(int eye, int width, int height) override;
+
 	ovrSession mSession = nullptr;
 
 private:
+	bool mRuntimeStarted = false;
+	ovrGraphicsLuid mLuid = {};
+	ovrHmdDesc mHmdDesc = {};
+
 	uint32_t mFrameIndex = 0; // Global frame counter
 	ovrPosef mHmdToEyePose[ovrEye_Count] = {}; // Offset from the center of the HMD to each eye
 	ovrRecti mEyeRenderViewport[ovrEye_Count] = {}; // Eye render target viewport
@@ -44,35 +113,48 @@ private:
 	ID3D11DepthStencilView* mEyeDepthTarget[ovrEye_Count] = {}; // DX11 - Eye depth view
 	std::vector<ID3D11RenderTargetView*> mEyeRenderTargets[ovrEye_Count]; // DX11 - Eye render view
 
+	bool mHeadless = false; // Smallest possible targets, no depth, no clears
+	KeepAliveTargets mTargets;
+
 	bool mShouldQuit = false;
+	ovrResult mLastSubmitResult = ovrSuccess;
 
 	// From parent for logging
 	std::function<void(std::wstring)>& logInfoMessage;
 	std::function<void(std::wstring)>& logWarningMessage;
 	std::function<void(std::wstring)>& logErrorMessage;
-
-	HRESULT& m_result;
 };
 
-void GuardianSystem::InitRenderTargets(const ovrHmdDesc& hmdDesc)
+bool GuardianSystem::InitRenderTargets(const ovrHmdDesc& hmdDesc)
 {
+	int idealSizes[ovrEye_Count][2] = {};
+
 	// For each eye
 	for (int i = 0; i < ovrEye_Count; ++i)
 	{
-		// Viewport
 		const ovrSizei idealSize = ovr_GetFovTextureSize(
 			mSession, static_cast<ovrEyeType>(i),
 			hmdDesc.DefaultEyeFov[i], 1.0f);
 
-		mEyeRenderViewport[i] = {
-			0, 0, idealSize.w, idealSize.h
-		};
+		idealSizes[i][0] = idealSize.w;
+		idealSizes[i][1] = idealSize.h;
+	}
+
+	if (!mTargets.create(*this, idealSizes, mHeadless))
+	{
+		logErrorMessage(L"Creating keep-alive render targets failed");
+		return false;
+	}
+
+	logInfoMessage(std::format(L"Keep-alive render targets{}: {} KiB",
+	                           mHeadless ? L" (headless)" : L"",
+	                           mTargets.allocated_bytes() / 1024));
 
-		// Create Swap Chain
-		ovrTextureSwapChainDesc desc = {
-			ovrTexture_2D, OVR_FORMAT_R8G8B8A8_UNORM_SRGB, 1,
-			idealSize.w, idealSize.h, 1, 1,
-			ovrFalse, ovrTextureMisc_DX_Typeless, ovrTextureBind_DX_RenderTarget
+	for (int i = 0; i < ovrEye_Count; ++i)
+	{
+		// Viewport
+		mEyeRenderViewport[i] = {
+			0, 0, mTargets.eye(i).width, mTargets.eye(i).height
 		};
 
 		// Configure Eye render layers
@@ -82,46 +164,92 @@ void GuardianSystem::InitRenderTargets(const ovrHmdDesc& hmdDesc)
 		mHmdToEyePose[i] = ovr_GetRenderDesc(
 			mSession, static_cast<ovrEyeType>(i),
 			hmdDesc.DefaultEyeFov[i]).HmdToEyePose;
+	}
+	return true;
+}
 
-		// DirectX 11 - Generate RenderTargetView from textures in swap chain
-		// ----------------------------------------------------------------------
-		ovrResult result = ovr_CreateTextureSwapChainDX(
-			mSession, DIRECTX.Device, &desc, &mTextureChain[i]);
+// Everything InitRenderTargets made, before the session they belong to goes
+void GuardianSystem::ReleaseRenderTargets()
+{
+	for (int i = 0; i < ovrEye_Count; ++i)
+	{
+		for (ID3D11RenderTargetView* renderTargetView : mEyeRenderTargets[i])
+			if (renderTargetView) renderTargetView->Release();
+		mEyeRenderTargets[i].clear();
 
-		if (!OVR_SUCCESS(result))
-			logErrorMessage(L"ovr_CreateTextureSwapChainDX failed");
+		if (mEyeDepthTarget[i]) mEyeDepthTarget[i]->Release();
+		mEyeDepthTarget[i] = nullptr;
 
-		// Render Target, normally triple-buffered
-		int textureCount = 0;
-		ovr_GetTextureSwapChainLength(mSession, mTextureChain[i], &textureCount);
-		for (int j = 0; j < textureCount; ++j)
-		{
-			ID3D11Texture2D* renderTexture = nullptr;
-			ovr_GetTextureSwapChainBufferDX(mSession, mTextureChain[i], j, IID_PPV_ARGS(&renderTexture));
+		if (mTextureChain[i]) ovr_DestroyTextureSwapChain(mSession, mTextureChain[i]);
+		mTextureChain[i] = nullptr;
+	}
+	mEyeRenderLayer = {};
+}
 
-			D3D11_RENDER_TARGET_VIEW_DESC renderTargetViewDesc = {
-				DXGI_FORMAT_R8G8B8A8_UNORM, D3D11_RTV_DIMENSION_TEXTURE2D
-			};
+int GuardianSystem::create_color_chain(const int eye, const int width, const int height)
+{
+	// Create Swap Chain
+	ovrTextureSwapChainDesc desc = {
+		ovrTexture_2D, OVR_FORMAT_R8G8B8A8_UNORM_SRGB, 1,
+		width, height, 1, 1,
+		ovrFalse, ovrTextureMisc_DX_Typeless, ovrTextureBind_DX_RenderTarget
+	};
+
+	// DirectX 11 - Generate RenderTargetView from textures in swap chain
+	// ----------------------------------------------------------------------
+	ovrResult result = ovr_CreateTextureSwapChainDX(
+		mSession, DIRECTX.Device, &desc, &mTextureChain[eye]);
 
-			ID3D11RenderTargetView* renderTargetView = nullptr;
-			DIRECTX.Device->CreateRenderTargetView(renderTexture,
-			                                       &renderTargetViewDesc, &renderTargetView);
-			mEyeRenderTargets[i].push_back(renderTargetView);
-			renderTexture->Release();
-		}
+	if (!OVR_SUCCESS(result))
+	{
+		logErrorMessage(L"ovr_CreateTextureSwapChainDX failed");
+		return 0;
+	}
 
-		// DirectX 11 - Generate Depth
-		// ----------------------------------------------------------------------
-		D3D11_TEXTURE2D_DESC depthTextureDesc = {
-			(UINT)idealSize.w, (UINT)idealSize.h, 1, 1, DXGI_FORMAT_D32_FLOAT, {1, 0},
-			D3D11_USAGE_DEFAULT, D3D11_BIND_DEPTH_STENCIL, 0, 0
+	// Render Target, normally triple-buffered
+	int textureCount = 0;
+	ovr_GetTextureSwapChainLength(mSession, mTextureChain[eye], &textureCount);
+
+	// Headless targets are never cleared, so they don't need views either
+	if (mHeadless)
+		return textureCount;
+
+	for (int j = 0; j < textureCount; ++j)
+	{
+		ID3D11Texture2D* renderTexture = nullptr;
+		ovr_GetTextureSwapChainBufferDX(mSession, mTextureChain[eye], j, IID_PPV_ARGS(&renderTexture));
+
+		D3D11_RENDER_TARGET_VIEW_DESC renderTargetViewDesc = {
+			DXGI_FORMAT_R8G8B8A8_UNORM, D3D11_RTV_DIMENSION_TEXTURE2D
 		};
 
-		ID3D11Texture2D* depthTexture = nullptr;
-		DIRECTX.Device->CreateTexture2D(&depthTextureDesc, NULL, &depthTexture);
-		DIRECTX.Device->CreateDepthStencilView(depthTexture, NULL, &mEyeDepthTarget[i]);
-		depthTexture->Release();
+		ID3D11RenderTargetView* renderTargetView = nullptr;
+		DIRECTX.Device->CreateRenderTargetView(renderTexture,
+		                                       &renderTargetViewDesc, &renderTargetView);
+		mEyeRenderTargets[eye].push_back(renderTargetView);
+		renderTexture->Release();
 	}
+
+	return textureCount;
+}
+
+bool GuardianSystem::create_depth_target(const int eye, const int width, const int height)
+{
+	// DirectX 11 - Generate Depth
+	// ----------------------------------------------------------------------
+	D3D11_TEXTURE2D_DESC depthTextureDesc = {
+		(UINT)width, (UINT)height, 1, 1, DXGI_FORMAT_D32_FLOAT, {1, 0},
+		D3D11_USAGE_DEFAULT, D3D11_BIND_DEPTH_STENCIL, 0, 0
+	};
+
+	ID3D11Texture2D* depthTexture = nullptr;
+	if (FAILED(DIRECTX.Device->CreateTexture2D(&depthTextureDesc, NULL, &depthTexture)))
+		return false;
+
+	const HRESULT result = DIRECTX.Device->CreateDepthStencilView(depthTexture, NULL, &mEyeDepthTarget[eye]);
+	depthTexture->Release();
+
+	return SUCCEEDED(result);
 }
 
 void GuardianSystem::Render()
@@ -134,18 +262,21 @@ void GuardianSystem::Render()
 	// Render each eye
 	for (int i = 0; i < ovrEye_Count; ++i)
 	{
-		int renderTargetIndex = 0;
-		ovr_GetTextureSwapChainCurrentIndex(mSession, mTextureChain[i], &renderTargetIndex);
-		ID3D11RenderTargetView* renderTargetView = mEyeRenderTargets[i][renderTargetIndex];
-		ID3D11DepthStencilView* depthTargetView = mEyeDepthTarget[i];
-
-		// Clear and set render/depth target and viewport
-		DIRECTX.SetAndClearRenderTarget(renderTargetView, depthTargetView, 0.0f, 0.0f, 0.0f, 1.0f);
-		// THE SCREEN RENDER COLOUR
-		DIRECTX.SetViewport(static_cast<float>(mEyeRenderViewport[i].Pos.x),
-		                    static_cast<float>(mEyeRenderViewport[i].Pos.y),
-		                    static_cast<float>(mEyeRenderViewport[i].Size.w),
-		                    static_cast<float>(mEyeRenderViewport[i].Size.h));
+		if (mTargets.needs_clear())
+		{
+			int renderTargetIndex = 0;
+			ovr_GetTextureSwapChainCurrentIndex(mSession, mTextureChain[i], &renderTargetIndex);
+			ID3D11RenderTargetView* renderTargetView = mEyeRenderTargets[i][renderTargetIndex];
+			ID3D11DepthStencilView* depthTargetView = mEyeDepthTarget[i];
+
+			// Clear and set render/depth target and viewport
+			DIRECTX.SetAndClearRenderTarget(renderTargetView, depthTargetView, 0.0f, 0.0f, 0.0f, 1.0f);
+			// THE SCREEN RENDER COLOUR
+			DIRECTX.SetViewport(static_cast<float>(mEyeRenderViewport[i].Pos.x),
+			                    static_cast<float>(mEyeRenderViewport[i].Pos.y),
+			                    static_cast<float>(mEyeRenderViewport[i].Size.w),
+			                    static_cast<float>(mEyeRenderViewport[i].Size.h));
+		}
 
 		// Render and commit to swap chain
 		ovr_CommitTextureSwapChain(mSession, mTextureChain[i]);
@@ -159,126 +290,319 @@ void GuardianSystem::Render()
 	// Submit frames
 	ovrLayerHeader* layers = &mEyeRenderLayer.Header;
 	ovrResult result = ovr_SubmitFrame(mSession, mFrameIndex++, nullptr, &layers, 1);
+	mLastSubmitResult = result;
 
 	if (!OVR_SUCCESS(result))
-		logErrorMessage(L"ovr_SubmitFrame failed");
+	{
+		log_sink.log(submit_failed_log, L"error %d", result);
+		sdk_errors.fetch_add(1, std::memory_order_relaxed);
+	}
 }
 
-void GuardianSystem::start_ovr()
+bool GuardianSystem::submit_frame()
 {
-	__try
+	const auto submit_start = LatencyStats::clock::now();
+	Render();
+	latency.record(Stage_Submit, submit_start, LatencyStats::clock::now());
+
+	return OVR_SUCCESS(mLastSubmitResult);
+}
+
+bool GuardianSystem::wants_frame()
+{
+	ovrSessionStatus status = {};
+	if (!OVR_SUCCESS(ovr_GetSessionStatus(mSession, &status)))
+		return true;
+
+	// Once we're hidden, the compositor wants frames again
+	return !status.IsVisible;
+}
+
+bool GuardianSystem::start_runtime()
+{
+	ovrResult result = ovr_Initialize(nullptr);
+	if (!OVR_SUCCESS(result))
 	{
-		[&, this]
-		{
-			ovrResult result = ovr_Initialize(nullptr);
-			if (!OVR_SUCCESS(result))
-				logErrorMessage(L"ovr_Initialize failed");
+		logErrorMessage(L"ovr_Initialize failed");
+		return false;
+	}
+	mRuntimeStarted = true;
 
-			ovrGraphicsLuid luid;
-			result = ovr_Create(&mSession, &luid);
-			if (!OVR_SUCCESS(result))
-				logErrorMessage(L"ovr_Create failed");
+	result = ovr_Create(&mSession, &mLuid);
+	if (!OVR_SUCCESS(result))
+	{
+		logErrorMessage(L"ovr_Create failed");
+		return false;
+	}
 
-			if (!DIRECTX.InitWindow(nullptr, L"GuardianSystemDemo"))
-				logErrorMessage(L"DIRECTX.InitWindow failed");
+	mHmdDesc = ovr_GetHmdDesc(mSession);
 
-			// Use HMD desc to initialize device
-			ovrHmdDesc hmdDesc = ovr_GetHmdDesc(mSession);
-			if (!DIRECTX.InitDevice(hmdDesc.Resolution.w / 2,
-			                        hmdDesc.Resolution.h / 2,
-			                        reinterpret_cast<LUID*>(&luid)))
-				logErrorMessage(L"DIRECTX.InitDevice failed");
+	// Use FloorLevel tracking origin
+	ovr_SetTrackingOriginType(mSession, ovrTrackingOrigin_FloorLevel);
+	return true;
+}
 
-			// Use FloorLevel tracking origin
-			ovr_SetTrackingOriginType(mSession, ovrTrackingOrigin_FloorLevel);
+bool GuardianSystem::start_window()
+{
+	if (!DIRECTX.InitWindow(nullptr, L"GuardianSystemDemo"))
+	{
+		logErrorMessage(L"DIRECTX.InitWindow failed");
+		return false;
+	}
+	return true;
+}
 
-			InitRenderTargets(hmdDesc);
-			vrObjects = (ovr_GetConnectedControllerTypes(mSession) >> 8) & 0xf;
+bool GuardianSystem::start_device()
+{
+	// Use HMD desc to initialize device
+	if (!DIRECTX.InitDevice(mHmdDesc.Resolution.w / 2,
+	                        mHmdDesc.Resolution.h / 2,
+	                        reinterpret_cast<LUID*>(&mLuid)))
+	{
+		logErrorMessage(L"DIRECTX.InitDevice failed");
+		return false;
+	}
+	return true;
+}
 
-			// Main Loop
-			Render();
-		}();
+bool GuardianSystem::start_targets()
+{
+	if (!InitRenderTargets(mHmdDesc))
+		return false;
+
+	// Main Loop
+	Render();
+	return true;
+}
+
+// Safe after any number of the stages above
+void GuardianSystem::stop_ovr()
+{
+	if (mSession)
+		ReleaseRenderTargets();
+	DIRECTX.ReleaseDevice();
+
+	if (mSession)
+		ovr_Destroy(mSession);
+	mSession = nullptr;
+
+	if (mRuntimeStarted)
+		ovr_Shutdown();
+	mRuntimeStarted = false;
+}
+
+bool GuardianSystem::restart_session()
+{
+	if (mSession)
+	{
+		ReleaseRenderTargets();
+		ovr_Destroy(mSession);
+	}
+	mSession = nullptr;
+
+	ovrGraphicsLuid luid = {};
+	ovrResult result = ovrError_NotInitialized;
+	if (mRuntimeStarted)
+		result = ovr_Create(&mSession, &luid);
+
+	// The service restarted (or reconnecting failed last time): the runtime has to reconnect first
+	if (!mRuntimeStarted || result == ovrError_ServiceConnection || result == ovrError_ServiceError)
+	{
+		if (mRuntimeStarted)
+			ovr_Shutdown();
+
+		mRuntimeStarted = OVR_SUCCESS(ovr_Initialize(nullptr));
+		result = mRuntimeStarted ? ovr_Create(&mSession, &luid) : ovrError_Initialize;
+	}
+
+	if (!OVR_SUCCESS(result))
+	{
+		log_sink.log(session_recreate_failed_log, L"error %d", result);
+		mSession = nullptr;
+		return false;
+	}
+
+	// The D3D device lives on the old adapter, only a Refresh can move it
+	if (std::memcmp(&luid, &mLuid, sizeof(luid)) != 0)
+	{
+		log_sink.log(session_recreate_failed_log, L"the HMD moved to another GPU, Refresh this device");
+		ovr_Destroy(mSession);
+		mSession = nullptr;
+		return false;
+	}
+
+	mHmdDesc = ovr_GetHmdDesc(mSession);
+	ovr_SetTrackingOriginType(mSession, ovrTrackingOrigin_FloorLevel);
+
+	mFrameIndex = 0;
+	mLastSubmitResult = ovrSuccess;
+	return InitRenderTargets(mHmdDesc);
+}
+
+// LibOVR and D3D sometimes fail with SEH exceptions, which can't share
+// a function with C++ unwinding, hence the stage as a callable
+template <class Stage>
+bool seh_guarded(Stage&& stage)
+{
+	__try
+	{
+		return stage();
 	}
 	__except (EXCEPTION_EXECUTE_HANDLER)
 	{
-		[&, this]
-		{
-			logErrorMessage(L"OVR initialization failure!");
-			m_result = E_INIT_FAILURE;
-		}();
+		return false;
 	}
 }
 
 // Funny Variable
 GuardianSystem* instance;
 
-// ODTKRA
-bool is_ODTKRA_started = false;
-bool ODTKRAstop = false;
+// Start-up, runs off the host's thread, see initialize() and poll_initialization()
+InitSequence init_sequence;
+std::mutex init_poll_mutex; // Status and update() can both finish it, only one gets to
+
+// Stands in for LibOVR when 'simulate' is on, picked in initialize()
+SimulatedPoseSource simulated_source;
+bool simulating = false;
+
+// Whichever of the two is in use, see below
+IPoseSource& pose_source();
+
+// VR Objects come and go, a slow background scan keeps track of them
+CommandWorker scan_worker;
+std::atomic<uint64_t> connected_objects = 0;
+
+// Dead sessions get recreated on the scan worker, so scans never overlap with it
+SessionWatchdog session_watchdog;
+bool session_down = false; // Host thread: lost, and we haven't seen it back yet
+
+// Only touched from update(), see sync_object_joints
+uint64_t object_joint_slots = 0; // Slots that have a joint
+ObjectJointMap object_joints;
+
+// Fresh/stale samples per joint, see update_joints
+JointFreshnessList joint_freshness;
+JointBatch joint_batch;
+
+// ODTKRA, every ODT action runs on this one worker so update() never waits on ODT
+CommandWorker odt_worker;
+std::atomic<bool> is_ODTKRA_started = false;
+LogSite odt_missing_log{L"CV1 Device: Oculus Debug Tool didn't start, retrying in 10 s", Log_Warning};
+
+// Only touched from the worker
+CommandWorker::TimerId odt_step = 0; // Next start-up step or the keep-alive poke
+CommandWorker::TimerId odt_release = 0; // The second half of the poke that's under way
+HWND odt_property_grid = nullptr;
+
+// Same cadence as before: poke right away, then every 600000 seconds
+constexpr auto odt_poke_interval = std::chrono::seconds(600000);
+
+// Whatever's pending, so a restart or stop leaves nothing behind
+void cancel_odt_steps()
+{
+	odt_worker.cancel(odt_step);
+	odt_worker.cancel(odt_release);
+	odt_step = odt_release = 0;
+}
 
 void DeviceHandler::keepRiftAlive()
 {
-	int seconds = 600000;
+	odt_worker.post([this] { odt_restart_step(); });
+}
 
-	auto Target_window_Name = L"Oculus Debug Tool";
-	HWND hWindowHandle = FindWindow(nullptr, Target_window_Name);
+// Every step below runs on the ODT worker and schedules the next one into odt_step
+void DeviceHandler::odt_restart_step()
+{
+	cancel_odt_steps();
 
-	if (hWindowHandle != nullptr)
+	// Close ODT if it's already open
+	if (HWND hWindowHandle = FindWindow(nullptr, L"Oculus Debug Tool");
+		hWindowHandle != nullptr)
 	{
 		SendMessage(hWindowHandle, WM_CLOSE, 0, 0);
 		SwitchToThisWindow(hWindowHandle, true);
 	}
 
-	Sleep(500); // not sure if needed
+	odt_step = odt_worker.schedule(std::chrono::milliseconds(500), [this] { odt_launch_step(); }); // not sure if needed
+}
 
+void DeviceHandler::odt_launch_step()
+{
 	//Sends commands to the Oculus Debug Tool CLI to decrease performance overhead
 	//Unlikely to do much, but no reason not to.
 	if (resEnabled)
 		ODT_CLI();
 
 	//Starts Oculus Debug Tool
-	//std::string temp = ODTPath + "OculusDebugTool.exe";
-	//TestOutput->Text(std::wstring(temp.begin(), temp.end()));
+	start_ODT();
+
+	odt_step = odt_worker.schedule(std::chrono::milliseconds(1000), [this] { odt_focus_step(); });
+}
 
-	start_ODT(hWindowHandle, Target_window_Name);
+void DeviceHandler::odt_focus_step()
+{
+	const HWND hWindowHandle = focus_ODT();
+	odt_step = odt_worker.schedule(std::chrono::milliseconds(100), [this, hWindowHandle]
+	{
+		odt_toggle_step(hWindowHandle);
+	});
+}
 
-	Sleep(1000);
+void DeviceHandler::odt_toggle_step(const HWND hWindowHandle)
+{
+	select_proximity_toggle_ODT(hWindowHandle);
+	odt_step = odt_worker.schedule(std::chrono::milliseconds(1000), [this] { odt_check_step(); });
+}
 
+void DeviceHandler::odt_check_step()
+{
 	if (check_ODT() == false)
 	{
-		is_ODTKRA_started = false;
+		log_sink.log(odt_missing_log);
+		odt_step = odt_worker.schedule(std::chrono::seconds(10), [this] { odt_restart_step(); });
 		return;
 	}
 
+	const HWND window = FindWindow(nullptr, L"Oculus Debug Tool");
+	odt_property_grid = FindWindowEx(
+		FindWindowEx(window, nullptr, L"wxWindowNR", nullptr), nullptr, L"wxWindow", nullptr);
 
-	hWindowHandle = FindWindow(nullptr, Target_window_Name);
+	odt_step = odt_worker.schedule(std::chrono::milliseconds(0), [] { odt_poke_step(); },
+	                               std::chrono::duration_cast<std::chrono::milliseconds>(odt_poke_interval));
+}
 
-	HWND PropertGrid = FindWindowEx(hWindowHandle, nullptr, L"wxWindowNR", nullptr);
-	HWND wxWindow = FindWindowEx(PropertGrid, nullptr, L"wxWindow", nullptr);
+// Up now, down 50 ms later
+void DeviceHandler::odt_poke_step()
+{
+	SendMessage(odt_property_grid, WM_KEYDOWN, VK_UP, 0);
+	SendMessage(odt_property_grid, WM_KEYUP, VK_UP, 0);
 
-	while (!ODTKRAstop)
+	odt_release = odt_worker.schedule(std::chrono::milliseconds(50), []
 	{
-		if (seconds == 600000)
-		{
-			SendMessage(wxWindow, WM_KEYDOWN, VK_UP, 0);
-			SendMessage(wxWindow, WM_KEYUP, VK_UP, 0);
-			Sleep(50);
-			SendMessage(wxWindow, WM_KEYDOWN, VK_DOWN, 0);
-			SendMessage(wxWindow, WM_KEYUP, VK_DOWN, 0);
-			seconds = 0;
-		}
+		odt_release = 0;
+		SendMessage(odt_property_grid, WM_KEYDOWN, VK_DOWN, 0);
+		SendMessage(odt_property_grid, WM_KEYUP, VK_DOWN, 0);
+	});
+}
 
-		seconds++;
-		Sleep(1000);
-	}
-	ODTKRAstop = false;
+void DeviceHandler::stop_keep_rift_alive()
+{
+	odt_worker.post([this]
+	{
+		// Whatever step is next never happens
+		cancel_odt_steps();
+		odt_property_grid = nullptr;
+
+		killODT(0);
+	});
 }
 
 // Regular Amethyst stuff
-std::thread ODTKRAThread;
 
 HRESULT DeviceHandler::getStatusResult()
 {
+	poll_initialization();
+
 	// Enable/disable settings
 	Flags_SettingsSupported = m_result == S_OK;
 
@@ -297,6 +621,8 @@ std::wstring DeviceHandler::statusResultWString(HRESULT stat)
 			L"Not started yet!\nE_NOT_STARTED\nClick 'Refresh' to initialize this device!";
 	case E_INIT_FAILURE: return
 			L"Init failure!\nE_INIT_FAILURE\nCheck if your Oculus HMD is connected and dash is started properly!";
+	case E_INITIALIZING: return
+			L"Initializing...\nE_INITIALIZING\nStarting up: " + init_sequence.running_stages();
 	default: return L"Undefined: " + std::to_wstring(stat) +
 			L"\nE_UNDEFINED\nSomething weird has happened, though we can't tell what.";
 	}
@@ -304,58 +630,1101 @@ std::wstring DeviceHandler::statusResultWString(HRESULT stat)
 
 void DeviceHandler::initialize()
 {
-	// Find out the size of the buffer required to store the value
-	DWORD dwBufSize = 0;
-	LONG lRetVal = RegGetValue(
-		HKEY_LOCAL_MACHINE,
-		L"SOFTWARE\\WOW6432Node\\Oculus VR, LLC\\Oculus",
-		L"Base",
-		RRF_RT_ANY,
-		nullptr,
-		nullptr,
-		&dwBufSize);
-
-	if (ERROR_SUCCESS != lRetVal ||
-		dwBufSize <= 0)
-		logErrorMessage(L"ODT could not be found! Some things may refuse to work!");
-
-	// If we're ok
-	else
-	{
-		std::wstring data;
-		data.resize(dwBufSize / sizeof(wchar_t));
+	// Whatever a previous start-up left behind
+	init_sequence.clear();
 
-		RegGetValue(HKEY_LOCAL_MACHINE, L"SOFTWARE\\WOW6432Node\\Oculus VR, LLC\\Oculus",
-		            L"Base", RRF_RT_ANY, nullptr, &data[0], &dwBufSize);
-
-		ODTPath = data + L"Support\\oculus-diagnostics\\";
-	}
+	// Hot-path messages, rate-limited and handed to the host from a background thread
+	log_sink.start(logInfoMessage, logWarningMessage, logErrorMessage);
+	odt_worker.start();
 
 	instance = new(_aligned_malloc(sizeof(GuardianSystem), 16)) GuardianSystem(this);
 
-	// Assume success
-	m_result = S_OK;
+	// For dashboards, see LatencyCountersHeader
+	latency.reset();
+	if (!latency.open_export(ktvr::GetK2AppDataLogFileDir(L"RiftCV1", L"latency.cv1stats")))
+		logWarningMessage(L"CV1 Device: Couldn't create the latency counters file");
 
-	// Setup Oculus Stuff
-	instance->start_ovr();
+	if (!pose_export.open(shared_poses_name, GetCurrentProcessId()))
+		logWarningMessage(L"CV1 Device: Couldn't create the shared pose export");
 
 	// Always should keep >0 joints at init so replace the 1st one
+	trackedJoints.resize(1);
 	trackedJoints[0] = ktvr::K2TrackedJoint(L"Left Touch Controller");
 	trackedJoints.push_back(ktvr::K2TrackedJoint(L"Right Touch Controller"));
 
-	for (int i = 0; i < instance->vrObjects; i++)
-		trackedJoints.push_back(ktvr::K2TrackedJoint(L"VR Object " + std::to_wstring(i + 1)));
+	object_joints.fill(-1);
+	object_joint_slots = 0;
+	joint_freshness = {};
+	joint_batch.reset();
+	connected_objects = 0;
+	session_watchdog.reset();
+	session_down = false;
+
+	// Everything slow happens in stages off this thread, independent ones side by side
+	init_sequence.add(L"ODT lookup", [this]
+	{
+		// Find out the size of the buffer required to store the value
+		DWORD dwBufSize = 0;
+		LONG lRetVal = RegGetValue(
+			HKEY_LOCAL_MACHINE,
+			L"SOFTWARE\\WOW6432Node\\Oculus VR, LLC\\Oculus",
+			L"Base",
+			RRF_RT_ANY,
+			nullptr,
+			nullptr,
+			&dwBufSize);
+
+		if (ERROR_SUCCESS != lRetVal ||
+			dwBufSize <= 0)
+			logErrorMessage(L"ODT could not be found! Some things may refuse to work!");
+
+		// If we're ok
+		else
+		{
+			std::wstring data;
+			data.resize(dwBufSize / sizeof(wchar_t));
+
+			RegGetValue(HKEY_LOCAL_MACHINE, L"SOFTWARE\\WOW6432Node\\Oculus VR, LLC\\Oculus",
+			            L"Base", RRF_RT_ANY, nullptr, &data[0], &dwBufSize);
+
+			ODTPath = data + L"Support\\oculus-diagnostics\\";
+		}
+		return true; // Only ODTKRA needs it
+	});
+
+	// Setup Oculus Stuff, or the simulated headset instead
+	simulating = simulate;
+	if (simulating)
+	{
+		init_sequence.add(L"simulator", [this]
+		{
+			SimulationSettings settings;
+			settings.objects = static_cast<uint32_t>(
+				std::clamp(simulated_objects, 0, static_cast<int>(max_frame_joints) - 2));
+			simulated_source.set_settings(settings);
+			connected_objects = pose_source().connected_objects();
+
+			logInfoMessage(std::format(L"CV1 Device: Simulating 2 Touch controllers and {} VR Objects",
+			                           settings.objects));
+			return true;
+		});
+	}
+	else
+	{
+		// The window is bound to the thread that made it, so it and everything on
+		// the D3D device stays on the sequence's own thread (pinned)
+		const auto runtime = init_sequence.add(L"runtime", []
+		{
+			return seh_guarded([] { return instance->start_runtime(); });
+		});
+		const auto window = init_sequence.add(L"window", []
+		{
+			return seh_guarded([] { return instance->start_window(); });
+		}, {}, true);
+		const auto device = init_sequence.add(L"device", []
+		{
+			return seh_guarded([] { return instance->start_device(); });
+		}, {runtime, window}, true);
+
+		init_sequence.add(L"render targets", []
+		{
+			return seh_guarded([] { return instance->start_targets(); });
+		}, {device}, true);
+		init_sequence.add(L"VR Objects", []
+		{
+			connected_objects = pose_source().connected_objects();
+			return true;
+		}, {runtime});
+	}
+
+	// Nobody else pumps the keep-alive window's messages
+	init_sequence.idle = [] { DIRECTX.HandleMessages(); };
+
+	m_result = E_INITIALIZING;
+	init_sequence.start();
 
 	// Mark the device as initialized
 	initialized = true;
 }
 
+// Follows the start-up, and once it's done finishes it here (joints aren't thread-safe)
+void DeviceHandler::poll_initialization()
+{
+	std::lock_guard lock(init_poll_mutex);
+	if (m_result != E_INITIALIZING) return;
+
+	const InitSequence::State state = init_sequence.state();
+	if (state == InitSequence::Init_Running)
+	{
+		show_init_progress(true, init_sequence.progress(), init_sequence.running_stages());
+		return;
+	}
+
+	// How long everything took, stages that ran side by side overlap
+	std::wstring stages;
+	for (const InitSequence::StageTiming& stage : init_sequence.timings())
+		stages += std::format(L"{}{} {:.0f} ms{}", stages.empty() ? L"" : L", ",
+		                      stage.name, stage.milliseconds, stage.succeeded ? L"" : L" (failed)");
+	logInfoMessage(std::format(L"CV1 Device: Start-up took {:.0f} ms ({})",
+	                           init_sequence.total_milliseconds(), stages));
+
+	switch (state)
+	{
+	case InitSequence::Init_Succeeded:
+		sync_object_joints(connected_objects);
+
+		// Anything switched on later shows up within a second, no Refresh needed
+		scan_worker.start();
+		// (not while the session's down, it'd look like everything was switched off)
+		scan_worker.schedule(std::chrono::seconds(1), []
+		{
+			if (session_watchdog.health() == SessionWatchdog::Session_Healthy)
+				connected_objects = pose_source().connected_objects();
+		}, std::chrono::seconds(1));
+
+		m_result = S_OK;
+		break;
+
+	case InitSequence::Init_Failed:
+		logErrorMessage(L"CV1 Device Error: Start-up failed at: " + init_sequence.failed_stages());
+		m_result = E_INIT_FAILURE;
+		break;
+
+	default:
+		logInfoMessage(L"CV1 Device: Start-up cancelled");
+		m_result = E_NOT_STARTED;
+		break;
+	}
+
+	show_init_progress(false, 100, L"");
+}
+
+// Only stops what hasn't started yet, see InitSequence::cancel()
+void DeviceHandler::cancel_initialization()
+{
+	init_sequence.cancel();
+}
+
+void DeviceHandler::show_init_progress(const bool visible, const int progress, const std::wstring& stages)
+{
+	// Nothing to show until the settings page was loaded
+	if (!init_status) return;
+
+	init_ring->Visibility(visible);
+	init_progress->Visibility(visible);
+	init_cancel->Visibility(visible);
+	init_status->Visibility(visible);
+
+	init_progress->Progress(progress);
+	init_status->Text(L"Starting up: " + stages);
+}
+
 unsigned int frame = 0;
 
+// Compositor keep-alive
+CompositorKeepAlive keep_alive;
+int keep_alive_active_rate = -1;
+
+// Self-update
+TrackingPoller poller;
+int poller_rate = 0;
+JointFrame inline_frame;
+
+// Smoothing
+PoseFilterBank filter_bank;
+uint64_t filter_bank_objects = 0; // VR Objects it's been filtering
+
+// Recent samples of every joint, on the update() thread
+PoseHistory pose_history;
+JointFrame interpolated_frame;
+
+// Per-joint prediction horizons, also on the update() thread
+PredictionTuner prediction_tuner;
+PoseExtrapolator::Horizons joint_horizons;
+bool tuning_prediction = false; // Whether the tuner's been seeing frames
+
+// Every prediction made from one horizon 0 frame, same thread
+PoseExtrapolator pose_extrapolator;
+JointFrame predicted_frame; // For Amethyst
+JointFrame exported_frame; // For shared memory and the stream
+
+// Short tracking losses, same thread
+DeadReckoning dead_reckoner;
+JointFrame reckoned_frame;
+bool reckoning = false; // Whether it's been seeing frames
+
+// SDK clock -> host clock, fed by every live frame (sampling thread only)
+ClockMapper clock_mapper;
+
+// Recording / replay, see sync_recording()
+std::atomic<std::shared_ptr<PoseRecorder>> active_recorder; // What sampling writes to
+std::atomic<std::shared_ptr<PoseReplay>> active_replay; // What sampling reads from
+std::shared_ptr<PoseRecorder> host_recorder; // Host thread's hold on them
+std::shared_ptr<PoseReplay> host_replay;
+
+// Closes both for good, once sampling's stopped and nothing else holds them
+// Not inline in shutdown(): its __try can't have objects that need unwinding (C2712)
+void release_recording()
+{
+	active_recorder.store(nullptr);
+	active_replay.store(nullptr);
+	if (host_recorder) host_recorder->stop();
+	host_recorder.reset();
+	host_replay.reset();
+}
+
+void copy_pose(const ovrPoseStatef& pose, const unsigned int status, JointSample& sample)
+{
+	sample.position[0] = pose.ThePose.Position.x;
+	sample.position[1] = pose.ThePose.Position.y;
+	sample.position[2] = pose.ThePose.Position.z;
+
+	sample.orientation[0] = pose.ThePose.Orientation.x;
+	sample.orientation[1] = pose.ThePose.Orientation.y;
+	sample.orientation[2] = pose.ThePose.Orientation.z;
+	sample.orientation[3] = pose.ThePose.Orientation.w;
+
+	sample.linearVelocity[0] = pose.LinearVelocity.x;
+	sample.linearVelocity[1] = pose.LinearVelocity.y;
+	sample.linearVelocity[2] = pose.LinearVelocity.z;
+
+	sample.linearAcceleration[0] = pose.LinearAcceleration.x;
+	sample.linearAcceleration[1] = pose.LinearAcceleration.y;
+	sample.linearAcceleration[2] = pose.LinearAcceleration.z;
+
+	sample.angularVelocity[0] = pose.AngularVelocity.x;
+	sample.angularVelocity[1] = pose.AngularVelocity.y;
+	sample.angularVelocity[2] = pose.AngularVelocity.z;
+
+	sample.angularAcceleration[0] = pose.AngularAcceleration.x;
+	sample.angularAcceleration[1] = pose.AngularAcceleration.y;
+	sample.angularAcceleration[2] = pose.AngularAcceleration.z;
+
+	sample.sampleTime = pose.TimeInSeconds;
+	sample.statusFlags = status;
+}
+
+// The real pose source, straight from LibOVR
+class OvrPoseSource : public IPoseSource
+{
+public:
+	double time_seconds() override
+	{
+		return ovr_GetTimeInSeconds();
+	}
+
+	void hand_poses(const double time, JointSample hands[2]) override
+	{
+		const auto tracking_start = LatencyStats::clock::now();
+		const auto tracking_state = ovr_GetTrackingState(
+			instance->mSession, time, ovrTrue);
+		latency.record(Stage_TrackingState, tracking_start, LatencyStats::clock::now());
+
+		for (int i = 0; i < 2; i++)
+			copy_pose(tracking_state.HandPoses[i], tracking_state.HandStatusFlags[i], hands[i]);
+
+		// The HMD's IMU keeps the sample time moving even with the controllers off
+		mHeadSampleTime = tracking_state.HeadPose.TimeInSeconds;
+	}
+
+	uint64_t connected_objects() override
+	{
+		// Object0-3 are individual bits (0x100-0x800), that's all LibOVR has
+		return (ovr_GetConnectedControllerTypes(instance->mSession) >> 8) & 0xf;
+	}
+
+	bool object_poses(const double time, uint64_t slots, JointSample* objects) override
+	{
+		ovrTrackedDeviceType types[max_frame_joints - 2];
+		ovrPoseStatef object_poses[max_frame_joints - 2];
+
+		uint32_t count = 0;
+		for (; slots; slots &= slots - 1)
+			types[count++] = static_cast<ovrTrackedDeviceType>(
+				ovrTrackedDevice_Object0 << std::countr_zero(slots));
+
+		const auto poses_start = LatencyStats::clock::now();
+		const ovrResult result = ovr_GetDevicePoses(
+			instance->mSession, types,
+			static_cast<int>(count), time, object_poses);
+		latency.record(Stage_DevicePoses, poses_start, LatencyStats::clock::now());
+
+		if (!OVR_SUCCESS(result))
+		{
+			log_sink.log(device_poses_failed_log, L"error %d", result);
+			sdk_errors.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			// ovr_GetDevicePoses has no status bits, VR Objects that aren't
+			// there come back with an all-zero orientation (or no sample time) instead
+			// A real pose can have any single component at zero, only all four rule it out
+			const ovrQuatf& orientation = object_poses[i].ThePose.Orientation;
+			const bool present = object_poses[i].TimeInSeconds != 0.0 &&
+				(orientation.x != 0 || orientation.y != 0 || orientation.z != 0 || orientation.w != 0);
+
+			copy_pose(object_poses[i], present ? ovrStatus_OrientationTracked | ovrStatus_PositionTracked : 0,
+			          objects[i]);
+		}
+		return true;
+	}
+
+	// LibOVR has no 'should recreate' flag: a status call the service can't answer is the same thing
+	SessionSignals session_signals() override
+	{
+		SessionSignals signals;
+		signals.sampleTime = mHeadSampleTime;
+
+		ovrSessionStatus status = {};
+		if (const ovrResult result = ovr_GetSessionStatus(instance->mSession, &status); !OVR_SUCCESS(result))
+		{
+			signals.shouldRecreate = result == ovrError_ServiceConnection || result == ovrError_ServiceError;
+			sdk_errors.fetch_add(1, std::memory_order_relaxed);
+		}
+		else
+			signals.displayLost = status.DisplayLost;
+
+		signals.errors = sdk_errors.exchange(0, std::memory_order_relaxed);
+		return signals;
+	}
+
+	bool recreate_session() override
+	{
+		mHeadSampleTime = 0.0;
+		return seh_guarded([] { return instance->restart_session(); });
+	}
+
+private:
+	double mHeadSampleTime = 0.0; // Sampling thread only
+} ovr_source;
+
+IPoseSource& pose_source()
+{
+	if (simulating)
+		return simulated_source;
+	return ovr_source;
+}
+
+// Opens/closes the recording and the replay as the settings say, on the host thread
+// The sampling thread only ever picks up a ready one (active_recorder/active_replay);
+// taking one away waits until it's let go of, so files are only touched here
+void DeviceHandler::sync_recording()
+{
+	if (record_poses && !host_recorder)
+	{
+		const std::wstring path = ktvr::GetK2AppDataLogFileDir(
+			L"RiftCV1", std::format(L"poses_{}.cv1poses", AME_API_GET_TIMESTAMP_NOW));
+
+		if (auto started = std::make_shared<PoseRecorder>(); started->start(path))
+		{
+			logInfoMessage(L"CV1 Device: Recording poses to " + path);
+			host_recorder = started;
+			active_recorder.store(std::move(started), std::memory_order_release);
+
+			std::lock_guard lock(replay_file_mutex);
+			replay_file = path; // Replay the latest recording by default
+		}
+		else
+		{
+			logErrorMessage(L"CV1 Device Error: Couldn't start recording to " + path);
+			record_poses = false;
+		}
+	}
+	else if (!record_poses && host_recorder)
+	{
+		active_recorder.store(nullptr, std::memory_order_release);
+		if (host_recorder.use_count() == 1) // Sampling's done with it
+		{
+			logInfoMessage(std::format(L"CV1 Device: Recorded {} poses", host_recorder->records()));
+			host_recorder->stop();
+			host_recorder.reset();
+		}
+	}
+
+	if (replay_pacing != PoseReplay::Replay_Off && !host_replay)
+	{
+		std::wstring path;
+		{
+			std::lock_guard lock(replay_file_mutex);
+			path = replay_file;
+		}
+
+		if (auto opened = std::make_shared<PoseReplay>(); opened->open(path))
+		{
+			host_replay = opened;
+			active_replay.store(std::move(opened), std::memory_order_release);
+		}
+		else
+		{
+			logErrorMessage(L"CV1 Device Error: Couldn't open pose recording " + path);
+			replay_pacing = PoseReplay::Replay_Off;
+		}
+	}
+	else if (replay_pacing == PoseReplay::Replay_Off && host_replay)
+	{
+		active_replay.store(nullptr, std::memory_order_release);
+		if (host_replay.use_count() == 1)
+			host_replay.reset(); // Unmaps it
+	}
+}
+
+// Opens/closes the pose stream as the settings say, reopens it after an edit
+// Host thread only, like everything else that touches pose_stream
+void DeviceHandler::sync_stream()
+{
+	if (pose_stream.is_open() && (!stream_poses || stream_changed.exchange(false)))
+	{
+		logInfoMessage(std::format(L"CV1 Device: Streamed {} frames ({} KiB), {} dropped",
+		                           pose_stream.sent(), pose_stream.bytes() / 1024, pose_stream.dropped()));
+		pose_stream.close();
+	}
+
+	if (stream_poses && !pose_stream.is_open())
+	{
+		stream_changed = false;
+
+		std::wstring address;
+		{
+			std::lock_guard lock(stream_address_mutex);
+			address = stream_address;
+		}
+
+		if (pose_stream.open(WStringToString(address), static_cast<uint16_t>(stream_port)))
+			logInfoMessage(std::format(L"CV1 Device: Streaming poses to {}:{}", address, stream_port));
+		else
+		{
+			logErrorMessage(std::format(L"CV1 Device Error: Couldn't stream poses to {}:{}", address, stream_port));
+			stream_poses = false;
+		}
+	}
+}
+
+// May run on the poller thread
+void DeviceHandler::sample_frame(JointFrame& frame)
+{
+	const auto acquire_start = std::chrono::steady_clock::now();
+
+	if (const std::shared_ptr<PoseReplay> replay = active_replay.load(std::memory_order_acquire))
+	{
+		replay->next(frame, static_cast<PoseReplay::Pacing>(replay_pacing.load(std::memory_order_relaxed)));
+		frame.sdkCalls = 0;
+	}
+	else
+	{
+		// Horizon 0: the SDK's poses as of now (sample time + its own short prediction),
+		// every look-ahead past that comes from PoseExtrapolator afterwards
+		acquire_frame(pose_source(), frame, 0.0, connected_objects.load(std::memory_order_relaxed));
+
+		clock_mapper.add(frame.sdkTime, frame.hostBefore, frame.hostTimestamp);
+		frame.clock = clock_mapper.mapping();
+		if (const std::shared_ptr<PoseRecorder> recorder = active_recorder.load(std::memory_order_acquire))
+			recorder->record(frame); // Raw, before any smoothing
+
+		// Is the session still alive, every couple of frames
+		if (session_watchdog.due(frame.sdkTime))
+		{
+			SessionSignals signals = pose_source().session_signals();
+			for (uint32_t i = 0; i < frame.jointCount; i++)
+				signals.sampleTime = std::max<double>(signals.sampleTime, frame.joints[i].sampleTime);
+			session_watchdog.observe(frame.sdkTime, signals);
+		}
+	}
+
+	// Judged before smoothing, it's the tracking we're after, not the filter
+	tracking_quality.observe(frame);
+
+	const auto filter_start = std::chrono::steady_clock::now();
+	frame.acquireNanoseconds = static_cast<uint32_t>(
+		std::chrono::duration_cast<std::chrono::nanoseconds>(
+			filter_start - acquire_start).count());
+
+	// Smoothing runs wherever sampling does, so its state never crosses threads
+	// Joints shift around when VR Objects come or go, start over then
+	if (frame.objectMask != filter_bank_objects)
+	{
+		filter_bank.reset();
+		filter_bank_objects = frame.objectMask;
+	}
+	filter_bank.set_mode(filter_mode);
+	filter_bank.filter(frame);
+
+	frame.filterNanoseconds = static_cast<uint32_t>(
+		std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - filter_start).count());
+	latency[Stage_Filter].record(frame.filterNanoseconds);
+}
+
+// Adds joints for newly connected VR Objects and retires the ones that went away
+// Joints are never removed or reordered, a slot that comes back gets its old joint again
+void DeviceHandler::sync_object_joints(const uint64_t connected)
+{
+	const uint64_t known = connected & first_object_slots(max_frame_joints - 2);
+	if (known == object_joint_slots) return;
+
+	for (uint64_t added = known & ~object_joint_slots; added; added &= added - 1)
+	{
+		const int slot = std::countr_zero(added);
+		if (object_joints[slot] < 0)
+		{
+			object_joints[slot] = static_cast<int>(trackedJoints.size());
+			trackedJoints.push_back(ktvr::K2TrackedJoint(L"VR Object " + std::to_wstring(slot + 1)));
+		}
+		logInfoMessage(std::format(L"CV1 Device: VR Object {} connected", slot + 1));
+	}
+
+	for (uint64_t removed = object_joint_slots & ~known; removed; removed &= removed - 1)
+	{
+		const int slot = std::countr_zero(removed);
+		trackedJoints[object_joints[slot]].update_state(ktvr::State_NotTracked);
+		logInfoMessage(std::format(L"CV1 Device: VR Object {} disconnected", slot + 1));
+	}
+
+	object_joint_slots = known;
+}
+
+void DeviceHandler::lose_session()
+{
+	const SessionWatchdog::Stats stats = session_watchdog.stats();
+	constexpr const wchar_t* causes[] = {
+		L"", L"no new samples", L"the service restarted", L"the HMD was disconnected", L"SDK calls keep failing"
+	};
+	logWarningMessage(std::format(L"CV1 Device: Session lost ({}), recreating it", causes[stats.lastCause]));
+
+	// Nothing may call into the session while it's recreated
+	poller.stop();
+	keep_alive.stop();
+
+	// Keep the last poses, only say they're gone
+	for (ktvr::K2TrackedJoint& joint : trackedJoints)
+		joint.update_state(ktvr::State_NotTracked);
+
+	// The new session starts over: every first sample is fresh, orientations may flip
+	for (JointFreshness& joint : joint_freshness)
+	{
+		joint.sampleTime = -1.0;
+		joint.statusFlags = ~0u;
+	}
+	joint_batch.reset();
+	pose_history.reset();
+	prediction_tuner.reset();
+	dead_reckoner.reset();
+	filter_bank.reset(); // Sampling's stopped, safe from here
+
+	session_watchdog.recover(scan_worker, [] { return pose_source().recreate_session(); });
+	session_down = true;
+}
+
+// K2TrackedJoint::update() takes six Eigen temporaries and always stamps AME_API_GET_TIMESTAMP_NOW,
+// the joint's storage is protected, a pointer to member formed through a derived class can still reach it
+struct JointStorage : ktvr::K2TrackedJoint
+{
+	// Same as update(), straight from a converted pose
+	// Element by element on purpose: the pose was just stored as packets,
+	// reading it back as misaligned 3/4-wide packets stalls on store forwarding
+	static void write(ktvr::K2TrackedJoint& joint, const JointBatch::Pose& pose,
+	                  const ktvr::ITrackedJointState state, const long long timestamp)
+	{
+		Eigen::Vector3d& position = joint.*(&JointStorage::jointPosition);
+		Eigen::Quaterniond& orientation = joint.*(&JointStorage::jointOrientation);
+
+		joint.*(&JointStorage::previousJointPosition) = position;
+		joint.*(&JointStorage::previousJointOrientation) = orientation;
+
+		const auto vector = [&pose](Eigen::Vector3d& out, const int channel)
+		{
+			out << pose[channel], pose[channel + 1], pose[channel + 2];
+		};
+
+		vector(position, JointBatch::Position);
+		orientation.coeffs() << pose[JointBatch::Orientation], // Stored as xyzw too
+			pose[JointBatch::Orientation + 1], pose[JointBatch::Orientation + 2], pose[JointBatch::Orientation + 3];
+
+		vector(joint.*(&JointStorage::jointVelocity), JointBatch::LinearVelocity);
+		vector(joint.*(&JointStorage::jointAcceleration), JointBatch::LinearAcceleration);
+		vector(joint.*(&JointStorage::jointAngularVelocity), JointBatch::AngularVelocity);
+		vector(joint.*(&JointStorage::jointAngularAcceleration), JointBatch::AngularAcceleration);
+
+		joint.*(&JointStorage::trackingState) = state;
+
+		long long& pose_timestamp = joint.*(&JointStorage::poseTimestamp);
+		joint.*(&JointStorage::previousPoseTimestamp) = pose_timestamp;
+		pose_timestamp = timestamp;
+	}
+};
+
+// Pushes a complete frame into the joints
+void DeviceHandler::update_joints(std::vector<ktvr::K2TrackedJoint>& joints, const JointFrame& frame,
+                                  const PoseExtrapolator::Horizons& horizons, const ObjectJointMap& objects,
+                                  JointFreshnessList& freshness, JointBatch& batch)
+{
+	// Which joint every sample goes to and as what, -1: leave the pose alone
+	int targets[max_frame_joints];
+	ktvr::ITrackedJointState states[max_frame_joints];
+	std::fill_n(targets, frame.jointCount, -1);
+
+	uint64_t slots = frame.objectMask;
+	for (uint32_t i = 0; i < frame.jointCount; i++)
+	{
+		const JointSample& pose = frame.joints[i];
+
+		// Hands first, then VR Objects wherever their joint ended up
+		int joint = static_cast<int>(i);
+		if (i >= 2)
+		{
+			if (!slots) break;
+			joint = objects[std::countr_zero(slots)];
+			slots &= slots - 1;
+		}
+		if (joint < 0 || joint >= static_cast<int>(std::min<size_t>(joints.size(), freshness.size())))
+			continue;
+
+		// Position dead-reckoned by the SDK: inferred, nothing at all: not tracked
+		const ktvr::ITrackedJointState state =
+			!(pose.statusFlags & status_orientation_tracked)
+				? ktvr::State_NotTracked
+				: pose.statusFlags & status_position_tracked
+				? ktvr::State_Tracked
+				: ktvr::State_Inferred;
+
+		// Nothing new since the last frame, don't churn the joint
+		JointFreshness& last = freshness[joint];
+		if (pose.sampleTime == last.sampleTime)
+		{
+			if (pose.statusFlags != last.statusFlags)
+			{
+				joints[joint].update_state(state);
+				last.statusFlags = pose.statusFlags;
+			}
+			last.stale++;
+			continue;
+		}
+
+		last.sampleTime = pose.sampleTime;
+		last.statusFlags = pose.statusFlags;
+		last.fresh++;
+
+		// Lost: keep the last good pose, only say it's gone
+		if (state == ktvr::State_NotTracked)
+		{
+			joints[joint].update_state(state);
+			continue;
+		}
+
+		targets[i] = joint;
+		states[i] = state;
+	}
+
+	// Then all poses in one pass, every joint still runs through it to keep its hemisphere
+	const long long now = AME_API_GET_TIMESTAMP_NOW;
+	batch.convert(frame, [&](const uint32_t i, const JointBatch::Pose& pose)
+	{
+		if (targets[i] < 0) return;
+
+		// Stamped with when the pose is for (as predicted), if we know when that is
+		JointStorage::write(joints[targets[i]], pose, states[i], pose_host_time(frame, horizons[i], now));
+	});
+}
+
+// What update_joints() used to do per joint, only kept around for the benchmark
+void update_joints_scalar(std::vector<ktvr::K2TrackedJoint>& joints, const JointFrame& frame)
+{
+	for (uint32_t i = 0; i < frame.jointCount && i < joints.size(); i++)
+	{
+		const JointSample& pose = frame.joints[i];
+		joints[i].update(
+			{pose.position[0], pose.position[1], pose.position[2]},
+			{pose.orientation[3], pose.orientation[0], pose.orientation[1], pose.orientation[2]},
+			{pose.linearVelocity[0], pose.linearVelocity[1], pose.linearVelocity[2]},
+			{pose.linearAcceleration[0], pose.linearAcceleration[1], pose.linearAcceleration[2]},
+			{pose.angularVelocity[0], pose.angularVelocity[1], pose.angularVelocity[2]},
+			{pose.angularAcceleration[0], pose.angularAcceleration[1], pose.angularAcceleration[2]},
+			ktvr::State_Tracked);
+	}
+}
+
+// Acquisition counters, shown in the settings page
+uint64_t counted_frames = 0;
+uint64_t counted_sdk_calls = 0;
+uint64_t counted_nanoseconds = 0;
+uint64_t counted_filter_nanoseconds = 0;
+uint64_t counted_updates = 0;
+uint64_t counted_update_nanoseconds = 0;
+uint32_t counted_joints = 0;
+ClockMapping counted_clock;
+auto counters_since = std::chrono::steady_clock::now();
+
+// Pushes a complete frame into trackedJoints, always on Amethyst's thread
+void DeviceHandler::apply_frame(const JointFrame& frame)
+{
+	counted_frames++;
+	counted_sdk_calls += frame.sdkCalls;
+	counted_nanoseconds += frame.acquireNanoseconds;
+	counted_filter_nanoseconds += frame.filterNanoseconds;
+	counted_joints = frame.jointCount;
+	counted_clock = frame.clock;
+
+	// How old the frame is by the time Amethyst gets to see it
+	latency[Stage_SampleAge].record(static_cast<uint64_t>(
+		std::max<long long>(AME_API_GET_TIMESTAMP_NOW - frame.hostTimestamp, 0)) * 1000);
+
+	const auto prediction_start = LatencyStats::clock::now();
+
+	// Horizon 0 frames feed the tuner, smoothing included: filter lag is lag too
+	// Switching over starts it from scratch, the frames in between get the target horizon
+	if (auto_prediction != tuning_prediction)
+	{
+		prediction_tuner.reset();
+		tuning_prediction = auto_prediction;
+	}
+	if (tuning_prediction)
+	{
+		prediction_tuner.set_target(extra_prediction * 0.001);
+		prediction_tuner.observe(frame);
+	}
+
+	// Evenly spaced poses from the history instead of whatever the last sample was
+	pose_history.push(frame);
+	const JointFrame* applied = &frame;
+
+	if (interpolation_delay > 0)
+	{
+		constexpr double grid = 0.001;
+		const double time = std::floor((frame.frameTime - interpolation_delay * 0.001) / grid) * grid;
+
+		interpolated_frame = frame;
+		if (pose_history.sample(time, interpolated_frame))
+			applied = &interpolated_frame;
+	}
+
+	// Lost joints carry on from their last good sample for a bit, then let go; they're
+	// predicted from the damped velocities like anything else
+	if (dead_reckoning > 0)
+	{
+		dead_reckoner.settings.budget = dead_reckoning * 0.001;
+		JointFrame* reckoned = &interpolated_frame;
+		if (applied != &interpolated_frame)
+		{
+			reckoned_frame = *applied;
+			reckoned = &reckoned_frame;
+		}
+		dead_reckoner.apply(*reckoned);
+		applied = reckoned;
+		reckoning = true;
+	}
+	else if (reckoning)
+	{
+		dead_reckoner.reset();
+		reckoning = false;
+	}
+
+	// One frame, every horizon from it: Amethyst's, then whatever the exports want
+	pose_extrapolator.load(*applied);
+	if (tuning_prediction)
+	{
+		prediction_tuner.horizons(*applied, joint_horizons);
+		pose_extrapolator.extrapolate(joint_horizons, predicted_frame);
+	}
+	else
+	{
+		joint_horizons.fill(extra_prediction * 0.001f);
+		pose_extrapolator.extrapolate(joint_horizons, predicted_frame);
+	}
+
+	const auto joints_start = LatencyStats::clock::now();
+	latency.record(Stage_Prediction, prediction_start, joints_start);
+
+	update_joints(trackedJoints, predicted_frame, joint_horizons, object_joints, joint_freshness, joint_batch);
+
+	const auto export_start = LatencyStats::clock::now();
+	latency.record(Stage_JointUpdate, joints_start, export_start);
+
+	sync_stream();
+	if (export_prediction > 0 && (pose_export.is_open() || pose_stream.is_open()))
+	{
+		pose_extrapolator.extrapolate(export_prediction * 0.001f, exported_frame);
+		applied = &exported_frame;
+	}
+
+	pose_export.publish(*applied, AME_API_GET_TIMESTAMP_NOW);
+	pose_stream.send(*applied, AME_API_GET_TIMESTAMP_NOW);
+	latency.record(Stage_Export, export_start, LatencyStats::clock::now());
+}
+
+// Ingestion benchmark, runs against StubPoseSource on its own thread
+std::thread benchmark_thread;
+std::atomic<bool> benchmark_running = false;
+
+#ifdef _DEBUG
+// Inside the plugin only the debug CRT can tell us about allocations,
+// bench/pose_bench counts them in any build
+std::atomic<uint64_t> crt_allocations = 0;
+
+int count_allocations(int type, void*, size_t, int, long, const unsigned char*, int)
+{
+	if (type == _HOOK_ALLOC || type == _HOOK_REALLOC)
+		crt_allocations.fetch_add(1, std::memory_order_relaxed);
+	return TRUE;
+}
+#endif
+
+void DeviceHandler::run_ingest_benchmark()
+{
+	if (benchmark_running.exchange(true))
+		return; // Already running
+
+	if (benchmark_thread.joinable())
+		benchmark_thread.join();
+
+	benchmark_thread = std::thread([this, mode = filter_mode.load()]
+	{
+		// Everything's private to the benchmark, the live state is left alone
+		auto filter = std::make_unique<PoseFilterBank>();
+		filter->set_mode(mode);
+
+		std::vector<ktvr::K2TrackedJoint> joints(max_frame_joints);
+
+		JointFreshnessList freshness;
+		JointBatch batch;
+		const PoseExtrapolator::Horizons horizons{}; // Frames as they come
+		ObjectJointMap objects;
+		for (size_t i = 0; i < objects.size(); i++)
+			objects[i] = static_cast<int>(i) + 2;
+
+		BenchmarkSetup benchmark;
+		benchmark.filter = [&](JointFrame& frame) { filter->filter(frame); };
+		benchmark.apply = [&](const JointFrame& frame) { update_joints(joints, frame, horizons, objects, freshness, batch); };
+		benchmark.convert_scalar = [&](const JointFrame& frame) { update_joints_scalar(joints, frame); };
+		benchmark.convert_batch = [&](const JointFrame& frame)
+		{
+			const long long now = AME_API_GET_TIMESTAMP_NOW;
+			batch.convert(frame, [&](const uint32_t i, const JointBatch::Pose& pose)
+			{
+				JointStorage::write(joints[i], pose, ktvr::State_Tracked, now);
+			});
+		};
+		benchmark.source = [](const uint32_t objects) -> std::unique_ptr<IPoseSource>
+		{
+			SimulationSettings settings;
+			settings.objects = objects;
+			return std::make_unique<SimulatedPoseSource>(settings);
+		};
+
+#ifdef _DEBUG
+		benchmark.allocations = [] { return crt_allocations.load(std::memory_order_relaxed); };
+		const auto previous_hook = _CrtSetAllocHook(count_allocations);
+#endif
+
+		BenchmarkReport report("pose_ingest");
+		report.add("results", json_array(benchmark_ingest(benchmark)));
+
+		// 64 VR Objects at 2 kHz is what the pipeline has to hold up to
+		report.add("load", to_json(benchmark_load(benchmark, max_frame_joints - 2, 2000, 5.0)));
+		report.add("conversion", json_array(benchmark_conversion(benchmark)));
+		report.add("recovery", json_array(benchmark_recovery()));
+		report.add("stream", json_array(benchmark_stream(benchmark)));
+		report.add("dead_reckoning", to_json(benchmark_dead_reckoning()));
+		report.add("extrapolation", json_array(benchmark_extrapolation(benchmark)));
+		const std::string results = report.json();
+
+#ifdef _DEBUG
+		_CrtSetAllocHook(previous_hook);
+#endif
+
+		const std::wstring path = ktvr::GetK2AppDataLogFileDir(
+			L"RiftCV1", std::format(L"ingest_benchmark_{}.json", AME_API_GET_TIMESTAMP_NOW));
+
+		if (std::ofstream output(path); output.fail())
+			logErrorMessage(L"CV1 Device Error: Couldn't write benchmark results to " + path);
+		else
+		{
+			output << results;
+			logInfoMessage(L"CV1 Device: Benchmark results written to " + path);
+		}
+
+		benchmark_running = false;
+	});
+}
+
+std::wstring format_latency(const uint64_t nanoseconds)
+{
+	if (nanoseconds >= 1'000'000)
+		return std::format(L"{:.2f}ms", static_cast<double>(nanoseconds) / 1e6);
+	return std::format(L"{:.1f}us", static_cast<double>(nanoseconds) / 1e3);
+}
+
+void DeviceHandler::reset_latency_stats()
+{
+	latency.reset();
+
+	// Only the counters, the last samples stay so nothing gets pushed twice
+	for (JointFreshness& joint : joint_freshness)
+		joint.fresh = joint.stale = 0;
+
+	tracking_quality.reset();
+}
+
+// Joint name for a TrackingQuality lane (device), empty while it has no joint
+std::wstring device_joint_name(const std::vector<ktvr::K2TrackedJoint>& joints, const size_t device)
+{
+	const int index = device < 2 ? static_cast<int>(device) : object_joints[device - 2];
+	return index >= 0 && index < static_cast<int>(joints.size()) ? joints[index].getJointName() : L"";
+}
+
+void DeviceHandler::dump_tracking_quality()
+{
+	TrackingQuality::Summary summary;
+	tracking_quality.summary(summary);
+
+	const std::wstring path = ktvr::GetK2AppDataLogFileDir(
+		L"RiftCV1", std::format(L"tracking_quality_{}.json", AME_API_GET_TIMESTAMP_NOW));
+
+	if (std::ofstream output(path); output.fail())
+		logErrorMessage(L"CV1 Device Error: Couldn't write tracking quality to " + path);
+	else
+	{
+		output << TrackingQuality::to_json(summary);
+		logInfoMessage(L"CV1 Device: Tracking quality written to " + path);
+	}
+}
+
+void DeviceHandler::report_counters()
+{
+	const auto now = std::chrono::steady_clock::now();
+	if (now - counters_since < std::chrono::seconds(1))
+		return;
+
+	if (acquisition_stats && counted_frames > 0 && counted_updates > 0)
+	{
+		std::wstring text = std::format(
+			L"{} joints, {:.2f} SDK calls/frame, {:.1f} us/frame, filter {:.2f} us, update() {:.1f} us, {} keep-alive frames",
+			counted_joints,
+			static_cast<double>(counted_sdk_calls) / counted_frames,
+			static_cast<double>(counted_nanoseconds) / counted_frames / 1000.0,
+			static_cast<double>(counted_filter_nanoseconds) / counted_frames / 1000.0,
+			static_cast<double>(counted_update_nanoseconds) / counted_updates / 1000.0,
+			keep_alive.frames_submitted());
+
+		if (counted_clock.valid)
+			text += std::format(L", SDK clock drift {:.1f} ppm", (counted_clock.rate - 1.0) * 1e6);
+
+		if (const SessionWatchdog::Stats session = session_watchdog.stats(); session.losses > 0)
+			text += std::format(L", {} lost sessions (recovery mean {:.0f} ms, worst {:.0f} ms, {} attempts)",
+			                    session.losses, session.meanMilliseconds, session.worstMilliseconds,
+			                    session.attempts);
+
+		if (const DeadReckoning::Stats lost = dead_reckoner.stats(); lost.losses > 0)
+			text += std::format(L", {} tracking losses ({} ran out of dead reckoning, {} blended back)",
+			                    lost.losses, lost.expired, lost.blended);
+
+		acquisition_stats->Text(text);
+	}
+
+	if (joint_stats)
+	{
+		// Share of frames that brought each joint a new sample
+		std::wstring text = L"New samples: ";
+		for (size_t i = 0; i < std::min<size_t>(trackedJoints.size(), joint_freshness.size()); i++)
+		{
+			const JointFreshness& joint = joint_freshness[i];
+			if (const uint64_t total = joint.fresh + joint.stale; total > 0)
+				text += std::format(L"{} {:.0f}% ({} fresh, {} stale)  ",
+				                    trackedJoints[i].getJointName(),
+				                    100.0 * static_cast<double>(joint.fresh) / static_cast<double>(total),
+				                    joint.fresh, joint.stale);
+		}
+		joint_stats->Text(text);
+	}
+
+	if (quality_stats)
+	{
+		TrackingQuality::Summary summary;
+		tracking_quality.summary(summary);
+
+		std::wstring text;
+		for (size_t i = 0; i < summary.size(); i++)
+		{
+			const TrackingQuality::JointQuality& joint = summary[i];
+			const std::wstring name = device_joint_name(trackedJoints, i);
+			if (joint.samples == 0 || name.empty()) continue;
+
+			text += std::format(
+				L"{}: jitter {:.2f} mm / {:.3f} deg, {} dropouts ({:.1f} s, longest {:.2f} s), "
+				L"{:.1f} ms between samples (peak {:.1f}, {} gaps), {} outliers\n",
+				name, joint.positionJitter, joint.angularJitter,
+				joint.dropouts, joint.dropoutSeconds, joint.longestDropout,
+				joint.meanInterval, joint.peakInterval, joint.gaps,
+				joint.velocityOutliers + joint.accelerationOutliers);
+		}
+		quality_stats->Text(text);
+	}
+
+	if (prediction_stats)
+	{
+		// Slow / medium / fast horizons, and how far off predictions land with the target vs. those
+		std::wstring text;
+		for (size_t i = 0; i < max_frame_joints && tuning_prediction; i++)
+		{
+			const std::wstring name = device_joint_name(trackedJoints, i);
+			if (name.empty()) continue;
+
+			double samples = 0.0, target_error = 0.0, fitted_error = 0.0;
+			PredictionTuner::Band bands[PredictionTuner::bands];
+			for (int b = 0; b < PredictionTuner::bands; b++)
+			{
+				bands[b] = prediction_tuner.band(static_cast<int>(i), b);
+				samples += bands[b].samples;
+				target_error += bands[b].samples * bands[b].targetError * bands[b].targetError;
+				fitted_error += bands[b].samples * bands[b].fittedError * bands[b].fittedError;
+			}
+			if (samples < 1.0) continue;
+
+			text += std::format(L"{}: prediction {:.1f} / {:.1f} / {:.1f} ms, error {:.2f} mm -> {:.2f} mm\n",
+			                    name, bands[0].horizon * 1000.0, bands[1].horizon * 1000.0, bands[2].horizon * 1000.0,
+			                    std::sqrt(target_error / samples), std::sqrt(fitted_error / samples));
+		}
+		prediction_stats->Text(text);
+	}
+
+	if (latency_stats)
+	{
+		std::wstring text;
+		for (int i = 0; i < Stage_Count; i++)
+		{
+			const LatencyHistogram& histogram = latency[static_cast<LatencyStage>(i)];
+			if (histogram.count() == 0) continue;
+
+			text += std::format(L"{}: p50 {}, p99 {}, max {}\n",
+			                    StringToWString(latency_stage_name(i)),
+			                    format_latency(histogram.percentile(0.50)),
+			                    format_latency(histogram.percentile(0.99)),
+			                    format_latency(histogram.peak()));
+		}
+		latency_stats->Text(text);
+	}
+
+	latency.publish(AME_API_GET_TIMESTAMP_NOW);
+
+	counted_frames = counted_sdk_calls = counted_nanoseconds = counted_filter_nanoseconds = 0;
+	counted_updates = counted_update_nanoseconds = 0;
+	counters_since = now;
+}
+
+LatencyStats::clock::time_point last_update_start;
+
 void DeviceHandler::update()
 {
 	// Update joints' positions here
 	// Note: this is fired up every loop
+	const auto update_start = std::chrono::steady_clock::now();
+
+	if (last_update_start != LatencyStats::clock::time_point{})
+		latency.record(Stage_Interval, last_update_start, update_start);
+	last_update_start = update_start;
+
+	// Start-up finishes here once its stages are through
+	poll_initialization();
 
 	// Enable/disable settings
 	Flags_SettingsSupported = m_result == S_OK;
@@ -363,115 +1732,82 @@ void DeviceHandler::update()
 	// Run the update loop
 	if (isInitialized() && m_result == S_OK)
 	{
-		if (ODTKRAenabled && !ODTKRAstop && !is_ODTKRA_started)
+		// Only queues the ODT actions, the worker does the rest
+		if (ODTKRAenabled && !is_ODTKRA_started)
 		{
-			ODTKRAThread = std::thread([this] { this->keepRiftAlive(); });
+			keepRiftAlive();
 			is_ODTKRA_started = true;
 		}
 		else if (!ODTKRAenabled && is_ODTKRA_started)
 		{
-			ODTKRAstop = true;
+			stop_keep_rift_alive();
 			is_ODTKRA_started = false;
-			killODT(0);
-			ODTKRAThread.join();
-			ODTKRAstop = false;
 		}
 
-		instance->Render();
+		// Picks up VR Objects the background scan found (or lost)
+		sync_object_joints(connected_objects.load(std::memory_order_relaxed));
 
-		auto tracking_state = ovr_GetTrackingState(
-			instance->mSession,
-			ovr_GetTimeInSeconds() +
-			static_cast<float>(extra_prediction) * 0.001,
-			ovrTrue);
+		// A dead session stops everything that uses it, the watchdog brings up a new one meanwhile
+		if (session_watchdog.health() == SessionWatchdog::Session_Lost)
+			lose_session();
 
-		for (int i = 0; i < 2; i++)
+		const bool session_up = session_watchdog.health() == SessionWatchdog::Session_Healthy;
+		if (session_up && session_down)
 		{
-			trackedJoints.at(i).update(
-				{
-					tracking_state.HandPoses[i].ThePose.Position.x,
-					tracking_state.HandPoses[i].ThePose.Position.y,
-					tracking_state.HandPoses[i].ThePose.Position.z
-				},
-				{
-					tracking_state.HandPoses[i].ThePose.Orientation.w,
-					tracking_state.HandPoses[i].ThePose.Orientation.x,
-					tracking_state.HandPoses[i].ThePose.Orientation.y,
-					tracking_state.HandPoses[i].ThePose.Orientation.z
-				},
-				{
-					tracking_state.HandPoses[i].LinearVelocity.x,
-					tracking_state.HandPoses[i].LinearVelocity.y,
-					tracking_state.HandPoses[i].LinearVelocity.z
-				},
-				{
-					tracking_state.HandPoses[i].LinearAcceleration.x,
-					tracking_state.HandPoses[i].LinearAcceleration.y,
-					tracking_state.HandPoses[i].LinearAcceleration.z
-				},
-				{
-					tracking_state.HandPoses[i].AngularVelocity.x,
-					tracking_state.HandPoses[i].AngularVelocity.y,
-					tracking_state.HandPoses[i].AngularVelocity.z
-				},
-				{
-					tracking_state.HandPoses[i].AngularAcceleration.x,
-					tracking_state.HandPoses[i].AngularAcceleration.y,
-					tracking_state.HandPoses[i].AngularAcceleration.z
-				},
-				ktvr::State_Tracked);
+			const SessionWatchdog::Stats stats = session_watchdog.stats();
+			logInfoMessage(std::format(L"CV1 Device: Session recovered after {:.0f} ms ({} losses so far)",
+			                           stats.lastMilliseconds, stats.losses));
+			session_down = false;
 		}
 
-		for (int i = 0; i < instance->vrObjects; i++)
+		// Keep the compositor fed from its own thread, never wait on it here
+		// (there's no compositor when simulating)
+		if (!simulating && session_up && (!keep_alive.running() || keep_alive_active_rate != keep_alive_rate))
 		{
-			auto deviceType = static_cast<ovrTrackedDeviceType>(ovrTrackedDevice_Object0 + i);
-			ovrPoseStatef ovr_pose;
+			keep_alive.start(instance, keep_alive_rate);
+			keep_alive_active_rate = keep_alive_rate;
+		}
 
-			ovr_GetDevicePoses(instance->mSession, &deviceType, 1,
-			                   (ovr_GetTimeInSeconds() + (static_cast<float>(extra_prediction) * 0.001)), &ovr_pose);
-			if ((ovr_pose.ThePose.Orientation.x != 0) && (ovr_pose.ThePose.Orientation.y != 0) && (ovr_pose.ThePose.
-				Orientation.z != 0))
+		// Recording/replay files are opened and closed here, sampling only picks them up
+		sync_recording();
+
+		if (!session_up)
+		{
+			// Joints stay not tracked until the session's back
+		}
+		else if (self_update)
+		{
+			// (Re)start the poller if needed, e.g. after the rate changed
+			if (!poller.running() || poller_rate != poll_rate)
 			{
-				trackedJoints.at(i + 2).update(
-					{
-						ovr_pose.ThePose.Position.x,
-						ovr_pose.ThePose.Position.y,
-						ovr_pose.ThePose.Position.z
-					},
-					{
-						ovr_pose.ThePose.Orientation.w,
-						ovr_pose.ThePose.Orientation.x,
-						ovr_pose.ThePose.Orientation.y,
-						ovr_pose.ThePose.Orientation.z
-					},
-					{
-						ovr_pose.LinearVelocity.x,
-						ovr_pose.LinearVelocity.y,
-						ovr_pose.LinearVelocity.z
-					},
-					{
-						ovr_pose.LinearAcceleration.x,
-						ovr_pose.LinearAcceleration.y,
-						ovr_pose.LinearAcceleration.z
-					},
-					{
-						ovr_pose.AngularVelocity.x,
-						ovr_pose.AngularVelocity.y,
-						ovr_pose.AngularVelocity.z
-					},
-					{
-						ovr_pose.AngularAcceleration.x,
-						ovr_pose.AngularAcceleration.y,
-						ovr_pose.AngularAcceleration.z
-					},
-					ktvr::State_Tracked);
+				poller.start([this](JointFrame& frame) { sample_frame(frame); }, poll_rate);
+				poller_rate = poll_rate;
 			}
+
+			// Only touch the joints once a new frame came in
+			if (poller.fetch())
+				apply_frame(poller.latest());
 		}
+		else
+		{
+			if (poller.running())
+				poller.stop();
 
+			sample_frame(inline_frame);
+			apply_frame(inline_frame);
+		}
 
 		// Mark that we see the user
 		skeletonTracked = true;
 		frame++;
+
+		const auto update_end = std::chrono::steady_clock::now();
+		latency.record(Stage_Update, update_start, update_end);
+
+		counted_updates++;
+		counted_update_nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(
+			update_end - update_start).count();
+		report_counters();
 	}
 }
 
@@ -481,16 +1817,45 @@ void DeviceHandler::shutdown()
 
 	__try
 	{
-		if (ODTKRAenabled)
-		{
-			ODTKRAstop = true;
-			ODTKRAThread.join();
-		}
+		// Nothing new starts, whatever's running (an SDK call) we have to wait out
+		init_sequence.cancel();
+		init_sequence.wait();
 
-		DIRECTX.ReleaseDevice();
-		ovr_Destroy(instance->mSession);
-		ovr_Shutdown();
-		delete[] instance;
+		// Everything that logs through log_sink goes first, see below
+		poller.stop();
+		keep_alive.stop();
+		scan_worker.stop();
+
+		// Drops whatever ODT steps are left, waits for one at most
+		odt_worker.stop();
+		is_ODTKRA_started = false;
+
+		clock_mapper.reset(); // The next session may run on another clock
+		pose_history.reset();
+
+		release_recording(); // Sampling's stopped
+
+		if (benchmark_thread.joinable())
+			benchmark_thread.join();
+		latency.close_export();
+		pose_export.close();
+		pose_stream.close();
+
+		// Nothing's logging through it anymore, flush what's left
+		log_sink.stop();
+		settings_store.flush();
+
+		if (!simulating)
+			instance->stop_ovr();
+
+		// Only now, the window goes with the sequence's thread
+		init_sequence.stop();
+		m_result = E_NOT_STARTED;
+
+		// Placement new on _aligned_malloc, see initialize()
+		instance->~GuardianSystem();
+		_aligned_free(instance);
+		instance = nullptr;
 	}
 	__except (EXCEPTION_EXECUTE_HANDLER)
 	{
@@ -2,19 +2,92 @@
 #include <Amethyst_API_Devices.h>
 #include <Amethyst_API_Paths.h>
 
+#include <array>
+#include <atomic>
 #include <fstream>
+#include <mutex>
 #include <shellapi.h>
 
 #include <cereal/types/unordered_map.hpp>
 #include <cereal/types/memory.hpp>
+#include <cereal/types/string.hpp>
 #include <cereal/archives/xml.hpp>
 
+#include "JointBatch.h"
+#include "JointFrame.h"
+#include "PoseExtrapolator.h"
+#include "SettingsStore.h"
+
 #define FACILITY_CV1 0x301
 #define E_NOT_STARTED MAKE_HRESULT(SEVERITY_ERROR, FACILITY_CV1, 2)
 #define E_INIT_FAILURE MAKE_HRESULT(SEVERITY_ERROR, FACILITY_CV1, 3)
+#define E_INITIALIZING MAKE_HRESULT(SEVERITY_ERROR, FACILITY_CV1, 4)
 
 /* Not exported */
 
+// VR Object slot -> index in trackedJoints, -1 while the slot has no joint
+using ObjectJointMap = std::array<int, max_frame_joints - 2>;
+
+// What was last pushed into a joint, and how often frames brought it a new sample
+struct JointFreshness
+{
+	double sampleTime = -1.0;
+	uint32_t statusFlags = ~0u;
+
+	uint64_t fresh = 0; // New sample, joint updated
+	uint64_t stale = 0; // Same sample as last time, joint left alone
+};
+
+// Indexed like trackedJoints
+using JointFreshnessList = std::array<JointFreshness, max_frame_joints>;
+
+// Everything that's saved, see DeviceHandler::save_settings()
+struct DeviceSettings
+{
+	int extra_prediction = 11;
+	bool auto_prediction = true;
+	int filter_mode = 0;
+	bool ODTKRAenabled = false;
+	bool resEnabled = true;
+	bool self_update = false;
+	int poll_rate = 500;
+	int keep_alive_rate = 90;
+	bool headless_keep_alive = false;
+	bool simulate = false;
+	int simulated_objects = 4;
+	int interpolation_delay = 0;
+	int dead_reckoning = 250;
+	bool stream_poses = false;
+	std::string stream_address = "127.0.0.1";
+	int stream_port = 7755;
+	int export_prediction = 0;
+
+	template <class Archive>
+	void serialize(Archive& archive)
+	{
+		settings_fields(
+			archive,
+			CEREAL_NVP(extra_prediction),
+			CEREAL_NVP(auto_prediction),
+			CEREAL_NVP(filter_mode),
+			CEREAL_NVP(ODTKRAenabled),
+			CEREAL_NVP(resEnabled),
+			CEREAL_NVP(self_update),
+			CEREAL_NVP(poll_rate),
+			CEREAL_NVP(keep_alive_rate),
+			CEREAL_NVP(headless_keep_alive),
+			CEREAL_NVP(simulate),
+			CEREAL_NVP(simulated_objects),
+			CEREAL_NVP(interpolation_delay),
+			CEREAL_NVP(dead_reckoning),
+			CEREAL_NVP(stream_poses),
+			CEREAL_NVP(stream_address),
+			CEREAL_NVP(stream_port),
+			CEREAL_NVP(export_prediction)
+		);
+	}
+};
+
 class DeviceHandler : public ktvr::K2TrackingDeviceBase_JointsBasis
 {
 public:
@@ -44,6 +117,27 @@ public:
 
 	void onLoad() override
 	{
+		// Start-up progress, only shown while initializing
+		init_ring = CreateProgressRing();
+		init_status = CreateTextBlock(L"");
+		init_cancel = CreateButton(L"Cancel");
+		init_progress = CreateProgressBar();
+
+		layoutRoot->AppendElementVectorStack({
+			init_ring,
+			init_status,
+			init_cancel
+		});
+		layoutRoot->AppendSingleElement(init_progress);
+
+		init_cancel->OnClick =
+			[&, this](ktvr::Interface::Button* sender)
+			{
+				cancel_initialization();
+			};
+
+		show_init_progress(m_result == E_INITIALIZING, 0, L"");
+
 		auto enableODTKRA_label = CreateTextBlock(L"Enable keep rift alive ");
 		auto enableODTKRA = CreateToggleSwitch();
 
@@ -56,10 +150,102 @@ public:
 		auto prediction_label = CreateTextBlock(L"Extra Predictions in milliseconds ");
 		extra_prediction_ms = CreateNumberBox(extra_prediction);
 
+		auto auto_prediction_label = CreateTextBlock(L"Tune the prediction per joint (lands on the value above) ");
+		auto auto_prediction_toggle = CreateToggleSwitch();
+		auto_prediction_toggle->IsChecked(auto_prediction);
+
+		auto filter_label = CreateTextBlock(L"Pose smoothing ");
+		auto filter = CreateComboBox({L"Off", L"One-Euro", L"Kalman"});
+		filter->SelectedIndex(filter_mode);
+
+		auto self_update_label = CreateTextBlock(L"Poll tracking on a separate thread ");
+		auto self_update_toggle = CreateToggleSwitch();
+		self_update_toggle->IsChecked(self_update);
+
+		auto poll_rate_label = CreateTextBlock(L"Polling rate in Hz ");
+		poll_rate_hz = CreateNumberBox(poll_rate);
+
+		auto keep_alive_label = CreateTextBlock(L"Keep-alive frames per second (0 = only when needed) ");
+		keep_alive_rate_hz = CreateNumberBox(keep_alive_rate);
+
 		layoutRoot->AppendElementPairStack(
 			prediction_label,
 			extra_prediction_ms);
 
+		layoutRoot->AppendElementPairStack(
+			auto_prediction_label,
+			auto_prediction_toggle);
+
+		prediction_stats = CreateTextBlock(L"");
+		layoutRoot->AppendSingleElement(prediction_stats);
+
+		auto_prediction_toggle->OnChecked =
+			[&, this](ktvr::Interface::ToggleSwitch* sender)
+			{
+				auto_prediction = true;
+				save_settings(); // Save everything
+			};
+		auto_prediction_toggle->OnUnchecked =
+			[&, this](ktvr::Interface::ToggleSwitch* sender)
+			{
+				auto_prediction = false;
+				save_settings(); // Save everything
+			};
+
+		auto interpolation_label = CreateTextBlock(L"Interpolate poses this many ms in the past (0 = off) ");
+		interpolation_delay_ms = CreateNumberBox(interpolation_delay);
+
+		layoutRoot->AppendElementPairStack(
+			interpolation_label,
+			interpolation_delay_ms);
+
+		interpolation_delay_ms->OnValueChanged =
+			[&, this](ktvr::Interface::NumberBox* sender, const int& new_value)
+			{
+				const int fixed_new_value =
+					std::clamp(new_value, 0, 100);
+
+				sender->Value(fixed_new_value); // Overwrite
+				interpolation_delay = fixed_new_value;
+
+				save_settings(); // Save everything
+			};
+
+		auto dead_reckoning_label = CreateTextBlock(L"Keep lost joints moving for this many ms (0 = off) ");
+		dead_reckoning_ms = CreateNumberBox(dead_reckoning);
+
+		layoutRoot->AppendElementPairStack(
+			dead_reckoning_label,
+			dead_reckoning_ms);
+
+		dead_reckoning_ms->OnValueChanged =
+			[&, this](ktvr::Interface::NumberBox* sender, const int& new_value)
+			{
+				const int fixed_new_value =
+					std::clamp(new_value, 0, 2000);
+
+				sender->Value(fixed_new_value); // Overwrite
+				dead_reckoning = fixed_new_value;
+
+				save_settings(); // Save everything
+			};
+
+		layoutRoot->AppendElementPairStack(
+			filter_label,
+			filter);
+
+		layoutRoot->AppendElementPairStack(
+			self_update_label,
+			self_update_toggle);
+
+		layoutRoot->AppendElementPairStack(
+			poll_rate_label,
+			poll_rate_hz);
+
+		layoutRoot->AppendElementPairStack(
+			keep_alive_label,
+			keep_alive_rate_hz);
+
 		layoutRoot->AppendElementPairStack(
 			enableODTKRA_label,
 			enableODTKRA);
@@ -68,6 +254,217 @@ public:
 			res_label,
 			res);
 
+		auto headless_label = CreateTextBlock(L"Headless keep-alive (minimal VRAM, applies on Refresh) ");
+		auto headless = CreateToggleSwitch();
+		headless->IsChecked(headless_keep_alive);
+
+		layoutRoot->AppendElementPairStack(
+			headless_label,
+			headless);
+
+		headless->OnChecked =
+			[&, this](ktvr::Interface::ToggleSwitch* sender)
+			{
+				headless_keep_alive = true;
+				save_settings(); // Save everything
+			};
+		headless->OnUnchecked =
+			[&, this](ktvr::Interface::ToggleSwitch* sender)
+			{
+				headless_keep_alive = false;
+				save_settings(); // Save everything
+			};
+
+		auto simulate_label = CreateTextBlock(L"Simulated headset, no Oculus runtime needed (applies on Refresh) ");
+		auto simulate_toggle = CreateToggleSwitch();
+		simulate_toggle->IsChecked(simulate);
+
+		auto simulated_objects_label = CreateTextBlock(L"Simulated VR Objects ");
+		simulated_objects_count = CreateNumberBox(simulated_objects);
+
+		layoutRoot->AppendElementPairStack(
+			simulate_label,
+			simulate_toggle);
+
+		layoutRoot->AppendElementPairStack(
+			simulated_objects_label,
+			simulated_objects_count);
+
+		simulate_toggle->OnChecked =
+			[&, this](ktvr::Interface::ToggleSwitch* sender)
+			{
+				simulate = true;
+				save_settings(); // Save everything
+			};
+		simulate_toggle->OnUnchecked =
+			[&, this](ktvr::Interface::ToggleSwitch* sender)
+			{
+				simulate = false;
+				save_settings(); // Save everything
+			};
+
+		simulated_objects_count->OnValueChanged =
+			[&, this](ktvr::Interface::NumberBox* sender, const int& new_value)
+			{
+				const int fixed_new_value =
+					std::clamp(new_value, 0, static_cast<int>(max_frame_joints) - 2);
+
+				sender->Value(fixed_new_value); // Overwrite
+				simulated_objects = fixed_new_value;
+
+				save_settings(); // Save everything
+			};
+
+		auto record_label = CreateTextBlock(L"Record poses ");
+		auto record = CreateToggleSwitch();
+		record->IsChecked(record_poses);
+
+		auto replay_label = CreateTextBlock(L"Replay poses from ");
+		replay_path = CreateTextBox();
+		replay_path->Text(replay_file);
+		auto replay = CreateComboBox({L"Off", L"Real time", L"As fast as possible"});
+		replay->SelectedIndex(replay_pacing);
+
+		layoutRoot->AppendElementPairStack(
+			record_label,
+			record);
+
+		layoutRoot->AppendElementVectorStack({
+			replay_label,
+			replay_path,
+			replay
+		});
+
+		record->OnChecked =
+			[&, this](ktvr::Interface::ToggleSwitch* sender)
+			{
+				record_poses = true;
+			};
+		record->OnUnchecked =
+			[&, this](ktvr::Interface::ToggleSwitch* sender)
+			{
+				record_poses = false;
+			};
+
+		replay_path->OnEnterKeyDown =
+			[&, this](ktvr::Interface::TextBox* sender)
+			{
+				std::lock_guard lock(replay_file_mutex);
+				replay_file = sender->Text();
+			};
+
+		replay->OnSelectionChanged =
+			[&, this](ktvr::Interface::ComboBox* sender, const uint32_t& index)
+			{
+				replay_pacing = static_cast<int>(index);
+			};
+
+		auto stream_label = CreateTextBlock(L"Stream poses (UDP) to ");
+		auto stream = CreateToggleSwitch();
+		stream->IsChecked(stream_poses);
+		auto stream_address_box = CreateTextBox();
+		stream_address_box->Text(stream_address);
+		auto stream_port_box = CreateNumberBox(stream_port);
+
+		layoutRoot->AppendElementVectorStack({
+			stream_label,
+			stream_address_box,
+			stream_port_box,
+			stream
+		});
+
+		stream->OnChecked =
+			[&, this](ktvr::Interface::ToggleSwitch* sender)
+			{
+				stream_poses = true;
+				save_settings(); // Save everything
+			};
+		stream->OnUnchecked =
+			[&, this](ktvr::Interface::ToggleSwitch* sender)
+			{
+				stream_poses = false;
+				save_settings(); // Save everything
+			};
+
+		stream_address_box->OnEnterKeyDown =
+			[&, this](ktvr::Interface::TextBox* sender)
+			{
+				{
+					std::lock_guard lock(stream_address_mutex);
+					stream_address = sender->Text();
+				}
+				stream_changed = true; // Reopened on the next update()
+				save_settings(); // Save everything
+			};
+
+		stream_port_box->OnValueChanged =
+			[&, this](ktvr::Interface::NumberBox* sender, const int& new_value)
+			{
+				const int fixed_new_value = std::clamp(new_value, 1024, 65535);
+
+				sender->Value(fixed_new_value); // Overwrite
+				stream_port = fixed_new_value;
+				stream_changed = true;
+
+				save_settings(); // Save everything
+			};
+
+		auto export_prediction_label = CreateTextBlock(L"Predict shared/streamed poses this many ms (0 = as sampled) ");
+		export_prediction_ms = CreateNumberBox(export_prediction);
+
+		layoutRoot->AppendElementPairStack(
+			export_prediction_label,
+			export_prediction_ms);
+
+		export_prediction_ms->OnValueChanged =
+			[&, this](ktvr::Interface::NumberBox* sender, const int& new_value)
+			{
+				const int fixed_new_value =
+					std::clamp(new_value, 0, 100);
+
+				sender->Value(fixed_new_value); // Overwrite
+				export_prediction = fixed_new_value;
+
+				save_settings(); // Save everything
+			};
+
+		acquisition_stats = CreateTextBlock(L"Waiting for tracking data...");
+		layoutRoot->AppendSingleElement(acquisition_stats);
+
+		joint_stats = CreateTextBlock(L"");
+		layoutRoot->AppendSingleElement(joint_stats);
+
+		quality_stats = CreateTextBlock(L"");
+		auto dump_quality = CreateButton(L"Dump tracking quality");
+		layoutRoot->AppendSingleElement(quality_stats);
+		layoutRoot->AppendSingleElement(dump_quality);
+
+		dump_quality->OnClick =
+			[&, this](ktvr::Interface::Button* sender)
+			{
+				dump_tracking_quality();
+			};
+
+		latency_stats = CreateTextBlock(L"");
+		auto reset_latency = CreateButton(L"Reset timings");
+		layoutRoot->AppendSingleElement(latency_stats);
+		layoutRoot->AppendSingleElement(reset_latency);
+
+		reset_latency->OnClick =
+			[&, this](ktvr::Interface::Button* sender)
+			{
+				reset_latency_stats();
+			};
+
+		auto benchmark = CreateButton(L"Run ingestion benchmark");
+		layoutRoot->AppendSingleElement(benchmark);
+
+		benchmark->OnClick =
+			[&, this](ktvr::Interface::Button* sender)
+			{
+				run_ingest_benchmark();
+			};
+
 		// Why are these two seperate things?
 		enableODTKRA->OnChecked =
 			[&, this](ktvr::Interface::ToggleSwitch* sender)
@@ -95,17 +492,55 @@ public:
 				save_settings(); // Save everything
 			};
 
-		extra_prediction_ms->OnValueChanged = // also taken from the owotrack plugin
+		filter->OnSelectionChanged =
+			[&, this](ktvr::Interface::ComboBox* sender, const uint32_t& index)
+			{
+				filter_mode = static_cast<int>(index);
+				save_settings(); // Save everything
+			};
+
+		self_update_toggle->OnChecked =
+			[&, this](ktvr::Interface::ToggleSwitch* sender)
+			{
+				self_update = true;
+				save_settings(); // Save everything
+			};
+		self_update_toggle->OnUnchecked =
+			[&, this](ktvr::Interface::ToggleSwitch* sender)
+			{
+				self_update = false;
+				save_settings(); // Save everything
+			};
+
+		poll_rate_hz->OnValueChanged =
 			[&, this](ktvr::Interface::NumberBox* sender, const int& new_value)
 			{
-				// Backup to writable
-				int _value = new_value;
+				const int fixed_new_value =
+					std::clamp(new_value, 60, 2000);
 
-				// Handle resets
-				if (_value < 0)_value = 11;
+				sender->Value(fixed_new_value); // Overwrite
+				poll_rate = fixed_new_value;
+
+				save_settings(); // Save everything
+			};
 
+		keep_alive_rate_hz->OnValueChanged =
+			[&, this](ktvr::Interface::NumberBox* sender, const int& new_value)
+			{
 				const int fixed_new_value =
-					std::clamp(_value, 0, 100);
+					std::clamp(new_value, 0, 240);
+
+				sender->Value(fixed_new_value); // Overwrite
+				keep_alive_rate = fixed_new_value;
+
+				save_settings(); // Save everything
+			};
+
+		extra_prediction_ms->OnValueChanged = // also taken from the owotrack plugin
+			[&, this](ktvr::Interface::NumberBox* sender, const int& new_value)
+			{
+				const int fixed_new_value =
+					std::clamp(new_value, 0, 100);
 
 				sender->Value(fixed_new_value); // Overwrite
 				extra_prediction = fixed_new_value;
@@ -121,69 +556,120 @@ public:
 	void initialize() override;
 	void update() override;
 	void shutdown() override;
-	void keepRiftAlive();
 
+	void poll_initialization();
+	void cancel_initialization();
+	void show_init_progress(bool visible, int progress, const std::wstring& stages);
+
+	// Both only queue ODT actions on the ODT worker, they never block
+	void keepRiftAlive();
+	void stop_keep_rift_alive();
+
+	// keepRiftAlive, one step per ODT worker command (see DeviceHandler.cpp)
+	void odt_restart_step();
+	void odt_launch_step();
+	void odt_focus_step();
+	void odt_toggle_step(HWND hWindowHandle);
+	void odt_check_step();
+	static void odt_poke_step();
+
+	void sync_recording();
+	void sync_stream();
+	void sample_frame(JointFrame& frame);
+	void apply_frame(const JointFrame& frame);
+	void report_counters();
+	void reset_latency_stats();
+	void run_ingest_benchmark();
+	void dump_tracking_quality();
+
+	void sync_object_joints(uint64_t connected);
+
+	// Host thread, once the watchdog saw the session die
+	void lose_session();
+
+	// 'horizons': how far past frameTime every joint's pose was predicted, s
+	static void update_joints(std::vector<ktvr::K2TrackedJoint>& joints, const JointFrame& frame,
+	                          const PoseExtrapolator::Horizons& horizons, const ObjectJointMap& objects,
+	                          JointFreshnessList& freshness, JointBatch& batch);
+
+	// Cheap enough to call on every UI change: the store writes it out later,
+	// on its own thread, once the values stop changing
 	void save_settings() // Thanks https://github.com/KimihikoAkayasaki/device_owoTrackVR
 	{
-		if (std::ofstream output(
-				ktvr::GetK2AppDataFileDir(L"Device_Rift_settings.xml"));
-			output.fail())
+		DeviceSettings settings;
+		settings.extra_prediction = extra_prediction;
+		settings.auto_prediction = auto_prediction;
+		settings.filter_mode = filter_mode;
+		settings.ODTKRAenabled = ODTKRAenabled;
+		settings.resEnabled = resEnabled;
+		settings.self_update = self_update;
+		settings.poll_rate = poll_rate;
+		settings.keep_alive_rate = keep_alive_rate;
+		settings.headless_keep_alive = headless_keep_alive;
+		settings.simulate = simulate;
+		settings.simulated_objects = simulated_objects;
+		settings.interpolation_delay = interpolation_delay;
+		settings.dead_reckoning = dead_reckoning;
+		settings.stream_poses = stream_poses;
+		settings.stream_port = stream_port;
+		settings.export_prediction = export_prediction;
 		{
-			if (logErrorMessage)
-				logErrorMessage(L"CV1 Device Error: Couldn't save settings!\n");
+			std::lock_guard lock(stream_address_mutex);
+			settings.stream_address = WStringToString(stream_address);
 		}
-		else
-		{
-			cereal::XMLOutputArchive archive(output);
-			if (logInfoMessage)
-				logInfoMessage(L"CV1 Device: Attempted to save settings\n");
 
-			try
-			{
-				archive(
-					CEREAL_NVP(extra_prediction),
-					CEREAL_NVP(ODTKRAenabled),
-					CEREAL_NVP(resEnabled)
-				);
-			}
-			catch (...)
-			{
-				if (logErrorMessage)
-					logErrorMessage(L"CV1 Device Error: Couldn't save settings, an exception occurred!\n");
-			}
-		}
+		settings_store.store(settings);
 	}
 
 	void load_settings()
 	{
-		if (std::ifstream input(
-				ktvr::GetK2AppDataFileDir(L"Device_Rift_settings.xml"));
-			input.fail())
+		settings_store.on_error = [this](std::wstring message)
 		{
+			if (logErrorMessage)
+				logErrorMessage(message);
+		};
+
+		DeviceSettings settings;
+		switch (settings_store.load(settings))
+		{
+		case SettingsStore<DeviceSettings>::Load_Missing:
 			if (logWarningMessage)
 				logWarningMessage(L"CV1 Device Error: Couldn't read settings, re-generating!\n");
 
 			save_settings(); // Re-generate the file
+			return;
+
+		case SettingsStore<DeviceSettings>::Load_Failed:
+			// Still take whatever came before the broken part
+			if (logErrorMessage)
+				logErrorMessage(L"CV1 Device Error: Couldn't read all settings, an exception occurred!\n");
+			break;
+
+		default:
+			if (logInfoMessage)
+				logInfoMessage(L"CV1 Device: Read settings\n");
+			break;
 		}
-		else
+
+		extra_prediction = settings.extra_prediction;
+		auto_prediction = settings.auto_prediction;
+		filter_mode = settings.filter_mode;
+		ODTKRAenabled = settings.ODTKRAenabled;
+		resEnabled = settings.resEnabled;
+		self_update = settings.self_update;
+		poll_rate = settings.poll_rate;
+		keep_alive_rate = settings.keep_alive_rate;
+		headless_keep_alive = settings.headless_keep_alive;
+		simulate = settings.simulate;
+		simulated_objects = settings.simulated_objects;
+		interpolation_delay = settings.interpolation_delay;
+		dead_reckoning = std::clamp(settings.dead_reckoning, 0, 2000);
+		stream_poses = settings.stream_poses;
+		stream_port = std::clamp(settings.stream_port, 1024, 65535);
+		export_prediction = std::clamp(settings.export_prediction, 0, 100);
 		{
-			if (logInfoMessage)
-				logInfoMessage(L"CV1 Device: Attempting to read settings\n");
-
-			try
-			{
-				cereal::XMLInputArchive archive(input);
-				archive(
-					CEREAL_NVP(extra_prediction),
-					CEREAL_NVP(ODTKRAenabled),
-					CEREAL_NVP(resEnabled)
-				);
-			}
-			catch (...)
-			{
-				if (logErrorMessage)
-					logErrorMessage(L"CV1 Device Error: Couldn't read settings, an exception occurred!\n");
-			}
+			std::lock_guard lock(stream_address_mutex);
+			stream_address = StringToWString(settings.stream_address);
 		}
 	}
 
@@ -201,7 +687,6 @@ public:
 			SendMessage(hWindowHandle, WM_CLOSE, 0, 0);
 			SwitchToThisWindow(hWindowHandle, true);
 		}
-		Sleep(500);
 	}
 
 
@@ -217,18 +702,23 @@ public:
 		return true;
 	}
 
-	void start_ODT(HWND& hWindowHandle, LPCWSTR& Target_window_Name)
+	void start_ODT() const
 	{
 		// Starts ODT
 		std::wstring tempstr = ODTPath + L"OculusDebugTool.exe";
 		ShellExecute(NULL, L"open", tempstr.c_str(), NULL, NULL, SW_SHOWDEFAULT);
-		Sleep(1000); // not sure if needed
+	}
 
-		hWindowHandle = FindWindow(NULL, Target_window_Name);
+	// Give ODT a moment to come up before these two
+	static HWND focus_ODT()
+	{
+		HWND hWindowHandle = FindWindow(NULL, L"Oculus Debug Tool");
 		SwitchToThisWindow(hWindowHandle, true);
+		return hWindowHandle;
+	}
 
-		Sleep(100); // not sure if needed
-
+	static void select_proximity_toggle_ODT(HWND hWindowHandle)
+	{
 		// Goes to the "Bypass Proximity Sensor Check" toggle
 		for (int i = 0; i < 7; i++)
 		{
@@ -253,15 +743,82 @@ public:
 
 	ktvr::Interface::TextBlock *test, *TestOutput;
 	ktvr::Interface::NumberBox* extra_prediction_ms;
+	ktvr::Interface::NumberBox* poll_rate_hz;
+	ktvr::Interface::NumberBox* keep_alive_rate_hz;
+	ktvr::Interface::NumberBox* simulated_objects_count;
+	ktvr::Interface::NumberBox* interpolation_delay_ms;
+	ktvr::Interface::NumberBox* dead_reckoning_ms;
+	ktvr::Interface::NumberBox* export_prediction_ms;
+	ktvr::Interface::TextBlock* acquisition_stats = nullptr;
+	ktvr::Interface::TextBlock* latency_stats = nullptr;
+	ktvr::Interface::TextBlock* joint_stats = nullptr;
+	ktvr::Interface::TextBlock* quality_stats = nullptr;
+	ktvr::Interface::TextBlock* prediction_stats = nullptr;
+	ktvr::Interface::TextBox* replay_path;
+	ktvr::Interface::ProgressRing* init_ring = nullptr;
+	ktvr::Interface::ProgressBar* init_progress = nullptr;
+	ktvr::Interface::TextBlock* init_status = nullptr;
+	ktvr::Interface::Button* init_cancel = nullptr;
 
 	int extra_prediction = 11;
+
+	// Frames come from the SDK as of now (horizon 0), PredictionTuner picks every joint its own horizon
+	// so they land 'extra_prediction' ms ahead; off: all of them by that
+	// Either way PoseExtrapolator predicts them, the SDK is asked once per frame
+	bool auto_prediction = true;
+
+	std::atomic<int> filter_mode = 0; // PoseFilterBank::Mode, UI thread writes, sampling reads
 	bool ODTKRAenabled = false;
 	bool resEnabled = true;
 
+	// Poll LibOVR on our own thread instead of inside update()
+	bool self_update = false;
+	int poll_rate = 500;
+
+	// Compositor keep-alive submissions per second, 0 = only when needed
+	int keep_alive_rate = 90;
+	bool headless_keep_alive = false;
+
+	// Procedural poses instead of LibOVR (SimulatedPoseSource), applies on Refresh
+	bool simulate = false;
+	int simulated_objects = 4;
+
+	// Apply poses interpolated from PoseHistory this far in the past, on a 1 ms grid
+	// Evenly spaced poses no matter how irregular update() gets, 0 = off
+	int interpolation_delay = 0;
+
+	// Joints that lose tracking are extrapolated (DeadReckoning.h) and reported inferred for
+	// this many ms, then not tracked; 0 = not tracked right away
+	int dead_reckoning = 250;
+
+	// Stream applied poses over UDP (PoseStream.h), '127.0.0.1' keeps them on this machine
+	bool stream_poses = false;
+	int stream_port = 7755;
+	std::wstring stream_address = L"127.0.0.1";
+	std::mutex stream_address_mutex;
+	std::atomic<bool> stream_changed = false; // Address/port edited, reopen
+
+	// Shared memory and the stream get their own horizon out of the same frame Amethyst's
+	// comes from (PoseExtrapolator.h), ms; 0 = poses as sampled
+	int export_prediction = 0;
+
+	// Pose recording / replay, not saved
+	// UI thread writes, host and sampling threads read
+	std::atomic<bool> record_poses = false;
+	std::atomic<int> replay_pacing = 0; // PoseReplay::Pacing
+	std::wstring replay_file;
+	std::mutex replay_file_mutex;
+
 	//RegGetValueW(HKEY_LOCAL_MACHINE, L"SOFTWARE\\WOW6432Node\\Oculus VR, LLC\\Oculus", L"Base", RRF_RT_ANY, NULL, (PVOID)&value, &BufferSize);
 	std::wstring ODTPath = L"Test";
 
-	HRESULT m_result = E_NOT_STARTED;
+	// Written by whoever finishes the start-up, see poll_initialization()
+	std::atomic<HRESULT> m_result = E_NOT_STARTED;
+
+	SettingsStore<DeviceSettings> settings_store{
+		ktvr::GetK2AppDataFileDir(L"Device_Rift_settings.xml"),
+		ktvr::GetK2AppDataFileDir(L"Device_Rift_settings.bin")
+	};
 };
 
 /* Exported for dynamic linking */
@@ -0,0 +1,142 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "BenchmarkSetup.h"
+#include "PoseExtrapolator.h"
+#include "SimulatedPoseSource.h"
+
+// Local extrapolation from one horizon 0 frame, against asking the 'SDK'
+// (SimulatedPoseSource) for that horizon itself
+struct ExtrapolationBenchmarkResult
+{
+	double horizonMs = 0.0;
+	uint32_t joints = 0;
+	uint32_t frames = 0;
+
+	double positionMm = 0.0; // Mean |local - SDK|
+	double worstPositionMm = 0.0;
+	double angleDeg = 0.0;
+	double worstAngleDeg = 0.0;
+
+	double loadNs = 0.0; // Once per frame, however many horizons
+	double batchNs = 0.0; // Per horizon
+	double scalarNs = 0.0; // The same, one joint at a time
+};
+
+// What PoseExtrapolator does, joint by joint, to time it against
+inline void extrapolate_scalar(const JointFrame& frame, const float h, JointFrame& out)
+{
+	out = frame;
+	for (uint32_t i = 0; i < frame.jointCount; i++)
+	{
+		JointSample& sample = out.joints[i];
+		Eigen::Map<Eigen::Vector3f>(sample.position) +=
+			Eigen::Map<const Eigen::Vector3f>(sample.linearVelocity) * h +
+			Eigen::Map<const Eigen::Vector3f>(sample.linearAcceleration) * (0.5f * h * h);
+
+		const Eigen::Map<const Eigen::Vector3f> spin(sample.angularVelocity);
+		Eigen::Map<Eigen::Quaternionf> orientation(sample.orientation);
+		if (const float angle = spin.norm() * h; angle > 1e-9f)
+			orientation = Eigen::Quaternionf(Eigen::AngleAxisf(angle, spin.normalized())) * orientation;
+		orientation.normalize();
+	}
+}
+
+// Every horizon for 2 and 66 joints: 'compare' frames extrapolated locally vs. predicted by
+// the simulated SDK at the same time, then the cost of doing it ('setup.frames' rounds)
+inline std::vector<ExtrapolationBenchmarkResult> benchmark_extrapolation(const BenchmarkSetup& setup,
+                                                                         const uint32_t compare = 2000)
+{
+	using clock = std::chrono::steady_clock;
+	std::vector<ExtrapolationBenchmarkResult> results;
+
+	for (const uint32_t joints : {2u, max_frame_joints})
+		for (const double horizon : {0.0, 0.011, 0.02, 0.05})
+		{
+			SimulationSettings settings;
+			settings.objects = joints - 2;
+			settings.orbitSpeed = 3.0;
+			settings.spinSpeed = 3.0;
+			settings.dropoutEvery = 0.0;
+
+			SimulatedPoseSource local(settings), sdk(settings);
+			local.set_fixed_step(0.001);
+			sdk.set_fixed_step(0.001);
+			const uint64_t objects = first_object_slots(settings.objects);
+
+			ExtrapolationBenchmarkResult& result = results.emplace_back();
+			result.horizonMs = horizon * 1000.0;
+			result.joints = joints;
+			result.frames = compare;
+
+			PoseExtrapolator extrapolator;
+			JointFrame frame, predicted, expected;
+			std::vector<JointFrame> recorded;
+
+			for (uint32_t n = 0; n < compare; n++)
+			{
+				acquire_frame(local, frame, 0.0, objects);
+				acquire_frame(sdk, expected, horizon, objects);
+				if (recorded.size() < 64) recorded.push_back(frame);
+
+				extrapolator.load(frame);
+				extrapolator.extrapolate(static_cast<float>(horizon), predicted);
+
+				for (uint32_t i = 0; i < frame.jointCount; i++)
+				{
+					const double position = (Eigen::Map<const Eigen::Vector3f>(predicted.joints[i].position) -
+						Eigen::Map<const Eigen::Vector3f>(expected.joints[i].position)).norm() * 1000.0;
+					const double angle = Eigen::Quaterniond(
+						Eigen::Map<const Eigen::Quaternionf>(predicted.joints[i].orientation).cast<double>()).angularDistance(
+						Eigen::Quaterniond(Eigen::Map<const Eigen::Quaternionf>(expected.joints[i].orientation).cast<double>())
+						.normalized()) * 180.0 / 3.14159265358979;
+
+					result.positionMm += position;
+					result.worstPositionMm = std::max<double>(result.worstPositionMm, position);
+					result.angleDeg += angle;
+					result.worstAngleDeg = std::max<double>(result.worstAngleDeg, angle);
+				}
+			}
+			result.positionMm /= static_cast<double>(compare) * joints;
+			result.angleDeg /= static_cast<double>(compare) * joints;
+
+			const auto time = [&](const auto& run)
+			{
+				for (const JointFrame& sample : recorded) run(sample); // Warm up
+
+				const auto start = clock::now();
+				for (uint32_t i = 0; i < setup.frames; i++)
+					run(recorded[i % recorded.size()]);
+
+				return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+					clock::now() - start).count()) / setup.frames;
+			};
+
+			const auto h = static_cast<float>(horizon);
+			result.loadNs = time([&](const JointFrame& sample) { extrapolator.load(sample); });
+			result.batchNs = time([&](const JointFrame&) { extrapolator.extrapolate(h, predicted); });
+			result.scalarNs = time([&](const JointFrame& sample) { extrapolate_scalar(sample, h, predicted); });
+		}
+	return results;
+}
+
+inline std::string to_json(const ExtrapolationBenchmarkResult& result)
+{
+	char json[384];
+	std::snprintf(json, sizeof(json),
+	              "{\"horizon_ms\": %.0f, \"joints\": %u, \"frames\": %u, "
+	              "\"position_mm\": %.4f, \"worst_position_mm\": %.4f, "
+	              "\"angle_deg\": %.4f, \"worst_angle_deg\": %.4f, "
+	              "\"load_ns\": %.1f, \"batch_ns\": %.1f, \"scalar_ns\": %.1f}",
+	              result.horizonMs, result.joints, result.frames,
+	              result.positionMm, result.worstPositionMm, result.angleDeg, result.worstAngleDeg,
+	              result.loadNs, result.batchNs, result.scalarNs);
+	return json;
+}
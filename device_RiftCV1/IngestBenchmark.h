@@ -0,0 +1,108 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "BenchmarkSetup.h"
+
+// Pose ingestion benchmark: acquisition against the setup's source, then smoothing
+// and the joint update exactly like the plugin does it, for 2 hands + 0..64 VR Objects
+struct IngestBenchmarkResult
+{
+	uint32_t objects = 0;
+	bool prediction = false;
+	uint32_t frames = 0;
+
+	double nsPerFrame = 0.0;
+	double acquireNs = 0.0;
+	double filterNs = 0.0;
+	double applyNs = 0.0;
+
+	double sdkCallsPerFrame = 0.0;
+	double allocationsPerFrame = -1.0; // < 0: couldn't be measured
+};
+
+inline std::vector<IngestBenchmarkResult> benchmark_ingest(const BenchmarkSetup& setup)
+{
+	using clock = std::chrono::steady_clock;
+	std::vector<IngestBenchmarkResult> results;
+
+	for (const uint32_t objects : {0u, 1u, 2u, 4u, 8u, 16u, 32u, 64u})
+		for (const bool predict : {false, true})
+		{
+			const std::unique_ptr<IPoseSource> source = setup.make_source(objects);
+			const double prediction = predict ? setup.prediction : 0.0;
+			JointFrame frame;
+
+			// Warm up caches and let the filter settle
+			for (int i = 0; i < 100; i++)
+			{
+				acquire_frame(*source, frame, prediction, first_object_slots(objects));
+				if (setup.filter) setup.filter(frame);
+				if (setup.apply) setup.apply(frame);
+			}
+
+			uint64_t calls = 0;
+			const uint64_t allocations_before = setup.allocations ? setup.allocations() : 0;
+
+			clock::duration acquiring{}, filtering{}, applying{};
+			for (uint32_t i = 0; i < setup.frames; i++)
+			{
+				const auto start = clock::now();
+				acquire_frame(*source, frame, prediction, first_object_slots(objects));
+				const auto acquired = clock::now();
+				calls += frame.sdkCalls;
+				if (setup.filter) setup.filter(frame);
+				const auto filtered = clock::now();
+				if (setup.apply) setup.apply(frame);
+				const auto applied = clock::now();
+
+				acquiring += acquired - start;
+				filtering += filtered - acquired;
+				applying += applied - filtered;
+			}
+
+			IngestBenchmarkResult& result = results.emplace_back();
+			result.objects = objects;
+			result.prediction = predict;
+			result.frames = setup.frames;
+
+			const auto per_frame = [&setup](const clock::duration total)
+			{
+				return static_cast<double>(std::chrono::duration_cast<
+					std::chrono::nanoseconds>(total).count()) / setup.frames;
+			};
+
+			result.acquireNs = per_frame(acquiring);
+			result.filterNs = per_frame(filtering);
+			result.applyNs = per_frame(applying);
+			result.nsPerFrame = result.acquireNs + result.filterNs + result.applyNs;
+
+			result.sdkCallsPerFrame = static_cast<double>(calls) / setup.frames;
+			if (setup.allocations)
+				result.allocationsPerFrame =
+					static_cast<double>(setup.allocations() - allocations_before) / setup.frames;
+		}
+
+	return results;
+}
+
+inline std::string to_json(const IngestBenchmarkResult& result)
+{
+	char allocations[32] = "null";
+	if (result.allocationsPerFrame >= 0.0)
+		std::snprintf(allocations, sizeof(allocations), "%.2f", result.allocationsPerFrame);
+
+	char json[512];
+	std::snprintf(json, sizeof(json),
+	              "{\"objects\": %u, \"prediction\": %s, \"frames\": %u, "
+	              "\"ns_per_frame\": %.1f, \"acquire_ns\": %.1f, \"filter_ns\": %.1f, \"apply_ns\": %.1f, "
+	              "\"sdk_calls_per_frame\": %.2f, \"allocations_per_frame\": %s}",
+	              result.objects, result.prediction ? "true" : "false", result.frames,
+	              result.nsPerFrame, result.acquireNs, result.filterNs, result.applyNs,
+	              result.sdkCallsPerFrame, allocations);
+	return json;
+}
@@ -0,0 +1,323 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Start-up as a set of stages with dependencies, run off the caller's thread
+// A stage starts once everything it depends on went through, stages that don't depend
+// on each other run at the same time (each on its own thread). 'Pinned' stages run on
+// the sequence's home thread instead, one after another; it stays up until stop(), so
+// anything bound to the thread that created it (windows) outlives the start-up
+class InitSequence
+{
+public:
+	using StageId = size_t;
+
+	enum State
+	{
+		Init_Idle,
+		Init_Running,
+		Init_Succeeded,
+		Init_Failed, // A stage returned false or threw, whatever depended on it never ran
+		Init_Cancelled
+	};
+
+	struct StageTiming
+	{
+		std::wstring name;
+		double milliseconds = 0.0;
+		bool succeeded = false;
+	};
+
+	~InitSequence() { stop(); }
+
+	// Called every 'idle_interval' on the home thread while it has nothing to do,
+	// e.g. to pump the messages of a window a pinned stage created
+	std::function<void()> idle;
+	std::chrono::milliseconds idle_interval{50};
+
+	// Only while nothing's running
+	StageId add(std::wstring name, std::function<bool()> run,
+	            std::vector<StageId> after = {}, const bool pinned = false)
+	{
+		std::lock_guard lock(mMutex);
+		mStages.push_back({std::move(name), std::move(run), std::move(after), pinned});
+		return mStages.size() - 1;
+	}
+
+	void start()
+	{
+		stop();
+
+		std::lock_guard lock(mMutex);
+		for (Stage& stage : mStages)
+		{
+			stage.status = Stage::Pending;
+			stage.milliseconds = 0.0;
+		}
+		mCancel = false;
+		mStop = false;
+		mRunning = 0;
+		mState = Init_Running;
+		mThread = std::thread([this] { home_loop(); });
+	}
+
+	// Nothing new starts, stages already running still finish (SDK calls can't be interrupted)
+	void cancel()
+	{
+		{
+			std::lock_guard lock(mMutex);
+			mCancel = true;
+			mEvents++;
+		}
+		mWake.notify_all();
+	}
+
+	// Cancels, waits for whatever's running, then lets the home thread go
+	// Tear down anything pinned stages created before this
+	void stop()
+	{
+		{
+			std::lock_guard lock(mMutex);
+			mCancel = true;
+			mStop = true;
+			mEvents++;
+		}
+		mWake.notify_all();
+
+		if (mThread.joinable())
+			mThread.join();
+	}
+
+	// Until every stage that's going to run has, the home thread stays up
+	void wait()
+	{
+		std::unique_lock lock(mMutex);
+		mWake.wait(lock, [this] { return mState != Init_Running; });
+	}
+
+	// Drops all stages, only while stopped
+	void clear()
+	{
+		stop();
+
+		std::lock_guard lock(mMutex);
+		mStages.clear();
+		mState = Init_Idle;
+	}
+
+	// For stages to check between their own steps
+	[[nodiscard]] bool cancelled() const
+	{
+		std::lock_guard lock(mMutex);
+		return mCancel;
+	}
+
+	[[nodiscard]] State state() const
+	{
+		std::lock_guard lock(mMutex);
+		return mState;
+	}
+
+	// Finished stages out of all, 0-100
+	[[nodiscard]] int progress() const
+	{
+		std::lock_guard lock(mMutex);
+		if (mStages.empty()) return 0;
+
+		size_t done = 0;
+		for (const Stage& stage : mStages)
+			if (stage.status == Stage::Succeeded || stage.status == Stage::Failed)
+				done++;
+		return static_cast<int>(done * 100 / mStages.size());
+	}
+
+	// "runtime, window" etc.
+	[[nodiscard]] std::wstring running_stages() const
+	{
+		std::lock_guard lock(mMutex);
+		return names_of(Stage::Running);
+	}
+
+	[[nodiscard]] std::wstring failed_stages() const
+	{
+		std::lock_guard lock(mMutex);
+		return names_of(Stage::Failed);
+	}
+
+	// Every stage that ran, in the order they were added
+	[[nodiscard]] std::vector<StageTiming> timings() const
+	{
+		std::lock_guard lock(mMutex);
+
+		std::vector<StageTiming> timings;
+		for (const Stage& stage : mStages)
+			if (stage.status == Stage::Succeeded || stage.status == Stage::Failed)
+				timings.push_back({stage.name, stage.milliseconds, stage.status == Stage::Succeeded});
+		return timings;
+	}
+
+	// Wall clock from start() until the last stage finished
+	[[nodiscard]] double total_milliseconds() const
+	{
+		std::lock_guard lock(mMutex);
+		return mTotal;
+	}
+
+private:
+	using clock = std::chrono::steady_clock;
+
+	struct Stage
+	{
+		std::wstring name;
+		std::function<bool()> run;
+		std::vector<StageId> after;
+		bool pinned = false;
+
+		enum Status { Pending, Running, Succeeded, Failed } status = Pending;
+		double milliseconds = 0.0;
+	};
+
+	// Everything it depends on went through
+	[[nodiscard]] bool ready(const Stage& stage) const
+	{
+		if (stage.status != Stage::Pending) return false;
+		for (const StageId id : stage.after)
+			if (id >= mStages.size() || mStages[id].status != Stage::Succeeded)
+				return false;
+		return true;
+	}
+
+	[[nodiscard]] std::wstring names_of(const Stage::Status status) const
+	{
+		std::wstring names;
+		for (const Stage& stage : mStages)
+			if (stage.status == status)
+				names += (names.empty() ? L"" : L", ") + stage.name;
+		return names;
+	}
+
+	// With the lock held on the way in and out, never while the stage runs
+	void run_stage(std::unique_lock<std::mutex>& lock, const StageId id)
+	{
+		const std::function<bool()>& run = mStages[id].run;
+		lock.unlock();
+
+		const auto start = clock::now();
+		bool succeeded = false;
+		try
+		{
+			succeeded = run();
+		}
+		catch (...)
+		{
+		}
+		const auto took = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+		lock.lock();
+		mStages[id].status = succeeded ? Stage::Succeeded : Stage::Failed;
+		mStages[id].milliseconds = took;
+	}
+
+	void home_loop()
+	{
+		const auto started = clock::now();
+		std::vector<std::thread> helpers;
+
+		std::unique_lock lock(mMutex);
+		while (true)
+		{
+			bool failed = false;
+			for (const Stage& stage : mStages)
+				failed |= stage.status == Stage::Failed;
+
+			// Nothing new once something failed or we were told to stop
+			StageId pinned = mStages.size();
+			if (!mCancel && !failed)
+				for (StageId id = 0; id < mStages.size(); id++)
+				{
+					if (!ready(mStages[id])) continue;
+
+					if (mStages[id].pinned)
+					{
+						if (pinned == mStages.size())
+							pinned = id;
+						continue;
+					}
+
+					mStages[id].status = Stage::Running;
+					mRunning++;
+					helpers.emplace_back([this, id]
+					{
+						std::unique_lock helper_lock(mMutex);
+						run_stage(helper_lock, id);
+						mRunning--;
+						mEvents++;
+						helper_lock.unlock();
+						mWake.notify_all();
+					});
+				}
+
+			if (pinned != mStages.size())
+			{
+				mStages[pinned].status = Stage::Running;
+				run_stage(lock, pinned);
+				continue;
+			}
+
+			if (mRunning == 0) break; // Done, or stuck behind a failed stage
+			wait_idle(lock);
+		}
+
+		// Settle the outcome
+		bool failed = false, complete = true;
+		for (const Stage& stage : mStages)
+		{
+			failed |= stage.status == Stage::Failed;
+			complete &= stage.status == Stage::Succeeded;
+		}
+		mState = failed ? Init_Failed : complete ? Init_Succeeded : Init_Cancelled;
+		mTotal = std::chrono::duration<double, std::milli>(clock::now() - started).count();
+
+		lock.unlock();
+		mWake.notify_all(); // wait()
+		for (std::thread& helper : helpers)
+			helper.join();
+		lock.lock();
+
+		// Stay up for whatever pinned stages left behind
+		while (!mStop)
+			wait_idle(lock);
+	}
+
+	// Until something happens, pumping 'idle' meanwhile
+	void wait_idle(std::unique_lock<std::mutex>& lock)
+	{
+		const uint64_t seen = mEvents;
+		if (idle)
+		{
+			lock.unlock();
+			idle();
+			lock.lock();
+		}
+		mWake.wait_for(lock, idle_interval, [this, seen] { return mEvents != seen; });
+	}
+
+	std::vector<Stage> mStages;
+
+	mutable std::mutex mMutex;
+	std::condition_variable mWake;
+	std::thread mThread;
+
+	bool mCancel = false;
+	bool mStop = false;
+	size_t mRunning = 0;
+	uint64_t mEvents = 0; // Stage finished, cancel or stop
+	State mState = Init_Idle;
+	double mTotal = 0.0;
+};
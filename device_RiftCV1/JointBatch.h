@@ -0,0 +1,83 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+
+#include <Eigen/Dense>
+
+#include "JointFrame.h"
+
+// Turns a frame's float samples into what the joints store (doubles), joint by joint:
+// widen, normalize orientations, keep every orientation on the same hemisphere as the
+// last one of that joint, then hand each pose to the caller to write straight into its joint
+// Prediction isn't done here, PoseExtrapolator already moved the frame's poses
+class JointBatch
+{
+public:
+	enum Channel
+	{
+		Position, // xyz: 0-2
+		Orientation = 3, // xyzw: 3-6
+		LinearVelocity = 7,
+		LinearAcceleration = 10,
+		AngularVelocity = 13,
+		AngularAcceleration = 16,
+		ChannelCount = 19
+	};
+
+	using Pose = Eigen::Array<double, ChannelCount, 1>;
+
+	static_assert(offsetof(JointSample, orientation) == Orientation * sizeof(float) &&
+		offsetof(JointSample, linearVelocity) == LinearVelocity * sizeof(float) &&
+		offsetof(JointSample, linearAcceleration) == LinearAcceleration * sizeof(float) &&
+		offsetof(JointSample, angularVelocity) == AngularVelocity * sizeof(float) &&
+		offsetof(JointSample, angularAcceleration) == AngularAcceleration * sizeof(float));
+
+	JointBatch() { reset(); }
+
+	// Forgets the previous orientations, e.g. after joints moved around
+	void reset()
+	{
+		mPrevious.setZero();
+		mPrevious.row(3).setOnes();
+	}
+
+	// 'write': void(uint32_t index, const Pose& pose) for every joint of the frame
+	template <class Write>
+	void convert(const JointFrame& frame, Write&& write)
+	{
+		// Joints moved around, the previous orientations belong to someone else now
+		if (frame.objectMask != mObjectMask || frame.jointCount != mJointCount)
+		{
+			reset();
+			mObjectMask = frame.objectMask;
+			mJointCount = frame.jointCount;
+		}
+
+		for (uint32_t i = 0; i < frame.jointCount; i++)
+		{
+			// A sample's channels are one run of floats, widened in one go
+			Pose pose = Eigen::Map<const Eigen::Array<float, ChannelCount, 1>>(
+				frame.joints[i].position).cast<double>();
+			auto orientation = pose.segment<4>(Orientation);
+
+			// Normalize, an all-zero orientation becomes identity
+			const double norm = std::sqrt(orientation.square().sum());
+			if (norm < 1e-12)
+				orientation << 0.0, 0.0, 0.0, 1.0;
+			else
+				orientation /= norm;
+
+			// Same hemisphere as last time, so nothing downstream sees a sign flip
+			if ((orientation * mPrevious.col(i)).sum() < 0.0)
+				orientation = -orientation;
+
+			mPrevious.col(i) = orientation;
+			write(i, pose);
+		}
+	}
+
+private:
+	Eigen::Array<double, 4, max_frame_joints> mPrevious; // Last orientation of every joint, xyzw
+	uint32_t mJointCount = 0;
+	uint64_t mObjectMask = 0;
+};
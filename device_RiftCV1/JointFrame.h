@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+
+#include "ClockMapper.h"
+
+// Plain copy of what LibOVR gives us for a single tracked device,
+// kept free of any SDK/Windows types so it can be shuffled between threads
+// (and compiled outside of the plugin) without dragging OVR_CAPI along
+
+struct JointSample
+{
+	float position[3] = {0.f, 0.f, 0.f};
+	float orientation[4] = {0.f, 0.f, 0.f, 1.f}; // x, y, z, w (LibOVR order)
+
+	float linearVelocity[3] = {0.f, 0.f, 0.f};
+	float linearAcceleration[3] = {0.f, 0.f, 0.f};
+	float angularVelocity[3] = {0.f, 0.f, 0.f};
+	float angularAcceleration[3] = {0.f, 0.f, 0.f};
+
+	double sampleTime = 0.0; // ovrPoseStatef::TimeInSeconds
+	uint32_t statusFlags = 0; // ovrStatusBits
+};
+
+// ovrStatusBits, without LibOVR
+constexpr uint32_t status_orientation_tracked = 0x1;
+constexpr uint32_t status_position_tracked = 0x2;
+
+// Touch controllers + VR Objects
+constexpr uint32_t max_frame_joints = 2 + 64;
+
+// One complete set of joints, all sampled in the same pass
+struct JointFrame
+{
+	uint64_t sequence = 0; // Bumped by the producer on every frame
+	double frameTime = 0.0; // Time the poses were requested for (SDK clock)
+	long long hostTimestamp = 0; // AME_API_GET_TIMESTAMP_NOW at acquisition
+
+	// One clock reading pair: the SDK clock, read between the two host readings
+	double sdkTime = 0.0;
+	long long hostBefore = 0;
+
+	// SDK -> host time, as of this frame (sampleTime -> joint timestamps)
+	ClockMapping clock;
+
+	uint32_t sdkCalls = 0; // LibOVR calls it took to acquire this frame
+	uint32_t acquireNanoseconds = 0; // How long acquiring it took
+	uint32_t filterNanoseconds = 0; // How long smoothing it took
+
+	uint32_t jointCount = 0;
+	uint64_t objectMask = 0; // VR Object slots in joints[2..], lowest set bit first
+	JointSample joints[max_frame_joints];
+};
+
+// Slots 0..count-1, i.e. 'count' VR Objects numbered like they used to be
+inline uint64_t first_object_slots(const uint32_t count)
+{
+	return count >= 64 ? ~0ull : (1ull << count) - 1;
+}
+
+// Host time a joint's pose is for: the frame's time plus however far it got predicted past
+// that (poses are moved, sample times aren't); 'fallback' until the clocks are mapped
+inline long long pose_host_time(const JointFrame& frame, const double horizon, const long long fallback)
+{
+	return frame.clock.valid ? frame.clock.to_host(frame.frameTime + horizon) : fallback;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <Eigen/Dense>
+
+#include "JointFrame.h"
+
+// For code that runs the same handful of ops over every joint (or device) at once:
+// one float lane per joint, every component of a pose one contiguous row of lanes
+namespace joint_lanes
+{
+	constexpr int count = max_frame_joints;
+
+	using Lanes = Eigen::Array<float, count, 1>;
+
+	template <int Rows>
+	using Channels = Eigen::Array<float, Rows, count, Eigen::RowMajor>;
+
+	// One component of every lane as a plain Lanes expression
+	// Whole-matrix rowwise()/colwise() ops over Channels don't vectorize, a loop over rows does
+	template <int Rows>
+	Eigen::Map<Lanes> row(Channels<Rows>& channels, const int component)
+	{
+		return Eigen::Map<Lanes>(&channels(component, 0));
+	}
+
+	template <int Rows>
+	Eigen::Map<const Lanes> row(const Channels<Rows>& channels, const int component)
+	{
+		return Eigen::Map<const Lanes>(&channels(component, 0));
+	}
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdint>
+
+// Graphics calls needed to set up the keep-alive eye targets
+// Implemented by GuardianSystem on top of LibOVR + D3D11, can be faked to check allocations
+class IKeepAliveGraphics
+{
+public:
+	virtual ~IKeepAliveGraphics() = default;
+
+	// Creates the eye's color swap chain + render target views
+	// Returns the number of textures in the chain, 0 on failure
+	virtual int create_color_chain(int eye, int width, int height) = 0;
+
+	// Creates the eye's depth target, returns false on failure
+	virtual bool create_depth_target(int eye, int width, int height) = 0;
+};
+
+// Sets up keep-alive targets for both eyes and keeps track of what it cost
+// Headless mode: we never draw anything, so use the smallest chains we can,
+// no depth and no per-frame clears
+class KeepAliveTargets
+{
+public:
+	static constexpr int eye_count = 2;
+
+	// Small enough not to matter, big enough for the compositor not to complain
+	static constexpr int headless_size = 16;
+
+	static constexpr uint64_t color_bytes_per_pixel = 4; // R8G8B8A8
+	static constexpr uint64_t depth_bytes_per_pixel = 4; // D32
+
+	struct EyeTarget
+	{
+		int width = 0;
+		int height = 0;
+		int textureCount = 0;
+		bool hasDepth = false;
+	};
+
+	// ideal_sizes: { width, height } per eye, as ovr_GetFovTextureSize reports them
+	bool create(IKeepAliveGraphics& graphics, const int ideal_sizes[eye_count][2], const bool headless)
+	{
+		mHeadless = headless;
+		mAllocatedBytes = 0;
+
+		bool success = true;
+		for (int i = 0; i < eye_count; ++i)
+		{
+			EyeTarget& target = mEyes[i];
+			target.width = headless ? headless_size : ideal_sizes[i][0];
+			target.height = headless ? headless_size : ideal_sizes[i][1];
+
+			const uint64_t pixels = static_cast<uint64_t>(target.width) * target.height;
+
+			target.textureCount = graphics.create_color_chain(i, target.width, target.height);
+			success &= target.textureCount > 0;
+			mAllocatedBytes += pixels * color_bytes_per_pixel * target.textureCount;
+
+			target.hasDepth = !headless && graphics.create_depth_target(i, target.width, target.height);
+			if (target.hasDepth)
+				mAllocatedBytes += pixels * depth_bytes_per_pixel;
+			else
+				success &= headless;
+		}
+
+		return success;
+	}
+
+	[[nodiscard]] const EyeTarget& eye(const int i) const { return mEyes[i]; }
+	[[nodiscard]] bool headless() const { return mHeadless; }
+	[[nodiscard]] bool needs_clear() const { return !mHeadless; }
+	[[nodiscard]] uint64_t allocated_bytes() const { return mAllocatedBytes; }
+
+private:
+	EyeTarget mEyes[eye_count];
+	bool mHeadless = false;
+	uint64_t mAllocatedBytes = 0;
+};
@@ -0,0 +1,219 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+
+#include "MappedFile.h"
+
+// Fixed-memory log-linear latency histogram, safe to record into from any thread
+// Each power of two is split into 16 linear sub-buckets (~6% resolution)
+class LatencyHistogram
+{
+public:
+	static constexpr int sub_bucket_bits = 4;
+	static constexpr int sub_buckets = 1 << sub_bucket_bits;
+	static constexpr int magnitudes = 40; // Up to ~2^40 ns, that's 18 minutes
+	static constexpr int bucket_count = sub_buckets * (magnitudes + 1);
+
+	void record(const uint64_t nanoseconds)
+	{
+		mBuckets[bucket_of(nanoseconds)].fetch_add(1, std::memory_order_relaxed);
+		mCount.fetch_add(1, std::memory_order_relaxed);
+
+		uint64_t max = mMax.load(std::memory_order_relaxed);
+		while (nanoseconds > max &&
+			!mMax.compare_exchange_weak(max, nanoseconds, std::memory_order_relaxed))
+		{
+		}
+	}
+
+	void reset()
+	{
+		for (auto& bucket : mBuckets)
+			bucket.store(0, std::memory_order_relaxed);
+		mCount.store(0, std::memory_order_relaxed);
+		mMax.store(0, std::memory_order_relaxed);
+	}
+
+	[[nodiscard]] uint64_t count() const { return mCount.load(std::memory_order_relaxed); }
+	[[nodiscard]] uint64_t peak() const { return mMax.load(std::memory_order_relaxed); }
+
+	// Upper bound of the bucket containing the given quantile (0-1)
+	[[nodiscard]] uint64_t percentile(const double quantile) const
+	{
+		uint64_t total = 0;
+		for (const auto& bucket : mBuckets)
+			total += bucket.load(std::memory_order_relaxed);
+		if (total == 0) return 0;
+
+		const auto target = static_cast<uint64_t>(quantile * static_cast<double>(total - 1)) + 1;
+
+		// The last bucket also holds everything past it, only the peak bounds that one
+		uint64_t seen = 0;
+		for (int i = 0; i < bucket_count - 1; i++)
+		{
+			seen += mBuckets[i].load(std::memory_order_relaxed);
+			if (seen >= target)
+				return std::min<uint64_t>(upper_bound_of(i), peak());
+		}
+		return peak();
+	}
+
+private:
+	static int bucket_of(const uint64_t value)
+	{
+		if (value < sub_buckets)
+			return static_cast<int>(value);
+
+		const int magnitude = std::bit_width(value) - sub_bucket_bits; // >= 1
+		if (magnitude > magnitudes)
+			return bucket_count - 1;
+
+		const auto sub_bucket = static_cast<int>(value >> (magnitude - 1)) - sub_buckets;
+		return magnitude * sub_buckets + sub_bucket;
+	}
+
+	static uint64_t upper_bound_of(const int bucket)
+	{
+		const int magnitude = bucket / sub_buckets;
+		const int sub_bucket = bucket % sub_buckets;
+
+		if (magnitude == 0)
+			return static_cast<uint64_t>(sub_bucket);
+
+		return (static_cast<uint64_t>(sub_buckets + sub_bucket + 1) << (magnitude - 1)) - 1;
+	}
+
+	std::array<std::atomic<uint64_t>, bucket_count> mBuckets{};
+	std::atomic<uint64_t> mCount{0};
+	std::atomic<uint64_t> mMax{0};
+};
+
+// Where the time goes in one update
+enum LatencyStage
+{
+	Stage_Update, // All of DeviceHandler::update()
+	Stage_Interval, // From one update() to the next
+	Stage_TrackingState, // ovr_GetTrackingState
+	Stage_DevicePoses, // ovr_GetDevicePoses for the VR Objects
+	Stage_Filter, // PoseFilterBank
+	Stage_JointUpdate, // K2TrackedJoint::update for all joints
+	Stage_Submit, // Keep-alive frame submission (own thread)
+	Stage_SampleAge, // Frame acquisition to being applied
+	Stage_Prediction, // Tuning, interpolation, dead reckoning and extrapolation of a frame
+	Stage_Export, // Shared memory poses and the pose stream
+	Stage_Count
+};
+
+inline const char* latency_stage_name(const int stage)
+{
+	constexpr const char* names[Stage_Count] = {
+		"update", "interval", "tracking_state", "device_poses",
+		"filter", "joint_update", "submit", "sample_age",
+		"prediction", "export"
+	};
+	return names[stage];
+}
+
+// Latency counters file (.cv1stats), for dashboards polling from outside
+// 'generation' is odd while the plugin writes, readers retry until they see
+// the same even value before and after copying the stages
+struct LatencyCountersHeader
+{
+	char magic[8] = {'C', 'V', '1', 'S', 'T', 'A', 'T', 'S'};
+	uint32_t version = 1;
+	uint32_t stageCount = Stage_Count;
+	uint64_t generation = 0;
+	long long updatedAt = 0; // AME_API_GET_TIMESTAMP_NOW (us)
+};
+
+struct LatencyCountersStage
+{
+	char name[32] = {};
+	uint64_t count = 0;
+	uint64_t p50 = 0; // ns
+	uint64_t p99 = 0; // ns
+	uint64_t max = 0; // ns
+};
+
+// One histogram per stage, plus the exported counters file
+class LatencyStats
+{
+public:
+	using clock = std::chrono::steady_clock;
+
+	LatencyHistogram& operator[](const LatencyStage stage) { return mStages[stage]; }
+	const LatencyHistogram& operator[](const LatencyStage stage) const { return mStages[stage]; }
+
+	void record(const LatencyStage stage, const clock::time_point start, const clock::time_point end)
+	{
+		mStages[stage].record(static_cast<uint64_t>(
+			std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+	}
+
+	void reset()
+	{
+		for (auto& stage : mStages)
+			stage.reset();
+	}
+
+	bool open_export(const std::filesystem::path& path)
+	{
+		if (!mExport.open(path, sizeof(LatencyCountersHeader) +
+		                  sizeof(LatencyCountersStage) * Stage_Count, true))
+			return false;
+
+		*header() = LatencyCountersHeader{};
+		for (int i = 0; i < Stage_Count; i++)
+		{
+			stages()[i] = LatencyCountersStage{};
+			std::strncpy(stages()[i].name, latency_stage_name(i), sizeof(LatencyCountersStage::name) - 1);
+		}
+		return true;
+	}
+
+	void close_export() { mExport.close(); }
+
+	// Call every now and then (not per frame, percentiles walk all the buckets)
+	void publish(const long long timestamp)
+	{
+		if (!mExport.is_open()) return;
+
+		std::atomic_ref<uint64_t> generation(header()->generation);
+		const uint64_t current = generation.load(std::memory_order_relaxed);
+
+		generation.store(current + 1, std::memory_order_relaxed); // Odd: writing
+		std::atomic_thread_fence(std::memory_order_release);
+
+		for (int i = 0; i < Stage_Count; i++)
+		{
+			const LatencyHistogram& histogram = mStages[i];
+			stages()[i].count = histogram.count();
+			stages()[i].p50 = histogram.percentile(0.50);
+			stages()[i].p99 = histogram.percentile(0.99);
+			stages()[i].max = histogram.peak();
+		}
+		header()->updatedAt = timestamp;
+
+		generation.store(current + 2, std::memory_order_release); // Even: done
+	}
+
+private:
+	[[nodiscard]] LatencyCountersHeader* header() const
+	{
+		return reinterpret_cast<LatencyCountersHeader*>(mExport.data());
+	}
+
+	[[nodiscard]] LatencyCountersStage* stages() const
+	{
+		return reinterpret_cast<LatencyCountersStage*>(mExport.data() + sizeof(LatencyCountersHeader));
+	}
+
+	std::array<LatencyHistogram, Stage_Count> mStages;
+	MappedFile mExport;
+};
@@ -0,0 +1,85 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "BenchmarkSetup.h"
+
+// Paced run: can the pipeline keep up with a given rate, and how often does it not
+struct IngestLoadResult
+{
+	uint32_t objects = 0;
+	uint32_t rateHz = 0;
+	uint32_t frames = 0;
+
+	uint32_t missedDeadlines = 0; // Frames that took longer than one period
+	double meanNs = 0.0;
+	double worstNs = 0.0;
+	double achievedHz = 0.0;
+};
+
+// Runs the whole pipeline at 'rate_hz' for a while, sleeping out the rest of each period
+inline IngestLoadResult benchmark_load(const BenchmarkSetup& setup, const uint32_t objects,
+                                       const uint32_t rate_hz, const double seconds)
+{
+	using clock = std::chrono::steady_clock;
+
+	const std::unique_ptr<IPoseSource> source = setup.make_source(objects);
+	JointFrame frame;
+
+	IngestLoadResult result;
+	result.objects = objects;
+	result.rateHz = std::max<uint32_t>(rate_hz, 1);
+
+	const auto period = std::chrono::nanoseconds(1'000'000'000 / result.rateHz);
+	const auto started = clock::now();
+	const auto until = started + std::chrono::duration_cast<clock::duration>(
+		std::chrono::duration<double>(seconds));
+
+	clock::duration total{}, worst{};
+	auto next = started;
+
+	while (clock::now() < until)
+	{
+		const auto start = clock::now();
+		acquire_frame(*source, frame, setup.prediction, first_object_slots(objects));
+		if (setup.filter) setup.filter(frame);
+		if (setup.apply) setup.apply(frame);
+		const auto took = clock::now() - start;
+
+		total += took;
+		worst = std::max<clock::duration>(worst, took);
+		if (took > period) result.missedDeadlines++;
+		result.frames++;
+
+		next += period;
+		if (const auto now = clock::now(); next < now)
+			next = now; // Fell behind, don't try to catch up in a burst
+		else
+			std::this_thread::sleep_until(next);
+	}
+
+	const auto elapsed = std::chrono::duration<double>(clock::now() - started).count();
+	result.meanNs = result.frames > 0
+		                ? static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(total).count()) /
+		                result.frames
+		                : 0.0;
+	result.worstNs = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(worst).count());
+	result.achievedHz = elapsed > 0.0 ? result.frames / elapsed : 0.0;
+	return result;
+}
+
+inline std::string to_json(const IngestLoadResult& result)
+{
+	char json[512];
+	std::snprintf(json, sizeof(json),
+	              "{\"objects\": %u, \"rate_hz\": %u, \"frames\": %u, "
+	              "\"missed_deadlines\": %u, \"mean_ns\": %.1f, \"worst_ns\": %.1f, \"achieved_hz\": %.1f}",
+	              result.objects, result.rateHz, result.frames, result.missedDeadlines,
+	              result.meanNs, result.worstNs, result.achievedHz);
+	return json;
+}
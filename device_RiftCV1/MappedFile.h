@@ -0,0 +1,175 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// A file mapped into memory, so writing to it is just writing to memory
+// Only (re)sizing, opening and closing go through the OS
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	~MappedFile() { close(); }
+
+	// writable: the file is created/extended to 'size' bytes
+	// read-only: 'size' is ignored and the whole file is mapped
+	bool open(const std::filesystem::path& path, const size_t size, const bool writable)
+	{
+		close();
+		mWritable = writable;
+
+#ifdef _WIN32
+		mFile = CreateFileW(path.c_str(),
+		                    writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
+		                    FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+		                    writable ? OPEN_ALWAYS : OPEN_EXISTING,
+		                    FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (mFile == INVALID_HANDLE_VALUE)
+			return false;
+
+		size_t map_size = size;
+		if (!writable)
+		{
+			LARGE_INTEGER file_size{};
+			GetFileSizeEx(mFile, &file_size);
+			map_size = static_cast<size_t>(file_size.QuadPart);
+		}
+#else
+		mFile = ::open(path.c_str(), writable ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+		if (mFile < 0)
+			return false;
+
+		size_t map_size = size;
+		if (!writable)
+			map_size = static_cast<size_t>(lseek(mFile, 0, SEEK_END));
+#endif
+
+		if (!map(map_size))
+		{
+			close();
+			return false;
+		}
+		return true;
+	}
+
+	// Grows (or shrinks) the mapping, pointers from data() are invalidated
+	bool resize(const size_t size)
+	{
+		if (!is_open() || !mWritable) return false;
+
+		unmap();
+		return map(size);
+	}
+
+	// truncate_to: cut the file down to what's actually been used
+	void close(const size_t truncate_to = SIZE_MAX)
+	{
+		if (!is_open()) return;
+
+		unmap();
+
+#ifdef _WIN32
+		if (mWritable && truncate_to != SIZE_MAX)
+		{
+			LARGE_INTEGER end{};
+			end.QuadPart = static_cast<LONGLONG>(truncate_to);
+			SetFilePointerEx(mFile, end, nullptr, FILE_BEGIN);
+			SetEndOfFile(mFile);
+		}
+		CloseHandle(mFile);
+		mFile = INVALID_HANDLE_VALUE;
+#else
+		if (mWritable && truncate_to != SIZE_MAX)
+			(void)ftruncate(mFile, static_cast<off_t>(truncate_to));
+		::close(mFile);
+		mFile = -1;
+#endif
+	}
+
+	[[nodiscard]] bool is_open() const
+	{
+#ifdef _WIN32
+		return mFile != INVALID_HANDLE_VALUE;
+#else
+		return mFile >= 0;
+#endif
+	}
+
+	[[nodiscard]] uint8_t* data() const { return mData; }
+	[[nodiscard]] size_t size() const { return mSize; }
+
+private:
+	bool map(const size_t size)
+	{
+		if (size == 0) return false;
+
+#ifdef _WIN32
+		// Creating a bigger mapping extends the file
+		mMapping = CreateFileMappingW(mFile, nullptr,
+		                              mWritable ? PAGE_READWRITE : PAGE_READONLY,
+		                              static_cast<DWORD>(static_cast<uint64_t>(size) >> 32),
+		                              static_cast<DWORD>(size & 0xffffffff), nullptr);
+		if (!mMapping) return false;
+
+		mData = static_cast<uint8_t*>(MapViewOfFile(
+			mMapping, mWritable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, size));
+		if (!mData)
+		{
+			CloseHandle(mMapping);
+			mMapping = nullptr;
+			return false;
+		}
+#else
+		if (mWritable && ftruncate(mFile, static_cast<off_t>(size)) != 0)
+			return false;
+
+		void* data = mmap(nullptr, size,
+		                  mWritable ? PROT_READ | PROT_WRITE : PROT_READ,
+		                  MAP_SHARED, mFile, 0);
+		if (data == MAP_FAILED) return false;
+
+		mData = static_cast<uint8_t*>(data);
+#endif
+
+		mSize = size;
+		return true;
+	}
+
+	void unmap()
+	{
+		if (!mData) return;
+
+#ifdef _WIN32
+		UnmapViewOfFile(mData);
+		CloseHandle(mMapping);
+		mMapping = nullptr;
+#else
+		munmap(mData, mSize);
+#endif
+
+		mData = nullptr;
+		mSize = 0;
+	}
+
+#ifdef _WIN32
+	HANDLE mFile = INVALID_HANDLE_VALUE;
+	HANDLE mMapping = nullptr;
+#else
+	int mFile = -1;
+#endif
+
+	bool mWritable = false;
+	uint8_t* mData = nullptr;
+	size_t mSize = 0;
+};
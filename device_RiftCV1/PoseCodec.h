@@ -0,0 +1,370 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include "JointFrame.h"
+
+// Compact wire format for one frame of joints, see PoseStream.h for sending it around
+// Everything's little endian:
+//
+// header     'C' 'V', version u8, flags u8 (0x1: keyframe)
+//            sequence u32, frameTime f64 (SDK clock), hostTimestamp i64 (us)
+//            objectMask varint, jointCount u8
+//            keyframes only: origin 3 x f32 (m)
+// per joint  u8: tracking status (bits 0-1), largest quaternion component (bits 2-3)
+//            3 x i16: the other three components, smallest three (the largest is positive)
+//            3 x i16: position - origin, 1/2048 m steps (+-16 m)
+//            i16: sampleTime - frameTime, 10 us steps (+-327 ms)
+//            3 x zigzag varint: linear velocity, mm/s, minus the joint's last one
+//            3 x zigzag varint: angular velocity, mrad/s, minus the joint's last one
+//
+// Velocities are deltas against what the other side decoded last time, keyframes reset that
+// (and come every so often, so a lost datagram only costs velocities until the next one)
+// Accelerations aren't sent, receivers get zeros
+namespace pose_codec
+{
+	constexpr uint8_t version = 1;
+	constexpr uint8_t flag_keyframe = 0x1;
+
+	constexpr double position_scale = 2048.0; // Steps per m
+	constexpr double time_scale = 100000.0; // Steps per s
+	constexpr double velocity_scale = 1000.0; // mm/s, mrad/s
+	constexpr double quaternion_scale = 32767.0 * 1.41421356237309504880; // Smallest three are <= 1/sqrt(2)
+
+	// Header, origin, and every joint with 5-byte varints
+	constexpr size_t max_bytes = 2 + 2 + 4 + 8 + 8 + 10 + 1 + 12 + max_frame_joints * (1 + 6 + 6 + 2 + 6 * 5);
+
+	// Bytes in, bytes out; a writer that ran out of room just stops and remembers it did
+	struct Writer
+	{
+		uint8_t* data;
+		size_t capacity;
+		size_t size = 0;
+		bool overflow = false;
+
+		template <class T>
+		void put(const T value)
+		{
+			if (size + sizeof(T) > capacity)
+			{
+				overflow = true;
+				return;
+			}
+			std::memcpy(data + size, &value, sizeof(T));
+			size += sizeof(T);
+		}
+
+		void varint(uint64_t value)
+		{
+			while (value >= 0x80)
+			{
+				put(static_cast<uint8_t>(value | 0x80));
+				value >>= 7;
+			}
+			put(static_cast<uint8_t>(value));
+		}
+	};
+
+	struct Reader
+	{
+		const uint8_t* data;
+		size_t size;
+		size_t offset = 0;
+		bool underflow = false;
+
+		template <class T>
+		T get()
+		{
+			T value{};
+			if (offset + sizeof(T) > size)
+			{
+				underflow = true;
+				return value;
+			}
+			std::memcpy(&value, data + offset, sizeof(T));
+			offset += sizeof(T);
+			return value;
+		}
+
+		uint64_t varint64()
+		{
+			uint64_t value = 0;
+			for (int shift = 0; shift < 64; shift += 7)
+			{
+				const auto byte = get<uint8_t>();
+				value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+				if (!(byte & 0x80) || underflow) break;
+			}
+			return value;
+		}
+
+		uint32_t varint() { return static_cast<uint32_t>(varint64()); }
+	};
+
+	inline uint32_t zigzag(const int32_t value)
+	{
+		return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+	}
+
+	inline int32_t unzigzag(const uint32_t value)
+	{
+		return static_cast<int32_t>(value >> 1) ^ -static_cast<int32_t>(value & 1);
+	}
+
+	// Velocity deltas wrap around (both ends alike) instead of overflowing near the clamp
+	inline int32_t wrapping_sub(const int32_t a, const int32_t b)
+	{
+		return static_cast<int32_t>(static_cast<uint32_t>(a) - static_cast<uint32_t>(b));
+	}
+
+	inline int32_t wrapping_add(const int32_t a, const int32_t b)
+	{
+		return static_cast<int32_t>(static_cast<uint32_t>(a) + static_cast<uint32_t>(b));
+	}
+
+	// NaN and inf go out as 0, everything else saturates at what T holds
+	template <class T>
+	T quantize(const double value, const double scale)
+	{
+		constexpr double low = static_cast<double>(std::numeric_limits<T>::min());
+		constexpr double high = static_cast<double>(std::numeric_limits<T>::max());
+		const double scaled = value * scale;
+		if (!std::isfinite(scaled)) return 0;
+
+		// Round half away (without a libm call) first, clamp after, so the cast is always in range
+		const double rounded = scaled + (scaled < 0.0 ? -0.5 : 0.5);
+		return static_cast<T>(std::clamp(rounded, low, high));
+	}
+
+	// Status flags -> 2 bits and back, same meaning as statusFlags
+	inline uint8_t pack_status(const uint32_t flags)
+	{
+		return static_cast<uint8_t>(flags & (status_orientation_tracked | status_position_tracked));
+	}
+}
+
+// Both ends keep the last velocities they agreed on per joint
+struct PoseCodecState
+{
+	int32_t velocity[max_frame_joints][6] = {};
+	uint32_t sequence = 0; // Last encoded / decoded
+	uint32_t jointCount = 0;
+	uint64_t objectMask = 0;
+	bool synced = false; // Decoder: deltas are usable
+};
+
+class PoseEncoder
+{
+public:
+	float origin[3] = {0.f, 0.f, 0.f}; // Positions are sent relative to this
+	uint32_t keyframeInterval = 16; // Frames, plus whenever the joints change
+
+	void reset() { mState = {}; }
+
+	// Returns the bytes written to 'out' (pose_codec::max_bytes is always enough), 0 if it didn't fit
+	size_t encode(const JointFrame& frame, const long long host_timestamp, uint8_t* out, const size_t capacity)
+	{
+		using namespace pose_codec;
+
+		const uint32_t count = std::min<uint32_t>(frame.jointCount, max_frame_joints);
+		const uint32_t sequence = mState.sequence + 1;
+		const bool keyframe = !mState.synced || count != mState.jointCount || frame.objectMask != mState.objectMask ||
+			(keyframeInterval > 0 && sequence % keyframeInterval == 0);
+
+		// Velocities go in here and only become the state once the packet's complete
+		if (keyframe)
+			std::memset(mVelocity, 0, sizeof(mVelocity));
+		else
+			std::memcpy(mVelocity, mState.velocity, sizeof(mVelocity));
+
+		Writer writer{out, capacity};
+		writer.put<uint8_t>('C');
+		writer.put<uint8_t>('V');
+		writer.put<uint8_t>(version);
+		writer.put<uint8_t>(keyframe ? flag_keyframe : 0);
+		writer.put<uint32_t>(sequence);
+		writer.put<double>(frame.frameTime);
+		writer.put<int64_t>(host_timestamp);
+		writer.varint(frame.objectMask);
+		writer.put<uint8_t>(static_cast<uint8_t>(count));
+
+		if (keyframe)
+			for (const float axis : origin)
+				writer.put<float>(axis);
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			const JointSample& sample = frame.joints[i];
+
+			// Smallest three: drop the largest component, it follows from the rest
+			double q[4] = {sample.orientation[0], sample.orientation[1], sample.orientation[2], sample.orientation[3]};
+			const double norm = std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+			if (norm < 1e-12)
+			{
+				q[0] = q[1] = q[2] = 0.0;
+				q[3] = 1.0;
+			}
+			else
+				for (double& c : q) c /= norm;
+
+			int largest = 0;
+			for (int c = 1; c < 4; c++)
+				if (std::abs(q[c]) > std::abs(q[largest])) largest = c;
+			const double sign = q[largest] < 0.0 ? -1.0 : 1.0;
+
+			writer.put<uint8_t>(static_cast<uint8_t>(pack_status(sample.statusFlags) | largest << 2));
+			for (int c = 0; c < 4; c++)
+				if (c != largest)
+					writer.put<int16_t>(quantize<int16_t>(q[c] * sign, quaternion_scale));
+
+			for (int c = 0; c < 3; c++)
+				writer.put<int16_t>(quantize<int16_t>(sample.position[c] - origin[c], position_scale));
+
+			writer.put<int16_t>(quantize<int16_t>(sample.sampleTime - frame.frameTime, time_scale));
+
+			// Deltas against the last quantized velocity, so both ends stay in step
+			const float* velocities[2] = {sample.linearVelocity, sample.angularVelocity};
+			for (int c = 0; c < 6; c++)
+			{
+				const int32_t value = quantize<int32_t>(velocities[c / 3][c % 3], velocity_scale);
+				writer.varint(zigzag(wrapping_sub(value, mVelocity[i][c])));
+				mVelocity[i][c] = value;
+			}
+		}
+
+		if (writer.overflow) return 0; // State untouched, the next frame deltas against the last one sent
+
+		std::memcpy(mState.velocity, mVelocity, sizeof(mVelocity));
+		mState.sequence = sequence;
+		mState.jointCount = count;
+		mState.objectMask = frame.objectMask;
+		mState.synced = true;
+		return writer.size;
+	}
+
+private:
+	PoseCodecState mState;
+	int32_t mVelocity[max_frame_joints][6] = {}; // This encode's, see above
+};
+
+class PoseDecoder
+{
+public:
+	enum Result
+	{
+		Decode_Ok,
+		Decode_NoVelocities, // Missed something, velocities are zero until the next keyframe
+		Decode_Stale, // Older than what we've already got
+		Decode_Bad // Not ours, or cut short
+	};
+
+	float origin[3] = {0.f, 0.f, 0.f}; // As of the last keyframe
+
+	static constexpr int32_t restart_window = 64; // Frames
+
+	void reset() { mState = {}; }
+
+	[[nodiscard]] uint32_t sequence() const { return mState.sequence; }
+
+	// 'frame.sequence' gets the sender's sequence, 'host_timestamp' its clock
+	// Whatever was in 'frame' is gone on Decode_Bad too
+	Result decode(const uint8_t* data, const size_t size, JointFrame& frame, long long& host_timestamp)
+	{
+		using namespace pose_codec;
+
+		Reader reader{data, size};
+		if (reader.get<uint8_t>() != 'C' || reader.get<uint8_t>() != 'V' || reader.get<uint8_t>() != version)
+			return Decode_Bad;
+
+		const auto flags = reader.get<uint8_t>();
+		const bool keyframe = flags & flag_keyframe;
+		const auto sequence = reader.get<uint32_t>();
+		const auto frame_time = reader.get<double>();
+		const auto timestamp = reader.get<int64_t>();
+		const uint64_t object_mask = reader.varint64();
+		const uint32_t count = reader.get<uint8_t>();
+		if (reader.underflow || count > max_frame_joints) return Decode_Bad;
+
+		// Wraps after 2^32 frames, compare the difference
+		// A keyframe from way back is a restarted sender, not a late datagram
+		const auto ahead = static_cast<int32_t>(sequence - mState.sequence);
+		if (mState.sequence != 0 && ahead <= 0 && !(keyframe && ahead < -restart_window))
+			return Decode_Stale;
+
+		float frame_origin[3] = {origin[0], origin[1], origin[2]};
+		if (keyframe)
+			for (float& axis : frame_origin)
+				axis = reader.get<float>();
+
+		// Deltas only make sense right after the frame they're against
+		const bool synced = keyframe ||
+			(mState.synced && sequence == mState.sequence + 1 &&
+				count == mState.jointCount && object_mask == mState.objectMask);
+
+		int32_t velocity[max_frame_joints][6];
+		if (keyframe || !synced)
+			std::memset(velocity, 0, sizeof(velocity));
+		else
+			std::memcpy(velocity, mState.velocity, sizeof(velocity));
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			JointSample& sample = frame.joints[i];
+
+			const auto packed = reader.get<uint8_t>();
+			const int largest = packed >> 2 & 3;
+
+			double q[4];
+			double sum = 0.0;
+			for (int c = 0; c < 4; c++)
+			{
+				if (c == largest) continue;
+				q[c] = reader.get<int16_t>() / quaternion_scale;
+				sum += q[c] * q[c];
+			}
+			q[largest] = std::sqrt(std::max(0.0, 1.0 - sum));
+			for (int c = 0; c < 4; c++)
+				sample.orientation[c] = static_cast<float>(q[c]);
+
+			for (int c = 0; c < 3; c++)
+				sample.position[c] = static_cast<float>(reader.get<int16_t>() / position_scale + frame_origin[c]);
+
+			sample.sampleTime = frame_time + reader.get<int16_t>() / time_scale;
+			sample.statusFlags = packed & 3;
+
+			float* velocities[2] = {sample.linearVelocity, sample.angularVelocity};
+			for (int c = 0; c < 6; c++)
+			{
+				velocity[i][c] = wrapping_add(velocity[i][c], unzigzag(reader.varint()));
+				velocities[c / 3][c % 3] = synced ? static_cast<float>(velocity[i][c] / velocity_scale) : 0.f;
+			}
+
+			for (int c = 0; c < 3; c++)
+				sample.linearAcceleration[c] = sample.angularAcceleration[c] = 0.f;
+		}
+
+		if (reader.underflow) return Decode_Bad;
+
+		frame.sequence = sequence;
+		frame.frameTime = frame_time;
+		frame.jointCount = count;
+		frame.objectMask = object_mask;
+		host_timestamp = timestamp;
+
+		if (keyframe)
+			std::memcpy(origin, frame_origin, sizeof(origin));
+
+		std::memcpy(mState.velocity, velocity, sizeof(velocity));
+		mState.sequence = sequence;
+		mState.jointCount = count;
+		mState.objectMask = object_mask;
+		mState.synced = synced;
+		return synced ? Decode_Ok : Decode_NoVelocities;
+	}
+
+private:
+	PoseCodecState mState;
+};
@@ -0,0 +1,91 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstring>
+
+#include "JointFrame.h"
+#include "SharedPoses.h"
+
+// Writer side of the shared pose export, see SharedPoses.h
+// Wait-free: one frame is a couple of stores plus one copy per joint, no matter who's reading
+class PoseExport
+{
+public:
+	// Same layout as JointSample up to the sample time, so a joint goes over in one copy
+	static_assert(offsetof(SharedPose, orientation) == offsetof(JointSample, orientation) &&
+		offsetof(SharedPose, angularAcceleration) == offsetof(JointSample, angularAcceleration) &&
+		offsetof(SharedPose, sampleTime) == offsetof(JointSample, sampleTime) &&
+		offsetof(SharedPose, statusFlags) == offsetof(JointSample, statusFlags) &&
+		sizeof(JointSample) <= offsetof(SharedPose, hostTime));
+
+	bool open(const char* name = shared_poses_name, const uint32_t process = 0)
+	{
+		if (!mMemory.open(name, shared_poses_size, true))
+			return false;
+
+		*header() = SharedPosesHeader{};
+		header()->writerProcess = process;
+		std::memset(poses(), 0, sizeof(SharedPose) * shared_poses_max);
+		return true;
+	}
+
+	void close() { mMemory.close(); }
+	[[nodiscard]] bool is_open() const { return mMemory.is_open(); }
+
+	// Host thread only, 'now' is AME_API_GET_TIMESTAMP_NOW
+	void publish(const JointFrame& frame, const long long now)
+	{
+		if (!is_open()) return;
+
+		SharedPosesHeader& shared = *header();
+		std::atomic_ref<uint64_t> generation(shared.generation);
+		const uint64_t current = generation.load(std::memory_order_relaxed);
+
+		generation.store(current + 1, std::memory_order_relaxed); // Odd: writing
+		std::atomic_thread_fence(std::memory_order_release);
+
+		const uint32_t count = std::min<uint32_t>(frame.jointCount, shared_poses_max);
+		SharedPose* out = poses();
+
+		uint64_t slots = frame.objectMask;
+		for (uint32_t i = 0; i < count; i++)
+		{
+			const JointSample& sample = frame.joints[i];
+			std::memcpy(&out[i], &sample, sizeof(JointSample));
+
+			// Hands first, then VR Objects lowest slot first
+			uint32_t device = i;
+			if (i >= 2 && slots)
+			{
+				device = 2 + static_cast<uint32_t>(std::countr_zero(slots));
+				slots &= slots - 1;
+			}
+			out[i].device = device;
+			out[i].reserved = 0;
+			out[i].hostTime = frame.clock.valid ? frame.clock.to_host(sample.sampleTime) : 0;
+		}
+
+		shared.frames++;
+		shared.publishedAt = now;
+		shared.frameTime = frame.frameTime;
+		shared.objectMask = frame.objectMask;
+		shared.poseCount = count;
+
+		generation.store(current + 2, std::memory_order_release); // Even: done
+	}
+
+private:
+	[[nodiscard]] SharedPosesHeader* header() const
+	{
+		return reinterpret_cast<SharedPosesHeader*>(mMemory.data());
+	}
+
+	[[nodiscard]] SharedPose* poses() const
+	{
+		return reinterpret_cast<SharedPose*>(mMemory.data() + sizeof(SharedPosesHeader));
+	}
+
+	SharedMemory mMemory;
+};
@@ -0,0 +1,145 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+#include <Eigen/Dense>
+
+#include "JointFrame.h"
+#include "JointLanes.h"
+
+// Local prediction: every device is fetched once per frame at horizon 0 (the SDK's pose as
+// of that moment, frameTime = sdkTime) and any number of look-ahead times past that come
+// from here instead of one more ovr_GetTrackingState / ovr_GetDevicePoses round-trip each
+//   p(h) = p + v h + a h^2 / 2
+//   q(h) = exp(w h / 2) q    (world-space angular velocity, quaternion exponential map)
+// load() transposes the frame once into one row of floats per component, across joints;
+// every extrapolate() after that is packet ops over all joints (sin/cos included), only
+// the poses are written back. Sample times and everything else stay as they were
+// Host thread only, like the frames it extrapolates
+class PoseExtrapolator
+{
+public:
+	using Horizons = std::array<float, max_frame_joints>; // s, indexed like frame joints
+
+	PoseExtrapolator() { load(JointFrame{}); }
+
+	void load(const JointFrame& frame)
+	{
+		mFrame = frame;
+		mCount = static_cast<int>(frame.jointCount);
+
+		for (int i = 0; i < mCount; i++)
+		{
+			const JointSample& sample = frame.joints[i];
+			mPosition.col(i) = Eigen::Map<const Eigen::Array3f>(sample.position);
+			mVelocity.col(i) = Eigen::Map<const Eigen::Array3f>(sample.linearVelocity);
+			mAcceleration.col(i) = Eigen::Map<const Eigen::Array3f>(sample.linearAcceleration);
+			mOrientation.col(i) = Eigen::Map<const Eigen::Array4f>(sample.orientation);
+			mSpin.col(i) = Eigen::Map<const Eigen::Array3f>(sample.angularVelocity);
+		}
+
+		// Unit orientations (all-zero ones become identity), spin as axis * rate
+		auto norm = row(mScratch, 0);
+		norm = row(mOrientation, 0).square() + row(mOrientation, 1).square() +
+			row(mOrientation, 2).square() + row(mOrientation, 3).square();
+		auto valid = row(mScratch, 1);
+		valid = (norm > 1e-12f).cast<float>();
+		norm = valid / norm.max(1e-12f).sqrt();
+		for (int component = 0; component < 4; component++)
+			row(mOrientation, component) *= norm;
+		row(mOrientation, 3) += 1.f - valid;
+
+		auto rate = mRate.head(mCount);
+		rate = (row(mSpin, 0).square() + row(mSpin, 1).square() + row(mSpin, 2).square()).sqrt();
+		norm = (rate > 1e-9f).cast<float>() / rate.max(1e-9f);
+		for (int component = 0; component < 3; component++)
+			row(mSpin, component) *= norm;
+	}
+
+	// What was loaded, as it came in (horizon 0)
+	[[nodiscard]] const JointFrame& frame() const { return mFrame; }
+
+	// The loaded frame with every joint 'horizon' s ahead into 'out'
+	void extrapolate(const float horizon, JointFrame& out)
+	{
+		kernel(horizon, out);
+	}
+
+	// Same, every joint by its own horizon
+	void extrapolate(const Horizons& horizons, JointFrame& out)
+	{
+		kernel(Eigen::Map<const Lanes>(horizons.data()).head(mCount), out);
+	}
+
+private:
+	using Lanes = joint_lanes::Lanes;
+	template <int Rows>
+	using Channels = joint_lanes::Channels<Rows>;
+
+	// 'h': a float, or one per joint
+	template <class Horizon>
+	void kernel(const Horizon& h, JointFrame& out)
+	{
+		// exp(w h / 2) = (axis * sin(rate h / 2), cos(rate h / 2))
+		auto s = row(mScratch, 0);
+		auto c = row(mScratch, 1);
+		s = mRate.head(mCount) * h * 0.5f;
+		c = s.cos();
+		s = s.sin();
+
+		auto rx = row(mScratch, 2);
+		auto ry = row(mScratch, 3);
+		auto rz = row(mScratch, 4);
+		rx = row(mSpin, 0) * s;
+		ry = row(mSpin, 1) * s;
+		rz = row(mSpin, 2) * s;
+
+		// Rotation * orientation, both unit, so the product is too
+		const auto qx = row(mOrientation, 0);
+		const auto qy = row(mOrientation, 1);
+		const auto qz = row(mOrientation, 2);
+		const auto qw = row(mOrientation, 3);
+
+		row(mOutOrientation, 0) = c * qx + rx * qw + ry * qz - rz * qy;
+		row(mOutOrientation, 1) = c * qy - rx * qz + ry * qw + rz * qx;
+		row(mOutOrientation, 2) = c * qz + rx * qy - ry * qx + rz * qw;
+		row(mOutOrientation, 3) = c * qw - rx * qx - ry * qy - rz * qz;
+
+		for (int component = 0; component < 3; component++)
+			row(mOutPosition, component) = row(mPosition, component) +
+				h * (row(mVelocity, component) + row(mAcceleration, component) * (h * 0.5f));
+
+		out = mFrame;
+		for (int i = 0; i < mCount; i++)
+		{
+			Eigen::Map<Eigen::Array3f>(out.joints[i].position) = mOutPosition.col(i);
+			Eigen::Map<Eigen::Array4f>(out.joints[i].orientation) = mOutOrientation.col(i);
+		}
+	}
+
+	// One component of the loaded joints only, see joint_lanes::row()
+	template <int Rows>
+	Eigen::VectorBlock<Eigen::Map<Lanes>> row(Channels<Rows>& channels, const int component)
+	{
+		return joint_lanes::row(channels, component).head(mCount);
+	}
+
+	template <int Rows>
+	Eigen::VectorBlock<Eigen::Map<const Lanes>> row(const Channels<Rows>& channels, const int component) const
+	{
+		return joint_lanes::row(channels, component).head(mCount);
+	}
+
+	JointFrame mFrame;
+	int mCount = 0; // Joints loaded, only those lanes are ever touched
+
+	Channels<3> mPosition, mVelocity, mAcceleration;
+	Channels<4> mOrientation;
+	Channels<3> mSpin; // Unit axis, zero when still
+	Lanes mRate; // rad/s around it
+
+	// Temporaries, kept around so nothing's allocated per call
+	Channels<5> mScratch;
+	Channels<3> mOutPosition;
+	Channels<4> mOutOrientation;
+};
@@ -0,0 +1,210 @@
+#pragma once
+#include <cmath>
+#include <numbers>
+
+#include <Eigen/Dense>
+
+#include "JointFrame.h"
+
+// Smoothing for all joints of a frame at once
+// Every position/orientation component of every joint is one lane,
+// stored channel-major, so each filter step is a single vectorized pass
+// Joints that aren't tracked (or aren't there) pass through as they are and start
+// over once they're tracked again, so nothing gets dragged towards a frozen pose
+class PoseFilterBank
+{
+public:
+	enum Mode
+	{
+		Filter_None,
+		Filter_OneEuro,
+		Filter_Kalman
+	};
+
+	struct Settings
+	{
+		// One-Euro
+		float minCutoff = 1.5f; // Hz, lower = smoother at rest
+		float beta = 0.5f; // Cutoff increase per unit/s, higher = less lag when moving
+		float derivativeCutoff = 1.0f; // Hz
+
+		// Constant-velocity Kalman
+		float processNoise = 1.0f; // Acceleration variance
+		float measurementNoise = 1e-6f; // ~1mm standard deviation
+	};
+
+	static constexpr int channels = 7; // Position xyz + orientation xyzw
+	static constexpr int lanes = channels * max_frame_joints;
+
+	using Lanes = Eigen::Array<float, lanes, 1>;
+
+	PoseFilterBank() { reset(); }
+
+	void set_mode(const int mode)
+	{
+		if (mode == mMode) return;
+
+		mMode = mode;
+		reset();
+	}
+
+	[[nodiscard]] int mode() const { return mMode; }
+
+	Settings& settings() { return mSettings; }
+
+	void reset()
+	{
+		mRaw.setZero();
+		mOut.setZero();
+		mDerivative.setZero();
+		mVelocity.setZero();
+		mP00.setZero();
+		mP01.setZero();
+		mP11.setZero();
+		mPrimed.setZero();
+		mLastTime = 0.0;
+	}
+
+	// Filters the frame's poses in place, velocities etc. are left as they are
+	void filter(JointFrame& frame)
+	{
+		if (mMode == Filter_None || frame.jointCount == 0)
+			return;
+
+		const double dt = mLastTime > 0.0 ? frame.frameTime - mLastTime : 0.0;
+		mLastTime = frame.frameTime;
+
+		// Only tracked joints keep their state, everything else starts from scratch
+		bool tracked[max_frame_joints] = {};
+		for (uint32_t j = 0; j < frame.jointCount; j++)
+			tracked[j] = (frame.joints[j].statusFlags & tracked_flags) == tracked_flags;
+		for (int c = 0; c < channels; c++)
+			for (uint32_t j = 0; j < max_frame_joints; j++)
+				if (!tracked[j]) mPrimed[lane(c, j)] = 0.f;
+
+		gather(frame);
+
+		if (dt > 0.0)
+		{
+			if (mMode == Filter_OneEuro)
+				one_euro(static_cast<float>(dt));
+			else
+				kalman(static_cast<float>(dt));
+		}
+		else
+			mOut = (mPrimed > 0.f).select(mOut, mRaw);
+
+		// Everything tracked that's been seen once has a valid state now
+		for (int c = 0; c < channels; c++)
+			for (uint32_t j = 0; j < frame.jointCount; j++)
+				if (tracked[j]) mPrimed[lane(c, j)] = 1.f;
+
+		scatter(frame, tracked);
+	}
+
+	// Whether a joint has filter state, i.e. was tracked last time round
+	[[nodiscard]] bool primed(const uint32_t joint) const { return mPrimed[lane(0, joint)] > 0.f; }
+
+private:
+	static constexpr uint32_t tracked_flags = status_orientation_tracked | status_position_tracked;
+
+	static float alpha(const float cutoff, const float dt)
+	{
+		const float tau = 1.0f / (2.0f * std::numbers::pi_v<float> * cutoff);
+		return 1.0f / (1.0f + tau / dt);
+	}
+
+	static int lane(const int channel, const uint32_t joint)
+	{
+		return channel * max_frame_joints + static_cast<int>(joint);
+	}
+
+	void gather(const JointFrame& frame)
+	{
+		for (uint32_t j = 0; j < frame.jointCount; j++)
+		{
+			const JointSample& sample = frame.joints[j];
+			for (int c = 0; c < 3; c++)
+				mRaw[lane(c, j)] = sample.position[c];
+
+			// Keep orientations on the same hemisphere as what we output last,
+			// otherwise q and -q would get averaged into garbage
+			float dot = 0.f;
+			for (int c = 0; c < 4; c++)
+				dot += sample.orientation[c] * mOut[lane(3 + c, j)];
+
+			const float sign = dot < 0.f ? -1.f : 1.f;
+			for (int c = 0; c < 4; c++)
+				mRaw[lane(3 + c, j)] = sign * sample.orientation[c];
+		}
+	}
+
+	void scatter(JointFrame& frame, const bool* tracked) const
+	{
+		for (uint32_t j = 0; j < frame.jointCount; j++)
+		{
+			if (!tracked[j]) continue; // Left as it came
+
+			JointSample& sample = frame.joints[j];
+			for (int c = 0; c < 3; c++)
+				sample.position[c] = mOut[lane(c, j)];
+
+			float norm = 0.f;
+			for (int c = 0; c < 4; c++)
+				norm += mOut[lane(3 + c, j)] * mOut[lane(3 + c, j)];
+
+			// Don't touch orientations that weren't there in the first place
+			if (norm < 1e-12f) continue;
+
+			const float inverse = 1.f / std::sqrt(norm);
+			for (int c = 0; c < 4; c++)
+				sample.orientation[c] = mOut[lane(3 + c, j)] * inverse;
+		}
+	}
+
+	void one_euro(const float dt)
+	{
+		const Lanes derivative = (mRaw - mOut) / dt;
+		mDerivative += alpha(mSettings.derivativeCutoff, dt) * (derivative - mDerivative);
+
+		const Lanes cutoff = mSettings.minCutoff + mSettings.beta * mDerivative.abs();
+		const Lanes tau = 1.0f / (2.0f * std::numbers::pi_v<float> * cutoff);
+		const Lanes a = 1.0f / (1.0f + tau / dt);
+
+		const Lanes filtered = mOut + a * (mRaw - mOut);
+		mOut = (mPrimed > 0.f).select(filtered, mRaw);
+		mDerivative = (mPrimed > 0.f).select(mDerivative, Lanes::Zero());
+	}
+
+	void kalman(const float dt)
+	{
+		const float q = mSettings.processNoise;
+		const float r = mSettings.measurementNoise;
+
+		// Predict
+		const Lanes predicted = mOut + mVelocity * dt;
+		const Lanes p00 = mP00 + dt * (2.0f * mP01 + dt * mP11) + q * dt * dt * dt / 3.0f;
+		const Lanes p01 = mP01 + dt * mP11 + q * dt * dt / 2.0f;
+		const Lanes p11 = mP11 + q * dt;
+
+		// Update
+		const Lanes innovation = mRaw - predicted;
+		const Lanes k0 = p00 / (p00 + r);
+		const Lanes k1 = p01 / (p00 + r);
+
+		const auto primed = mPrimed > 0.f;
+		mOut = primed.select(predicted + k0 * innovation, mRaw);
+		mVelocity = primed.select(mVelocity + k1 * innovation, Lanes::Zero());
+		mP00 = primed.select((1.0f - k0) * p00, Lanes::Constant(r));
+		mP01 = primed.select((1.0f - k0) * p01, Lanes::Zero());
+		mP11 = primed.select(p11 - k1 * p01, Lanes::Constant(1.0f));
+	}
+
+	int mMode = Filter_None;
+	Settings mSettings;
+	double mLastTime = 0.0;
+
+	Lanes mRaw, mOut, mDerivative; // One-Euro (and shared)
+	Lanes mVelocity, mP00, mP01, mP11; // Kalman
+	Lanes mPrimed;
+};
@@ -0,0 +1,219 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+
+#include <Eigen/Dense>
+
+#include "JointFrame.h"
+
+// The last few samples of every joint, and the pose of all joints at any time in between
+// Every joint has its own ring (sample times differ per device), each channel stored
+// contiguously; queries find the two samples around the requested time per joint,
+// then interpolate all joints at once (lerp for vectors, slerp for orientations)
+class PoseHistory
+{
+public:
+	static constexpr size_t capacity = 128; // Samples per joint, ~128 ms at the Touch IMU rate
+
+	// One lane per joint for the interpolation pass
+	using Lanes = Eigen::Array<float, max_frame_joints, 1>;
+
+	void reset()
+	{
+		for (Ring& ring : mRings)
+			ring.count = 0;
+		mJointCount = 0;
+		mObjectMask = 0;
+	}
+
+	// Takes every joint whose sample time moved on, ignores the rest
+	void push(const JointFrame& frame)
+	{
+		// Joints moved around, the old history doesn't line up anymore
+		if (frame.objectMask != mObjectMask || frame.jointCount != mJointCount)
+		{
+			reset();
+			mObjectMask = frame.objectMask;
+			mJointCount = frame.jointCount;
+		}
+
+		for (uint32_t i = 0; i < frame.jointCount; i++)
+		{
+			Ring& ring = mRings[i];
+			const JointSample& sample = frame.joints[i];
+			if (ring.count > 0 && sample.sampleTime <= ring.time[(ring.head + capacity - 1) % capacity])
+				continue;
+
+			const size_t slot = ring.head;
+			ring.time[slot] = sample.sampleTime;
+			ring.status[slot] = sample.statusFlags;
+
+			const float* channels[] = {
+				sample.position, sample.orientation, sample.linearVelocity,
+				sample.linearAcceleration, sample.angularVelocity, sample.angularAcceleration
+			};
+			for (int c = 0, lane = 0; c < 6; c++)
+				for (int k = 0; k < (c == 1 ? 4 : 3); k++, lane++)
+					ring.channel[lane][slot] = channels[c][k];
+
+			ring.head = (ring.head + 1) % capacity;
+			ring.count = std::min(ring.count + 1, capacity);
+		}
+	}
+
+	[[nodiscard]] size_t samples(const uint32_t joint) const { return mRings[joint].count; }
+	[[nodiscard]] uint32_t joints() const { return mJointCount; }
+
+	// All joints at 'time' (SDK clock), before the first sample or after the last one
+	// it's the first/last sample. Returns false if there's no history at all
+	bool sample(const double time, JointFrame& out) const
+	{
+		return resample(time, 0.0, &out, 1) == 1;
+	}
+
+	// 'count' frames on a fixed grid: start, start + step, ...
+	// Interpolated poses get the grid time as their sample time
+	size_t resample(const double start, const double step, JointFrame* out, const size_t count) const
+	{
+		if (mJointCount == 0) return 0;
+
+		for (size_t f = 0; f < count; f++)
+		{
+			const double time = start + step * static_cast<double>(f);
+			JointFrame& frame = out[f];
+
+			// Per joint: which two samples, and how far between them
+			size_t before[max_frame_joints], after[max_frame_joints];
+			Lanes weight = Lanes::Zero();
+
+			for (uint32_t i = 0; i < mJointCount; i++)
+			{
+				const Ring& ring = mRings[i];
+				if (ring.count == 0)
+				{
+					before[i] = after[i] = capacity; // Nothing, leave the joint alone
+					continue;
+				}
+
+				const size_t found = find(ring, time);
+				before[i] = slot_of(ring, found == 0 ? 0 : found - 1);
+				after[i] = slot_of(ring, std::min(found, ring.count - 1));
+
+				if (before[i] != after[i])
+				{
+					const double t0 = ring.time[before[i]], t1 = ring.time[after[i]];
+					weight[i] = static_cast<float>(std::clamp((time - t0) / (t1 - t0), 0.0, 1.0));
+				}
+			}
+
+			interpolate(before, after, weight, time, frame);
+			frame.jointCount = mJointCount;
+			frame.objectMask = mObjectMask;
+			frame.frameTime = time;
+		}
+		return count;
+	}
+
+private:
+	static constexpr int lane_count = 19; // Position, orientation, velocities, accelerations
+
+	struct Ring
+	{
+		double time[capacity] = {};
+		uint32_t status[capacity] = {};
+		float channel[lane_count][capacity] = {};
+		size_t head = 0; // Next slot to write
+		size_t count = 0;
+	};
+
+	// n-th oldest sample -> slot
+	static size_t slot_of(const Ring& ring, const size_t n)
+	{
+		return (ring.head + capacity - ring.count + n) % capacity;
+	}
+
+	// Index (oldest = 0) of the first sample at or after 'time', count if none
+	static size_t find(const Ring& ring, const double time)
+	{
+		size_t low = 0, high = ring.count;
+		while (low < high)
+		{
+			const size_t middle = (low + high) / 2;
+			if (ring.time[slot_of(ring, middle)] < time)
+				low = middle + 1;
+			else
+				high = middle;
+		}
+		return low;
+	}
+
+	void interpolate(const size_t* before, const size_t* after, const Lanes& weight,
+	                 const double time, JointFrame& frame) const
+	{
+		// Gather both ends into lanes, one lane per joint
+		Lanes a[lane_count], b[lane_count];
+		for (int c = 0; c < lane_count; c++)
+		{
+			a[c].setZero();
+			b[c].setZero();
+			for (uint32_t i = 0; i < mJointCount; i++)
+			{
+				if (before[i] == capacity) continue;
+				a[c][i] = mRings[i].channel[c][before[i]];
+				b[c][i] = mRings[i].channel[c][after[i]];
+			}
+		}
+
+		// Everything but orientation: lerp
+		Lanes out[lane_count];
+		for (int c = 0; c < lane_count; c++)
+			if (c < 3 || c >= 7)
+				out[c] = a[c] + (b[c] - a[c]) * weight;
+
+		// Orientation: slerp along the shorter arc, lerp where the two are too close for it
+		Lanes dot = a[3] * b[3] + a[4] * b[4] + a[5] * b[5] + a[6] * b[6];
+		const Lanes sign = (dot < 0.f).select(Lanes::Constant(-1.f), Lanes::Constant(1.f));
+		dot = (dot * sign).min(1.f);
+
+		const Lanes theta = dot.acos();
+		const Lanes sin_theta = theta.sin();
+		const auto close = sin_theta < 1e-4f;
+
+		const Lanes wa = close.select(1.f - weight, ((1.f - weight) * theta).sin() / sin_theta);
+		const Lanes wb = close.select(weight, (weight * theta).sin() / sin_theta) * sign;
+
+		for (int c = 3; c < 7; c++)
+			out[c] = a[c] * wa + b[c] * wb;
+
+		const Lanes norm = (out[3].square() + out[4].square() + out[5].square() + out[6].square()).sqrt()
+		                                                                                       .max(1e-12f);
+		for (int c = 3; c < 7; c++)
+			out[c] /= norm;
+
+		// Scatter back into the frame
+		for (uint32_t i = 0; i < mJointCount; i++)
+		{
+			if (before[i] == capacity) continue;
+
+			JointSample& sample = frame.joints[i];
+			float* channels[] = {
+				sample.position, sample.orientation, sample.linearVelocity,
+				sample.linearAcceleration, sample.angularVelocity, sample.angularAcceleration
+			};
+			for (int c = 0, lane = 0; c < 6; c++)
+				for (int k = 0; k < (c == 1 ? 4 : 3); k++, lane++)
+					channels[c][k] = out[lane][i];
+
+			const Ring& ring = mRings[i];
+			const bool exact = before[i] == after[i];
+			sample.sampleTime = exact ? ring.time[before[i]] : time;
+
+			// Tracked only if both ends were
+			sample.statusFlags = ring.status[before[i]] & ring.status[after[i]];
+		}
+	}
+
+	Ring mRings[max_frame_joints];
+	uint32_t mJointCount = 0;
+	uint64_t mObjectMask = 0;
+};
@@ -0,0 +1,263 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+
+#include "JointFrame.h"
+#include "MappedFile.h"
+
+// Pose recording format (.cv1poses):
+// [PoseRecordingHeader][PoseRecord]...[PoseRecord]
+// One fixed-size record per joint per frame, joints of a frame are stored back to back
+
+struct PoseRecordingHeader
+{
+	char magic[8] = {'C', 'V', '1', 'P', 'O', 'S', 'E', 'S'};
+	uint32_t version = 2; // 2: objectMask per record
+	uint32_t recordSize = 0; // sizeof(PoseRecord)
+	uint64_t recordCount = 0; // Updated after every frame
+};
+
+struct PoseRecord
+{
+	uint64_t frame = 0; // Frame sequence
+	long long hostTimestamp = 0; // AME_API_GET_TIMESTAMP_NOW (us)
+	double frameTime = 0.0; // Time the poses were requested for (SDK clock)
+	uint32_t joint = 0;
+	uint32_t jointCount = 0;
+	uint64_t objectMask = 0; // VR Object slots of the frame, see JointFrame
+	JointSample sample; // Raw, as LibOVR gave it to us
+};
+
+// Appends frames to a memory-mapped file, no syscalls unless the file has to grow
+class PoseRecorder
+{
+public:
+	// Files grow in chunks of this size
+	static constexpr size_t grow_bytes = 64ull << 20;
+
+	~PoseRecorder() { stop(); }
+
+	bool start(const std::filesystem::path& path)
+	{
+		stop();
+		if (!mFile.open(path, grow_bytes, true))
+			return false;
+
+		*header() = PoseRecordingHeader{};
+		header()->recordSize = sizeof(PoseRecord);
+		mFrames = 0;
+		return true;
+	}
+
+	void stop()
+	{
+		if (!mFile.is_open()) return;
+		mFile.close(used_bytes()); // Cut the unused tail off
+	}
+
+	[[nodiscard]] bool recording() const { return mFile.is_open(); }
+	[[nodiscard]] uint64_t records() const { return recording() ? header()->recordCount : 0; }
+
+	void record(const JointFrame& frame)
+	{
+		if (!recording() || frame.jointCount == 0) return;
+
+		const size_t needed = used_bytes() + sizeof(PoseRecord) * frame.jointCount;
+		if (needed > mFile.size() && !mFile.resize(mFile.size() + grow_bytes))
+		{
+			stop(); // Out of disk space or similar, don't keep trying every frame
+			return;
+		}
+
+		auto* records = reinterpret_cast<PoseRecord*>(mFile.data() + sizeof(PoseRecordingHeader));
+		PoseRecord* record = records + header()->recordCount;
+
+		for (uint32_t i = 0; i < frame.jointCount; i++, record++)
+		{
+			record->frame = mFrames;
+			record->hostTimestamp = frame.hostTimestamp;
+			record->frameTime = frame.frameTime;
+			record->joint = i;
+			record->jointCount = frame.jointCount;
+			record->objectMask = frame.objectMask;
+			record->sample = frame.joints[i];
+		}
+
+		// Publish the whole frame at once, so a crash never leaves half of one
+		header()->recordCount += frame.jointCount;
+		mFrames++;
+	}
+
+private:
+	[[nodiscard]] PoseRecordingHeader* header() const
+	{
+		return reinterpret_cast<PoseRecordingHeader*>(mFile.data());
+	}
+
+	[[nodiscard]] size_t used_bytes() const
+	{
+		return sizeof(PoseRecordingHeader) + sizeof(PoseRecord) * header()->recordCount;
+	}
+
+	MappedFile mFile;
+	uint64_t mFrames = 0;
+};
+
+// Plays a recording back frame by frame, looping at the end
+class PoseReplay
+{
+public:
+	enum Pacing
+	{
+		Replay_Off,
+		Replay_RealTime, // Frames come out as fast as they were recorded
+		Replay_AsFastAsPossible // Every call gets the next frame
+	};
+
+	bool open(const std::filesystem::path& path)
+	{
+		close();
+		if (!mFile.open(path, 0, false) || mFile.size() < sizeof(PoseRecordingHeader))
+		{
+			close();
+			return false;
+		}
+
+		const PoseRecordingHeader expected;
+		const auto* header = reinterpret_cast<const PoseRecordingHeader*>(mFile.data());
+		if (std::memcmp(header->magic, expected.magic, sizeof(expected.magic)) != 0 ||
+			header->version != expected.version || header->recordSize != sizeof(PoseRecord))
+		{
+			close();
+			return false;
+		}
+
+		// Trust the file size over the header if recording got cut short
+		mRecords = reinterpret_cast<const PoseRecord*>(mFile.data() + sizeof(PoseRecordingHeader));
+		mRecordCount = std::min<uint64_t>(header->recordCount,
+		                                  (mFile.size() - sizeof(PoseRecordingHeader)) / sizeof(PoseRecord));
+		measure_loop();
+		mLoopOffset = 0.0;
+		rewind();
+		return mRecordCount > 0;
+	}
+
+	void close()
+	{
+		mFile.close();
+		mRecords = nullptr;
+		mRecordCount = 0;
+	}
+
+	[[nodiscard]] bool is_open() const { return mRecords != nullptr; }
+
+	// Fills in the next frame, or the current one again if the next one isn't due yet
+	// (real-time pacing), returns false in the latter case
+	bool next(JointFrame& frame, const Pacing pacing)
+	{
+		if (!is_open()) return false;
+
+		if (pacing == Replay_RealTime && mCursor < mRecordCount)
+		{
+			const long long elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+				std::chrono::steady_clock::now() - mStartedAt).count();
+
+			if (mRecords[mCursor].hostTimestamp - mFirstTimestamp > elapsed)
+			{
+				fill(frame, mCurrent);
+				return false;
+			}
+		}
+
+		// Every loop carries on where the last one ended, time never runs backwards
+		if (mCursor >= mRecordCount)
+		{
+			mLoopOffset += mLoopSpan;
+			rewind();
+		}
+
+		mCurrent = mCursor;
+		mCursor += std::max<uint32_t>(mRecords[mCurrent].jointCount, 1);
+
+		fill(frame, mCurrent);
+		return true;
+	}
+
+private:
+	void fill(JointFrame& frame, const uint64_t cursor) const
+	{
+		const PoseRecord& first = mRecords[cursor];
+		const uint32_t count = std::min<uint32_t>(
+			{first.jointCount, max_frame_joints, static_cast<uint32_t>(mRecordCount - cursor)});
+
+		// Recorded on another run's clocks: SDK times shifted by the loops so far, host time is now
+		frame.frameTime = first.frameTime + mLoopOffset;
+		frame.sdkTime = frame.frameTime;
+		frame.hostTimestamp = frame.hostBefore = std::chrono::time_point_cast<std::chrono::microseconds>(
+			std::chrono::system_clock::now()).time_since_epoch().count();
+		frame.jointCount = count;
+		frame.objectMask = first.objectMask;
+
+		// Joints cut off at max_frame_joints (or a torn last frame) take their slots with them
+		for (uint32_t objects = std::popcount(frame.objectMask); objects > (count > 2 ? count - 2 : 0); objects--)
+			frame.objectMask &= ~(1ull << (63 - std::countl_zero(frame.objectMask)));
+		frame.clock = {}; // No mapping between those
+
+		for (uint32_t i = 0; i < count; i++)
+		{
+			frame.joints[i] = mRecords[cursor + i].sample;
+			if (frame.joints[i].sampleTime != 0.0)
+				frame.joints[i].sampleTime += mLoopOffset;
+		}
+	}
+
+	// How far every loop moves SDK times on: all the recording's times, plus one frame
+	void measure_loop()
+	{
+		double earliest = 0.0, latest = 0.0;
+		uint64_t frames = 0;
+		bool first = true;
+
+		for (uint64_t i = 0; i < mRecordCount; i++)
+		{
+			const PoseRecord& record = mRecords[i];
+			for (const double time : {record.frameTime, record.sample.sampleTime})
+			{
+				if (time == 0.0) continue;
+				earliest = first ? time : std::min<double>(earliest, time);
+				latest = first ? time : std::max<double>(latest, time);
+				first = false;
+			}
+			frames += record.joint == 0;
+		}
+
+		const double frame_span = mRecordCount > 0
+			                          ? mRecords[mRecordCount - 1].frameTime - mRecords[0].frameTime
+			                          : 0.0;
+		const double interval = frames > 1 ? frame_span / static_cast<double>(frames - 1) : 0.001;
+		mLoopSpan = latest - earliest + std::max<double>(interval, 1e-6);
+	}
+
+	void rewind()
+	{
+		mCursor = 0;
+		mCurrent = 0;
+		mFirstTimestamp = mRecordCount > 0 ? mRecords[0].hostTimestamp : 0;
+		mStartedAt = std::chrono::steady_clock::now();
+	}
+
+	MappedFile mFile;
+	const PoseRecord* mRecords = nullptr;
+	uint64_t mRecordCount = 0;
+
+	uint64_t mCursor = 0; // Next frame
+	uint64_t mCurrent = 0; // Last frame handed out
+	long long mFirstTimestamp = 0;
+	std::chrono::steady_clock::time_point mStartedAt;
+
+	double mLoopSpan = 0.0; // s, see measure_loop()
+	double mLoopOffset = 0.0; // Added to SDK times, grows every loop
+};
@@ -0,0 +1,156 @@
+#pragma once
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include "JointFrame.h"
+
+// How the SDK session is doing, see SessionWatchdog
+struct SessionSignals
+{
+	bool shouldRecreate = false; // The session is dead (e.g. the service restarted), only a new one helps
+	bool displayLost = false; // The HMD went away, a new session works once it's back
+	uint32_t errors = 0; // SDK calls that failed since the last time we asked
+	double sampleTime = 0.0; // Newest sample time the SDK handed out, 0 = don't know
+};
+
+// Everything acquire_frame() needs from the SDK, one call each
+// LibOVR is the real thing (see DeviceHandler.cpp), anything else is for testing
+class IPoseSource
+{
+public:
+	virtual ~IPoseSource() = default;
+
+	// ovr_GetTimeInSeconds
+	virtual double time_seconds() = 0;
+
+	// ovr_GetTrackingState: both Touch controllers, predicted for 'time'
+	virtual void hand_poses(double time, JointSample hands[2]) = 0;
+
+	// Which VR Object slots are connected, one bit each (ovr_GetConnectedControllerTypes)
+	// Can be slow, meant for the background scan and not for every frame
+	virtual uint64_t connected_objects() = 0;
+
+	// ovr_GetDevicePoses: the VR Objects in 'slots' in one batch, lowest slot first,
+	// predicted for 'time'
+	virtual bool object_poses(double time, uint64_t slots, JointSample* objects) = 0;
+
+	// ovr_GetSessionStatus, plus whatever failed in between
+	virtual SessionSignals session_signals() { return {}; }
+
+	// Tears the session down and makes a new one, keeping the device and window
+	// Only while nothing else calls into the source, returns false to be retried later
+	virtual bool recreate_session() { return true; }
+};
+
+// Grabs one frame, everything sampled for one single timestamp
+// with a fixed number of calls into the source
+// 'objects' are the VR Object slots to sample, as the last scan found them
+inline void acquire_frame(IPoseSource& source, JointFrame& frame, const double prediction, uint64_t objects)
+{
+	const auto host_now = []
+	{
+		return std::chrono::time_point_cast<std::chrono::microseconds>(
+			std::chrono::system_clock::now()).time_since_epoch().count();
+	};
+
+	frame.hostBefore = host_now();
+	frame.sdkTime = source.time_seconds();
+	frame.hostTimestamp = host_now();
+	frame.frameTime = frame.sdkTime + prediction;
+	frame.sdkCalls = 1;
+
+	source.hand_poses(frame.frameTime, frame.joints);
+	frame.sdkCalls++;
+
+	// All VR Objects in one go, at the very same time as the hands
+	const auto count = static_cast<uint32_t>(std::popcount(objects));
+	if (count > 0)
+	{
+		if (!source.object_poses(frame.frameTime, objects, frame.joints + 2))
+			std::fill_n(frame.joints + 2, count, JointSample{});
+		frame.sdkCalls++;
+	}
+
+	frame.jointCount = 2 + count;
+	frame.objectMask = objects;
+}
+
+// Synthetic stand-in for LibOVR: every device slowly circles its own spot
+// Poses are extrapolated from velocity when asked for a future time, like the SDK does
+class StubPoseSource : public IPoseSource
+{
+public:
+	explicit StubPoseSource(const uint32_t objects = 0) : mObjects(first_object_slots(objects))
+	{
+	}
+
+	void set_object_count(const uint32_t objects) { mObjects = first_object_slots(objects); }
+
+	// Plugging VR Objects in and out while running
+	void connect(const uint32_t slot) { mObjects |= 1ull << slot; }
+	void disconnect(const uint32_t slot) { mObjects &= ~(1ull << slot); }
+
+	double time_seconds() override
+	{
+		mCalls++;
+		return std::chrono::duration<double>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	void hand_poses(const double time, JointSample hands[2]) override
+	{
+		mCalls++;
+		for (uint32_t i = 0; i < 2; i++)
+			synthesize(i, time, hands[i]);
+	}
+
+	uint64_t connected_objects() override { return mObjects; }
+
+	bool object_poses(const double time, uint64_t slots, JointSample* objects) override
+	{
+		mCalls++;
+		for (; slots; slots &= slots - 1)
+			synthesize(2 + std::countr_zero(slots), time, *objects++);
+		return true;
+	}
+
+	[[nodiscard]] uint64_t calls() const { return mCalls; }
+
+private:
+	void synthesize(const uint32_t device, const double time, JointSample& sample) const
+	{
+		// Sampled a couple of ms ago, like real poses
+		const double sample_time = std::floor(time * 1000.0) / 1000.0 - 0.002;
+		const double phase = sample_time * 0.5 + device * 0.7;
+		const double radius = 0.1;
+
+		sample.position[0] = static_cast<float>(device * 0.3 + radius * std::cos(phase));
+		sample.position[1] = static_cast<float>(1.0 + radius * std::sin(phase));
+		sample.position[2] = static_cast<float>(-0.5);
+
+		sample.linearVelocity[0] = static_cast<float>(-radius * 0.5 * std::sin(phase));
+		sample.linearVelocity[1] = static_cast<float>(radius * 0.5 * std::cos(phase));
+		sample.linearVelocity[2] = 0.f;
+
+		const double half_angle = phase * 0.5;
+		sample.orientation[0] = 0.f;
+		sample.orientation[1] = static_cast<float>(std::sin(half_angle));
+		sample.orientation[2] = 0.f;
+		sample.orientation[3] = static_cast<float>(std::cos(half_angle));
+
+		sample.angularVelocity[1] = 0.5f;
+		sample.sampleTime = sample_time;
+		sample.statusFlags = status_orientation_tracked | status_position_tracked;
+
+		// Predict forward from the sample, if asked for a later time
+		if (const double ahead = time - sample_time; ahead > 0.0)
+			for (int c = 0; c < 3; c++)
+				sample.position[c] += static_cast<float>(sample.linearVelocity[c] * ahead);
+	}
+
+	uint64_t mObjects = 0; // Connected slots
+	uint64_t mCalls = 0;
+};
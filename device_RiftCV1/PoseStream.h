@@ -0,0 +1,251 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "PoseCodec.h"
+
+// Pose streaming over UDP: every applied frame goes out as one datagram (PoseCodec.h),
+// to localhost or anywhere else; PoseStreamReceiver is all a tool needs on the other end
+constexpr uint16_t pose_stream_port = 7755;
+
+// Just enough of a UDP socket for both ends, non-blocking sends
+class UdpSocket
+{
+public:
+	UdpSocket() = default;
+	UdpSocket(const UdpSocket&) = delete;
+	UdpSocket& operator=(const UdpSocket&) = delete;
+
+	~UdpSocket() { close(); }
+
+	// Sender: 'address' is where datagrams go; receiver: 'address' is what to listen on
+	bool open(const std::string& address, const uint16_t port, const bool receive)
+	{
+		close();
+
+#ifdef _WIN32
+		WSADATA wsa{};
+		if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) return false;
+		mStarted = true;
+#endif
+
+		mAddress = {};
+		mAddress.sin_family = AF_INET;
+		mAddress.sin_port = htons(port);
+		if (inet_pton(AF_INET, address.c_str(), &mAddress.sin_addr) != 1)
+		{
+			close();
+			return false;
+		}
+
+		mSocket = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+		if (!is_open())
+		{
+			close();
+			return false;
+		}
+
+		if (receive)
+		{
+			// Bigger receive buffer, a busy reader shouldn't drop a burst right away
+			const int buffer = 1 << 20;
+			setsockopt(mSocket, SOL_SOCKET, SO_RCVBUF, reinterpret_cast<const char*>(&buffer), sizeof(buffer));
+
+			if (bind(mSocket, reinterpret_cast<const sockaddr*>(&mAddress), sizeof(mAddress)) != 0)
+			{
+				close();
+				return false;
+			}
+		}
+		else
+		{
+			// update() never waits on the network, a full send buffer just drops the frame
+#ifdef _WIN32
+			u_long non_blocking = 1;
+			ioctlsocket(mSocket, FIONBIO, &non_blocking);
+#else
+			fcntl(mSocket, F_SETFL, fcntl(mSocket, F_GETFL) | O_NONBLOCK);
+#endif
+		}
+		return true;
+	}
+
+	void close()
+	{
+		if (is_open())
+		{
+#ifdef _WIN32
+			closesocket(mSocket);
+#else
+			::close(mSocket);
+#endif
+		}
+		mSocket = invalid_socket;
+
+#ifdef _WIN32
+		if (mStarted) WSACleanup();
+		mStarted = false;
+#endif
+	}
+
+	[[nodiscard]] bool is_open() const { return mSocket != invalid_socket; }
+
+	bool send(const uint8_t* data, const size_t size) const
+	{
+		return sendto(mSocket, reinterpret_cast<const char*>(data), static_cast<int>(size), 0,
+		              reinterpret_cast<const sockaddr*>(&mAddress), sizeof(mAddress)) == static_cast<int>(size);
+	}
+
+	// Waits up to 'timeout_ms' for a datagram, returns its size (0: nothing came)
+	size_t receive(uint8_t* data, const size_t capacity, const int timeout_ms) const
+	{
+#ifdef _WIN32
+		WSAPOLLFD poll_fd{mSocket, POLLRDNORM, 0};
+		if (WSAPoll(&poll_fd, 1, timeout_ms) <= 0) return 0;
+#else
+		pollfd poll_fd{mSocket, POLLIN, 0};
+		if (poll(&poll_fd, 1, timeout_ms) <= 0) return 0;
+#endif
+
+		const auto received = recv(mSocket, reinterpret_cast<char*>(data), static_cast<int>(capacity), 0);
+		return received > 0 ? static_cast<size_t>(received) : 0;
+	}
+
+private:
+#ifdef _WIN32
+	using socket_type = SOCKET;
+	static constexpr socket_type invalid_socket = INVALID_SOCKET;
+	bool mStarted = false;
+#else
+	using socket_type = int;
+	static constexpr socket_type invalid_socket = -1;
+#endif
+
+	socket_type mSocket = invalid_socket;
+	sockaddr_in mAddress{};
+};
+
+// Plugin side: encodes and sends, host thread only
+class PoseStreamSender
+{
+public:
+	bool open(const std::string& address, const uint16_t port = pose_stream_port)
+	{
+		mEncoder.reset();
+		mSent = mDropped = mBytes = 0;
+		return mSocket.open(address, port, false);
+	}
+
+	void close() { mSocket.close(); }
+	[[nodiscard]] bool is_open() const { return mSocket.is_open(); }
+
+	// Tracking space point positions are sent relative to, keeps them in range
+	void set_origin(const float x, const float y, const float z)
+	{
+		mEncoder.origin[0] = x;
+		mEncoder.origin[1] = y;
+		mEncoder.origin[2] = z;
+	}
+
+	// 'host_timestamp': AME_API_GET_TIMESTAMP_NOW, goes along with the frame
+	void send(const JointFrame& frame, const long long host_timestamp)
+	{
+		if (!is_open()) return;
+
+		const size_t size = mEncoder.encode(frame, host_timestamp, mBuffer, sizeof(mBuffer));
+		if (size > 0 && mSocket.send(mBuffer, size))
+		{
+			mSent++;
+			mBytes += size;
+		}
+		else
+			mDropped++;
+	}
+
+	[[nodiscard]] uint64_t sent() const { return mSent; }
+	[[nodiscard]] uint64_t dropped() const { return mDropped; }
+	[[nodiscard]] uint64_t bytes() const { return mBytes; }
+
+private:
+	UdpSocket mSocket;
+	PoseEncoder mEncoder;
+	uint8_t mBuffer[pose_codec::max_bytes];
+
+	uint64_t mSent = 0;
+	uint64_t mDropped = 0; // Didn't fit or the socket wouldn't take it
+	uint64_t mBytes = 0;
+};
+
+// The receiver library: open() on the port, then receive() in a loop
+class PoseStreamReceiver
+{
+public:
+	struct Stats
+	{
+		uint64_t frames = 0;
+		uint64_t lost = 0; // Sequence numbers we never saw
+		uint64_t stale = 0; // Came in after a newer one
+		uint64_t bad = 0; // Not a pose datagram
+	};
+
+	// "127.0.0.1" for localhost only, "0.0.0.0" for anything that reaches this machine
+	bool open(const uint16_t port = pose_stream_port, const std::string& address = "127.0.0.1")
+	{
+		mDecoder.reset();
+		mStats = {};
+		return mSocket.open(address, port, true);
+	}
+
+	void close() { mSocket.close(); }
+	[[nodiscard]] bool is_open() const { return mSocket.is_open(); }
+
+	// Next frame into 'frame', waiting up to 'timeout_ms' for it
+	// 'host_timestamp' is the sender's clock (us) when it sent it
+	// Decode_NoVelocities still has valid poses, only velocities are zero
+	bool receive(JointFrame& frame, long long& host_timestamp, const int timeout_ms = 100,
+	             PoseDecoder::Result* result = nullptr)
+	{
+		const size_t size = mSocket.receive(mBuffer, sizeof(mBuffer), timeout_ms);
+		if (size == 0) return false;
+
+		const uint32_t previous = mDecoder.sequence();
+		const PoseDecoder::Result decoded = mDecoder.decode(mBuffer, size, frame, host_timestamp);
+		if (result) *result = decoded;
+
+		switch (decoded)
+		{
+		case PoseDecoder::Decode_Stale:
+			mStats.stale++;
+			return false;
+		case PoseDecoder::Decode_Bad:
+			mStats.bad++;
+			return false;
+		default:
+			if (previous != 0 && frame.sequence > previous + 1)
+				mStats.lost += frame.sequence - previous - 1;
+			mStats.frames++;
+			return true;
+		}
+	}
+
+	[[nodiscard]] const Stats& stats() const { return mStats; }
+
+private:
+	UdpSocket mSocket;
+	PoseDecoder mDecoder;
+	uint8_t mBuffer[pose_codec::max_bytes + 64];
+	Stats mStats;
+};
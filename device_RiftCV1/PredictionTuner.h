@@ -0,0 +1,227 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+
+#include <Eigen/Dense>
+
+#include "JointFrame.h"
+#include "PoseExtrapolator.h"
+#include "PoseHistory.h"
+#include "SampleWindow.h"
+
+// Fits a prediction horizon per device from how its own predictions turn out
+// Frames come in at SDK horizon 0: the SDK already carries every device from its sample
+// time up to when the frame was taken (frameTime = sdkTime), h is the look-ahead on top
+// of that. Both ends of 'd' below carry that same few-ms lead, so it drops out of the fit
+// (the history is keyed by sample time either way). Once 'target' seconds have passed, a
+// sample's pose extrapolated by h from its velocities can be compared with where the
+// device actually went; the h that fits best is the least-squares solution
+//   h = sum(u . d) / sum(u . u),  d = p(t + target) - p(t),  u = v + a * target / 2
+// kept in exponential windows per speed band, so slow and fast motion get their own
+// (velocity estimates tend to lag more the faster things move)
+// Predicting by those horizons is up to PoseExtrapolator, with the same kinematics
+// Host thread only, like the frames it learns from
+class PredictionTuner
+{
+public:
+	static constexpr int bands = 3;
+
+	struct Settings
+	{
+		float window = 10.0f; // s of sample time the fit remembers
+		float bandSpeeds[bands] = {0.1f, 0.5f, 1.5f}; // m/s each band is centered at
+		float minSamples = 200.0f; // Samples (windowed) a band needs before its fit is used
+		float maxHorizon = 0.15f; // s, fits are clamped to 0..this
+	};
+
+	// One device's fit, see band()
+	struct Band
+	{
+		double horizon = 0.0; // s, what the fit says (target until there's enough motion)
+		double samples = 0.0; // In the window, shared with neighbouring bands
+		double targetError = 0.0; // mm RMS extrapolating by 'target'
+		double fittedError = 0.0; // mm RMS extrapolating by 'horizon'
+	};
+
+	Settings settings;
+
+	PredictionTuner() { reset(); }
+
+	void reset()
+	{
+		mHistory.reset();
+		for (Lane& lane : mLanes)
+			lane = {};
+	}
+
+	// The horizon every prediction should land at, s; a new one starts the fits over
+	void set_target(const double target)
+	{
+		const double clamped = std::clamp<double>(target, 0.0, settings.maxHorizon);
+		if (clamped == mTarget) return;
+
+		mTarget = clamped;
+		for (Lane& lane : mLanes)
+			lane = {};
+	}
+
+	[[nodiscard]] double target() const { return mTarget; }
+
+	// Frames as of when they were taken (horizon 0), in order; fits every device that got a new sample
+	void observe(const JointFrame& frame)
+	{
+		mHistory.push(frame);
+		if (mTarget <= 0.0) return; // Nothing to fit
+
+		// Where every joint was 'target' ago, interpolated like any other past pose
+		if (!mHistory.sample(frame.frameTime - mTarget, mPast)) return;
+
+		uint64_t objects = frame.objectMask;
+		for (uint32_t i = 0; i < frame.jointCount; i++)
+		{
+			const int lane = device_lane(i, objects);
+			if (lane < 0) break;
+
+			const JointSample& now = frame.joints[i];
+			const JointSample& past = mPast.joints[i];
+			Lane& state = mLanes[lane];
+
+			// New, tracked samples only
+			if (now.sampleTime <= state.lastSample ||
+				!(now.statusFlags & past.statusFlags & status_position_tracked))
+				continue;
+
+			const float dt = state.lastSample > 0.0 ? static_cast<float>(now.sampleTime - state.lastSample) : 0.f;
+			state.lastSample = now.sampleTime;
+
+			// Devices sample on their own clocks, so the span isn't exactly 'target';
+			// scaled to it, as long as it's close (the history reached back far enough)
+			const double span = now.sampleTime - past.sampleTime;
+			if (dt <= 0.f || span < mTarget * 0.5 || span > mTarget * 2.0) continue;
+
+			const Eigen::Vector3f d = (Eigen::Map<const Eigen::Vector3f>(now.position) -
+				Eigen::Map<const Eigen::Vector3f>(past.position)) * static_cast<float>(mTarget / span);
+			const Eigen::Vector3f u = Eigen::Map<const Eigen::Vector3f>(past.linearVelocity) +
+				Eigen::Map<const Eigen::Vector3f>(past.linearAcceleration) * static_cast<float>(mTarget * 0.5);
+
+			// Every band learns from every sample, weighted by how close the speed is to it
+			const float speed = Eigen::Map<const Eigen::Vector3f>(past.linearVelocity).norm();
+			const Eigen::Array<float, bands, 1> share = band_weights(speed);
+			const float alpha = window_weight(dt, settings.window);
+
+			// Errors with what we'd have predicted before this sample
+			const float target_error = (d - u * static_cast<float>(mTarget)).squaredNorm();
+			const float fitted_error = (d - u * horizon_at(fit(state), speed)).squaredNorm();
+
+			// Windowed means per band; their ratio is the windowed least-squares fit
+			const Eigen::Array<float, bands, 1> weight = alpha * share;
+			state.uu += weight * (u.squaredNorm() - state.uu);
+			state.ud += weight * (u.dot(d) - state.ud);
+			state.targetError += weight * (target_error - state.targetError);
+			state.fittedError += weight * (fitted_error - state.fittedError);
+			state.samples = state.samples * (1.f - alpha) + share;
+		}
+	}
+
+	// Every joint of 'frame' its own horizon, for PoseExtrapolator to predict them by
+	void horizons(const JointFrame& frame, PoseExtrapolator::Horizons& out) const
+	{
+		out.fill(0.f);
+
+		uint64_t objects = frame.objectMask;
+		for (uint32_t i = 0; i < frame.jointCount; i++)
+		{
+			const int lane = device_lane(i, objects);
+			if (lane < 0) break;
+
+			out[i] = horizon(lane, Eigen::Map<const Eigen::Vector3f>(frame.joints[i].linearVelocity).norm());
+		}
+	}
+
+	// s, for the device's current speed (m/s); the target until a band has enough data
+	[[nodiscard]] float horizon(const int lane, const float speed) const
+	{
+		return horizon_at(fit(mLanes[lane]), speed);
+	}
+
+	// What one speed band of a device (see device_lane()) has learned
+	[[nodiscard]] Band band(const int lane, const int index) const
+	{
+		const Lane& state = mLanes[lane];
+		Band out;
+		out.horizon = fit(state)[index];
+		out.samples = state.samples[index];
+		out.targetError = std::sqrt(static_cast<double>(state.targetError[index])) * 1000.0;
+		out.fittedError = std::sqrt(static_cast<double>(state.fittedError[index])) * 1000.0;
+		return out;
+	}
+
+	// Frame joint -> device (Touch 0/1, VR Object slot n -> 2 + n), -1 past the last one
+	// 'objects' starts as the frame's objectMask and is consumed along the way
+	static int device_lane(const uint32_t joint, uint64_t& objects)
+	{
+		if (joint < 2) return static_cast<int>(joint);
+		if (objects == 0) return -1;
+
+		const int lane = 2 + std::countr_zero(objects);
+		objects &= objects - 1;
+		return lane;
+	}
+
+private:
+	struct Lane
+	{
+		double lastSample = 0.0;
+
+		// Per band: decayed sample count, then windowed means
+		Eigen::Array<float, bands, 1> samples = Eigen::Array<float, bands, 1>::Zero();
+		Eigen::Array<float, bands, 1> uu = Eigen::Array<float, bands, 1>::Zero();
+		Eigen::Array<float, bands, 1> ud = Eigen::Array<float, bands, 1>::Zero();
+		Eigen::Array<float, bands, 1> targetError = Eigen::Array<float, bands, 1>::Zero(); // m^2
+		Eigen::Array<float, bands, 1> fittedError = Eigen::Array<float, bands, 1>::Zero();
+	};
+
+	// How much of a sample at 'speed' goes to each band: linear between band centers
+	[[nodiscard]] Eigen::Array<float, bands, 1> band_weights(const float speed) const
+	{
+		Eigen::Array<float, bands, 1> share = Eigen::Array<float, bands, 1>::Zero();
+		if (speed <= settings.bandSpeeds[0])
+			share[0] = 1.f;
+		else if (speed >= settings.bandSpeeds[bands - 1])
+			share[bands - 1] = 1.f;
+		else
+			for (int b = 0; b + 1 < bands; b++)
+				if (speed < settings.bandSpeeds[b + 1])
+				{
+					const float t = (speed - settings.bandSpeeds[b]) /
+						(settings.bandSpeeds[b + 1] - settings.bandSpeeds[b]);
+					share[b] = 1.f - t;
+					share[b + 1] = t;
+					break;
+				}
+		return share;
+	}
+
+	// Per band: the least-squares horizon, or the target while there's too little motion
+	[[nodiscard]] Eigen::Array<float, bands, 1> fit(const Lane& state) const
+	{
+		const Eigen::Array<float, bands, 1> ready =
+			(state.samples >= settings.minSamples && state.uu > 1e-8f).cast<float>();
+		const Eigen::Array<float, bands, 1> fitted =
+			(state.ud / state.uu.max(1e-12f)).max(0.f).min(settings.maxHorizon);
+		return ready * fitted + (1.f - ready) * static_cast<float>(mTarget);
+	}
+
+	[[nodiscard]] float horizon_at(const Eigen::Array<float, bands, 1>& horizons, const float speed) const
+	{
+		return (band_weights(speed) * horizons).sum();
+	}
+
+	double mTarget = 0.011;
+	PoseHistory mHistory;
+	JointFrame mPast;
+	std::array<Lane, max_frame_joints> mLanes;
+};
@@ -0,0 +1,158 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+#include <Eigen/Dense>
+
+#include "DeadReckoning.h"
+#include "PredictionTuner.h"
+#include "SimulatedPoseSource.h"
+
+// Scripted dropouts through DeadReckoning, against the same motion without them
+struct ReckoningBenchmarkResult
+{
+	double budgetMs = 0.0;
+	uint32_t losses = 0;
+	uint32_t expired = 0;
+
+	// Mean position error this far into a loss: holding the last pose vs extrapolating
+	static constexpr int spans = 3;
+	double spanMs[spans] = {50.0, 100.0, 250.0};
+	double heldMm[spans] = {};
+	double reckonedMm[spans] = {};
+
+	double snapMm = 0.0; // Mean jump at reacquisition, if it weren't blended
+	double blendStepMm = 0.0; // Worst per-frame step while blending, beyond the real motion
+};
+
+// 'seconds' of fixed 1 ms steps with every device dropping out every 'dropout_every'
+// for 'dropout_length'; the same source without dropouts is the truth
+inline ReckoningBenchmarkResult benchmark_dead_reckoning(const double seconds = 30.0, const double dropout_every = 1.0,
+                                                         const double dropout_length = 0.3,
+                                                         const double budget = 0.25)
+{
+	SimulationSettings settings;
+	settings.objects = 4;
+	settings.orbitSpeed = 4.0; // Quick enough that holding still is noticeably wrong
+	settings.shakeAmplitude = 0.0005;
+	settings.dropoutEvery = dropout_every;
+	settings.dropoutLength = dropout_length;
+
+	SimulatedPoseSource source(settings);
+	settings.dropoutEvery = 0.0;
+	SimulatedPoseSource truth(settings);
+	source.set_fixed_step(0.001);
+	truth.set_fixed_step(0.001);
+
+	DeadReckoning reckoning;
+	reckoning.settings.budget = budget;
+
+	ReckoningBenchmarkResult result;
+	result.budgetMs = budget * 1000.0;
+
+	struct Lane
+	{
+		DeadReckoning::Phase phase = DeadReckoning::Phase_Tracked;
+		double lostAt = 0.0;
+		Eigen::Vector3f held = Eigen::Vector3f::Zero(); // Last good position
+		Eigen::Vector3f out = Eigen::Vector3f::Zero(); // Last one that went out
+		Eigen::Vector3f real = Eigen::Vector3f::Zero(); // And where it really was
+	};
+	std::array<Lane, max_frame_joints> lanes;
+
+	double held_sum[ReckoningBenchmarkResult::spans] = {};
+	double reckoned_sum[ReckoningBenchmarkResult::spans] = {};
+	uint32_t span_count[ReckoningBenchmarkResult::spans] = {};
+	uint32_t snaps = 0;
+
+	JointFrame frame, real;
+	const uint64_t objects = first_object_slots(settings.objects);
+	const auto frames = static_cast<uint32_t>(seconds * 1000.0);
+	for (uint32_t n = 0; n < frames; n++)
+	{
+		acquire_frame(source, frame, 0.0, objects);
+		acquire_frame(truth, real, 0.0, objects);
+		reckoning.apply(frame);
+
+		uint64_t mask = frame.objectMask;
+		for (uint32_t i = 0; i < frame.jointCount; i++)
+		{
+			const int device = PredictionTuner::device_lane(i, mask);
+			if (device < 0) break;
+
+			Lane& lane = lanes[device];
+			const DeadReckoning::Phase phase = reckoning.phase(device);
+			const Eigen::Vector3f out = Eigen::Map<const Eigen::Vector3f>(frame.joints[i].position);
+			const Eigen::Vector3f now = Eigen::Map<const Eigen::Vector3f>(real.joints[i].position);
+
+			if (phase == DeadReckoning::Phase_Reckoning || phase == DeadReckoning::Phase_Lost)
+			{
+				if (lane.phase != DeadReckoning::Phase_Reckoning && lane.phase != DeadReckoning::Phase_Lost)
+				{
+					lane.lostAt = frame.frameTime - 0.001;
+					lane.held = lane.out;
+				}
+
+				// Bucketed by how long it's been, extrapolation only while it's still going
+				const double elapsed_ms = (frame.frameTime - lane.lostAt) * 1000.0;
+				for (int s = 0; s < ReckoningBenchmarkResult::spans; s++)
+					if (elapsed_ms <= result.spanMs[s] && (s == 0 || elapsed_ms > result.spanMs[s - 1]))
+					{
+						held_sum[s] += (lane.held - now).norm() * 1000.0;
+						reckoned_sum[s] += (out - now).norm() * 1000.0;
+						span_count[s]++;
+					}
+			}
+			else if (phase == DeadReckoning::Phase_Blending)
+			{
+				if (lane.phase != DeadReckoning::Phase_Blending)
+				{
+					result.snapMm += (now - lane.out).norm() * 1000.0;
+					snaps++;
+				}
+				const double step = ((out - lane.out).norm() - (now - lane.real).norm()) * 1000.0;
+				result.blendStepMm = std::max<double>(result.blendStepMm, step);
+			}
+
+			lane.phase = phase;
+			lane.out = out;
+			lane.real = now;
+		}
+	}
+
+	for (int s = 0; s < ReckoningBenchmarkResult::spans; s++)
+		if (span_count[s] > 0)
+		{
+			result.heldMm[s] = held_sum[s] / span_count[s];
+			result.reckonedMm[s] = reckoned_sum[s] / span_count[s];
+		}
+	if (snaps > 0) result.snapMm /= snaps;
+
+	result.losses = static_cast<uint32_t>(reckoning.stats().losses);
+	result.expired = static_cast<uint32_t>(reckoning.stats().expired);
+	return result;
+}
+
+inline std::string to_json(const ReckoningBenchmarkResult& result)
+{
+	char line[256];
+	std::snprintf(line, sizeof(line),
+	              "{\"budget_ms\": %.0f, \"losses\": %u, \"expired\": %u, "
+	              "\"snap_mm\": %.2f, \"blend_step_mm\": %.3f, \"spans\": [\n",
+	              result.budgetMs, result.losses, result.expired,
+	              result.snapMm, result.blendStepMm);
+	std::string json = line;
+
+	for (int s = 0; s < ReckoningBenchmarkResult::spans; s++)
+	{
+		std::snprintf(line, sizeof(line),
+		              "  {\"within_ms\": %.0f, \"held_mm\": %.2f, \"reckoned_mm\": %.2f}%s\n",
+		              result.spanMs[s], result.heldMm[s], result.reckonedMm[s],
+		              s + 1 < ReckoningBenchmarkResult::spans ? "," : "");
+		json += line;
+	}
+	return json + "]}";
+}
@@ -0,0 +1,159 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BenchmarkSetup.h"
+#include "CommandWorker.h"
+#include "SessionWatchdog.h"
+#include "SimulatedPoseSource.h"
+
+// Lost sessions of one kind against the watchdog, times from when the session died
+struct RecoveryBenchmarkResult
+{
+	SimulatedPoseSource::SessionFault fault = SimulatedPoseSource::Fault_None;
+	uint32_t recreateFailures = 0; // Per loss, before an attempt goes through
+	uint32_t losses = 0;
+
+	double detectMs = 0.0; // Died -> noticed
+	double recoverMs = 0.0; // Noticed -> new session
+	double downMs = 0.0; // Died -> tracked poses again
+	double worstDownMs = 0.0;
+	double attemptsPerLoss = 0.0;
+};
+
+// Sampling at 'rate_hz' with the session dying every 'loss_every' seconds, each kind of loss
+// once without and once with failing recreate attempts; 'losses' of every kind
+// Always against SimulatedPoseSource, it's the one that can die
+inline std::vector<RecoveryBenchmarkResult> benchmark_recovery(const uint32_t losses = 8, const uint32_t rate_hz = 1000,
+                                                               const double loss_every = 0.3)
+{
+	using clock = std::chrono::steady_clock;
+	std::vector<RecoveryBenchmarkResult> results;
+
+	const auto seconds = []
+	{
+		return std::chrono::duration<double>(clock::now().time_since_epoch()).count();
+	};
+	const auto period = std::chrono::nanoseconds(1'000'000'000 / std::max<uint32_t>(rate_hz, 1));
+
+	for (const uint32_t failures : {0u, 2u})
+	{
+		SimulationSettings settings;
+		settings.objects = 2;
+		settings.dropoutEvery = 0.0;
+		settings.sessionLossEvery = loss_every;
+		settings.recreateFailures = failures;
+		settings.recreateSeconds = 0.002; // ovr_Create + swap chains, roughly
+		SimulatedPoseSource source(settings);
+
+		SessionWatchdog watchdog;
+		CommandWorker worker;
+		worker.start();
+
+		RecoveryBenchmarkResult kinds[SimulatedPoseSource::Fault_Count];
+		for (int k = 0; k < SimulatedPoseSource::Fault_Count; k++)
+		{
+			kinds[k].fault = static_cast<SimulatedPoseSource::SessionFault>(k);
+			kinds[k].recreateFailures = failures;
+		}
+
+		JointFrame frame;
+		SimulatedPoseSource::SessionFault fault = SimulatedPoseSource::Fault_None;
+		double died = 0.0, noticed = 0.0;
+		bool down = false;
+
+		const uint32_t total = losses * (SimulatedPoseSource::Fault_Count - 1);
+		const auto until = clock::now() + std::chrono::seconds(60); // Whatever happens
+		uint32_t recovered = 0;
+
+		while (recovered < total && clock::now() < until)
+		{
+			const auto next = clock::now() + period;
+
+			if (watchdog.health() == SessionWatchdog::Session_Healthy)
+			{
+				acquire_frame(source, frame, 0.0, first_object_slots(settings.objects));
+
+				if (!down && source.fault() != SimulatedPoseSource::Fault_None)
+				{
+					down = true;
+					fault = source.fault();
+					died = source.fault_time();
+					noticed = 0.0;
+				}
+				else if (down && noticed > 0.0 && frame.joints[0].statusFlags & status_position_tracked)
+				{
+					RecoveryBenchmarkResult& kind = kinds[fault];
+					const double down_ms = (seconds() - died) * 1000.0;
+					kind.downMs += down_ms;
+					kind.worstDownMs = std::max<double>(kind.worstDownMs, down_ms);
+					kind.losses++;
+					down = false;
+					recovered++;
+				}
+
+				if (watchdog.due(frame.sdkTime))
+				{
+					SessionSignals signals = source.session_signals();
+					for (uint32_t i = 0; i < frame.jointCount; i++)
+						signals.sampleTime = std::max<double>(signals.sampleTime, frame.joints[i].sampleTime);
+					watchdog.observe(frame.sdkTime, signals);
+				}
+			}
+
+			if (watchdog.health() == SessionWatchdog::Session_Lost)
+			{
+				noticed = seconds();
+				kinds[fault].detectMs += (noticed - died) * 1000.0;
+
+				const uint64_t attempts_before = watchdog.stats().attempts;
+				watchdog.recover(worker, [&source] { return source.recreate_session(); });
+
+				// Nothing samples meanwhile, like update() while the session's down
+				while (watchdog.health() != SessionWatchdog::Session_Healthy && clock::now() < until)
+					std::this_thread::sleep_for(std::chrono::microseconds(100));
+
+				const SessionWatchdog::Stats stats = watchdog.stats();
+				kinds[fault].recoverMs += stats.lastMilliseconds;
+				kinds[fault].attemptsPerLoss += static_cast<double>(stats.attempts - attempts_before);
+			}
+
+			std::this_thread::sleep_until(next);
+		}
+		worker.stop();
+
+		for (int k = 1; k < SimulatedPoseSource::Fault_Count; k++)
+		{
+			RecoveryBenchmarkResult& kind = kinds[k];
+			if (kind.losses == 0) continue;
+
+			const double n = kind.losses;
+			kind.detectMs /= n;
+			kind.recoverMs /= n;
+			kind.downMs /= n;
+			kind.attemptsPerLoss /= n;
+			results.push_back(kind);
+		}
+	}
+	return results;
+}
+
+inline std::string to_json(const RecoveryBenchmarkResult& result)
+{
+	constexpr const char* faults[] = {"none", "stall", "recreate", "display_lost", "errors"};
+
+	char json[384];
+	std::snprintf(json, sizeof(json),
+	              "{\"fault\": \"%s\", \"recreate_failures\": %u, \"losses\": %u, "
+	              "\"detect_ms\": %.1f, \"recover_ms\": %.1f, \"down_ms\": %.1f, "
+	              "\"worst_down_ms\": %.1f, \"attempts_per_loss\": %.2f}",
+	              faults[result.fault], result.recreateFailures, result.losses,
+	              result.detectMs, result.recoverMs, result.downMs,
+	              result.worstDownMs, result.attemptsPerLoss);
+	return json;
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+// Weight of one sample in an exponential window with a time constant of 'window' s,
+// the sample 'dt' s after the one before: mean += weight * (value - mean)
+// dt / (dt + window) is 1 - exp(-dt / window) to first order, without the exp
+// 'dt' is a float, or an Eigen array of them (one lane per joint)
+template <class Interval>
+auto window_weight(const Interval& dt, const float window)
+{
+	return dt / (dt + window);
+}
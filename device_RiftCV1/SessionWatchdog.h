@@ -0,0 +1,207 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+
+#include "CommandWorker.h"
+#include "PoseSource.h"
+
+// Notices a dead SDK session and brings a new one up, retrying with backoff
+// observe() runs wherever sampling does, recover() on the host thread once nothing
+// touches the session anymore; attempts then run on a worker until one goes through
+class SessionWatchdog
+{
+public:
+	enum Health
+	{
+		Session_Healthy,
+		Session_Lost, // Noticed, nobody's recovering yet
+		Session_Recovering
+	};
+
+	enum Cause
+	{
+		Loss_None,
+		Loss_Stalled, // Sample times stopped moving
+		Loss_Recreate,
+		Loss_DisplayLost,
+		Loss_Errors // SDK calls kept failing
+	};
+
+	struct Settings
+	{
+		double checkInterval = 0.02; // s between looks at the session (SDK clock)
+		double stallSeconds = 0.25; // No new sample for this long: lost
+		uint32_t errorChecks = 5; // Checks in a row that saw failed calls: lost
+
+		// First attempt right away, then doubling up to the cap
+		std::chrono::milliseconds retryDelay{50};
+		std::chrono::milliseconds maxRetryDelay{5000};
+	};
+
+	struct Stats
+	{
+		uint64_t losses = 0;
+		uint64_t attempts = 0; // Recreate calls, successful or not
+		double lastMilliseconds = 0.0; // Noticed -> healthy again
+		double meanMilliseconds = 0.0;
+		double worstMilliseconds = 0.0;
+		Cause lastCause = Loss_None;
+	};
+
+	Settings settings;
+
+	// Back to healthy, forgets the statistics too
+	void reset()
+	{
+		std::lock_guard lock(mMutex);
+		mHealth = Session_Healthy;
+		mGeneration++;
+		mStats = {};
+		rearm();
+	}
+
+	[[nodiscard]] Health health() const { return mHealth.load(std::memory_order_acquire); }
+
+	// Bumped on every loss, attempts from before a reset() see it changed and drop out
+	[[nodiscard]] uint64_t generation() const
+	{
+		std::lock_guard lock(mMutex);
+		return mGeneration;
+	}
+
+	[[nodiscard]] Stats stats() const
+	{
+		std::lock_guard lock(mMutex);
+		return mStats;
+	}
+
+	// Cheap enough for every frame: whether observe() wants to see the session again
+	[[nodiscard]] bool due(const double sdk_time) const
+	{
+		return sdk_time - mLastCheck >= settings.checkInterval;
+	}
+
+	// Sampling thread, 'sdk_time' is the frame's
+	void observe(const double sdk_time, const SessionSignals& signals)
+	{
+		if (health() != Session_Healthy) return;
+		mLastCheck = sdk_time;
+
+		mErrorChecks = signals.errors > 0 ? mErrorChecks + 1 : 0;
+
+		// Only counts as stalled once samples came in at all, so a session that's
+		// quiet from the start (nothing to track) isn't recreated over and over
+		if (signals.sampleTime > mLastSample)
+		{
+			mArmed = mLastSample > 0.0;
+			mLastSample = signals.sampleTime;
+			mLastAdvance = sdk_time;
+		}
+		else if (mLastAdvance < 0.0)
+			mLastAdvance = sdk_time;
+
+		const Cause cause =
+			signals.shouldRecreate
+				? Loss_Recreate
+				: signals.displayLost
+				? Loss_DisplayLost
+				: mErrorChecks >= settings.errorChecks
+				? Loss_Errors
+				: mArmed && sdk_time - mLastAdvance >= settings.stallSeconds
+				? Loss_Stalled
+				: Loss_None;
+
+		if (cause == Loss_None) return;
+
+		std::lock_guard lock(mMutex);
+		mStats.losses++;
+		mStats.lastCause = cause;
+		mLostAt = clock::now();
+		mGeneration++;
+		mHealth.store(Session_Lost, std::memory_order_release);
+	}
+
+	// Host thread, once everything that calls into the session has stopped
+	// 'recreate' runs on 'worker' until it returns true, nothing else may use the session meanwhile
+	void recover(CommandWorker& worker, std::function<bool()> recreate)
+	{
+		uint64_t generation;
+		{
+			std::lock_guard lock(mMutex);
+			if (mHealth != Session_Lost) return;
+			mHealth.store(Session_Recovering, std::memory_order_release);
+			generation = mGeneration;
+		}
+
+		worker.post([this, &worker, recreate = std::move(recreate), generation]
+		{
+			attempt(worker, recreate, generation, std::chrono::milliseconds(0));
+		});
+	}
+
+private:
+	using clock = std::chrono::steady_clock;
+
+	void attempt(CommandWorker& worker, const std::function<bool()>& recreate,
+	             const uint64_t generation, const std::chrono::milliseconds delay)
+	{
+		if (this->generation() != generation) return; // Reset meanwhile
+
+		const bool recreated = recreate();
+
+		std::lock_guard lock(mMutex);
+		if (mGeneration != generation) return;
+		mStats.attempts++;
+
+		if (!recreated)
+		{
+			// Doubling from the first delay, never past the cap
+			const auto next = std::min<std::chrono::milliseconds>(
+				delay.count() == 0 ? settings.retryDelay : delay * 2, settings.maxRetryDelay);
+
+			worker.schedule(next, [this, &worker, recreate, generation, next]
+			{
+				attempt(worker, recreate, generation, next);
+			});
+			return;
+		}
+
+		const double took = std::chrono::duration<double, std::milli>(clock::now() - mLostAt).count();
+		mStats.lastMilliseconds = took;
+		mStats.worstMilliseconds = std::max<double>(mStats.worstMilliseconds, took);
+		mRecoveries++;
+		mStats.meanMilliseconds += (took - mStats.meanMilliseconds) / static_cast<double>(mRecoveries);
+
+		rearm();
+		mHealth.store(Session_Healthy, std::memory_order_release);
+	}
+
+	// A new session starts out knowing nothing, stall detection waits for samples again
+	void rearm()
+	{
+		mLastCheck = -1e9;
+		mLastSample = 0.0;
+		mLastAdvance = -1.0;
+		mArmed = false;
+		mErrorChecks = 0;
+	}
+
+	std::atomic<Health> mHealth{Session_Healthy};
+
+	mutable std::mutex mMutex;
+	uint64_t mGeneration = 0;
+	uint64_t mRecoveries = 0;
+	clock::time_point mLostAt;
+	Stats mStats;
+
+	// Sampling thread only, (re)set while it's stopped
+	double mLastCheck = -1e9;
+	double mLastSample = 0.0;
+	double mLastAdvance = -1.0; // SDK time the sample time last moved
+	bool mArmed = false;
+	uint32_t mErrorChecks = 0;
+};
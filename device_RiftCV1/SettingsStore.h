@@ -0,0 +1,317 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+#include <cereal/archives/binary.hpp>
+#include <cereal/archives/xml.hpp>
+
+// For a settings serialize(): every field on its own when reading XML, so a file from an
+// older (or newer) build still loads whatever it has; missing fields keep their defaults
+template <class Archive, class... Fields>
+void settings_fields(Archive& archive, Fields&&... fields)
+{
+	if constexpr (std::is_same_v<Archive, cereal::XMLInputArchive>)
+	{
+		const auto optional = [&archive](auto&& field)
+		{
+			// Thrown before the archive moves on, the next field reads fine
+			try { archive(field); }
+			catch (const cereal::Exception&) {}
+		};
+		(optional(std::forward<Fields>(fields)), ...);
+	}
+	else
+		archive(std::forward<Fields>(fields)...);
+}
+
+// Settings persistence without file I/O on the caller's thread
+// store() only keeps the latest values, a background thread writes them out once
+// they've stopped changing for a moment (write to .tmp, then rename over the old file)
+// The XML stays the file people edit by hand, the binary cache next to it only
+// exists so startup doesn't have to parse XML, and is ignored once the XML changes
+// (or once T does, see schema())
+template <class T> // Anything with a cereal serialize() member
+class SettingsStore
+{
+public:
+	enum LoadResult
+	{
+		Load_Missing, // No XML yet, defaults stay
+		Load_Failed, // XML is there but broken, whatever was read before that is in 'settings'
+		Load_Cache,
+		Load_Xml
+	};
+
+	SettingsStore(std::filesystem::path xml_path, std::filesystem::path cache_path,
+	              const std::chrono::milliseconds debounce = std::chrono::milliseconds(500)) :
+		mXmlPath(std::move(xml_path)), mCachePath(std::move(cache_path)), mDebounce(debounce)
+	{
+	}
+
+	~SettingsStore()
+	{
+		{
+			std::lock_guard lock(mMutex);
+			mStop = true;
+		}
+		mWake.notify_one();
+
+		if (mThread.joinable())
+			mThread.join();
+		flush();
+	}
+
+	// Called from the background thread when writing fails
+	std::function<void(std::wstring)> on_error;
+
+	LoadResult load(T& settings)
+	{
+		std::error_code error;
+		if (!std::filesystem::exists(mXmlPath, error))
+			return Load_Missing;
+
+		if (read_cache(settings))
+			return Load_Cache;
+
+		try
+		{
+			std::ifstream input(mXmlPath);
+			cereal::XMLInputArchive archive(input);
+			settings.serialize(archive);
+		}
+		catch (...)
+		{
+			return Load_Failed;
+		}
+
+		// Refresh the cache, the XML's just been read and stays exactly as it is
+		{
+			std::lock_guard lock(mWriteMutex);
+			write_cache(settings);
+		}
+		return Load_Xml;
+	}
+
+	// Latest values win, nothing touches the disk here
+	void store(const T& settings)
+	{
+		{
+			std::lock_guard lock(mMutex);
+			mPending = settings;
+			mChangedAt = std::chrono::steady_clock::now();
+
+			if (!mThread.joinable())
+				mThread = std::thread([this] { write_loop(); });
+		}
+		mWake.notify_one();
+	}
+
+	// Writes whatever's pending right now, on the calling thread
+	void flush()
+	{
+		std::optional<T> pending;
+		{
+			std::lock_guard lock(mMutex);
+			pending.swap(mPending);
+		}
+		if (pending)
+			write(*pending);
+	}
+
+	[[nodiscard]] uint64_t writes() const { return mWrites.load(std::memory_order_relaxed); }
+
+private:
+	// Binary cache layout: [CacheHeader][cereal binary archive]
+	struct CacheHeader
+	{
+		char magic[8] = {'C', 'V', '1', 'S', 'E', 'T', 'T', 'S'};
+		uint32_t version = 2;
+		uint32_t reserved = 0;
+		uint64_t xmlSize = 0; // The XML it was written with, to tell if it's been edited since
+		long long xmlWriteTime = 0;
+		uint64_t schema = SettingsStore::schema(); // The T it was written from
+	};
+
+	// Changes whenever T's fields do (names, order, defaults): the binary archive has no
+	// names, a cache from another build must never be read into this one's layout
+	static uint64_t schema()
+	{
+		static const uint64_t hash = []
+		{
+			std::ostringstream output;
+			{
+				cereal::XMLOutputArchive archive(output);
+				T defaults{};
+				defaults.serialize(archive);
+			}
+
+			uint64_t fnv = 14695981039346656037ull; // FNV-1a
+			for (const char c : output.str())
+			{
+				fnv ^= static_cast<uint8_t>(c);
+				fnv *= 1099511628211ull;
+			}
+			return fnv;
+		}();
+		return hash;
+	}
+
+	bool xml_stamp(uint64_t& size, long long& write_time) const
+	{
+		std::error_code error;
+		size = std::filesystem::file_size(mXmlPath, error);
+		if (error) return false;
+
+		write_time = std::filesystem::last_write_time(mXmlPath, error).time_since_epoch().count();
+		return !error;
+	}
+
+	bool read_cache(T& settings) const
+	{
+		uint64_t size;
+		long long write_time;
+		if (!xml_stamp(size, write_time)) return false;
+
+		std::ifstream input(mCachePath, std::ios::binary);
+		CacheHeader header;
+		if (!input.read(reinterpret_cast<char*>(&header), sizeof(header)))
+			return false;
+
+		if (const CacheHeader expected; std::memcmp(header.magic, expected.magic, sizeof(expected.magic)) != 0 ||
+			header.version != expected.version || header.schema != expected.schema ||
+			header.xmlSize != size || header.xmlWriteTime != write_time)
+			return false;
+
+		try
+		{
+			T cached = settings;
+			cereal::BinaryInputArchive archive(input);
+			cached.serialize(archive);
+			settings = cached;
+			return true;
+		}
+		catch (...)
+		{
+			return false;
+		}
+	}
+
+	void write_loop()
+	{
+		std::unique_lock lock(mMutex);
+		while (!mStop)
+		{
+			if (!mPending)
+			{
+				mWake.wait(lock, [this] { return mStop || mPending.has_value(); });
+				continue;
+			}
+
+			// Wait until nothing has changed for a whole debounce window
+			if (const auto due = mChangedAt + mDebounce; std::chrono::steady_clock::now() < due)
+			{
+				mWake.wait_until(lock, due);
+				continue;
+			}
+
+			T settings = std::move(*mPending);
+			mPending.reset();
+
+			lock.unlock();
+			write(settings);
+			lock.lock();
+		}
+	}
+
+	// Fields go straight under the root (settings.serialize, not archive(settings)),
+	// that's the layout the XML always had
+	void write(T settings)
+	{
+		std::lock_guard lock(mWriteMutex); // The writer thread vs. flush() and load()
+
+		if (!replace_file(mXmlPath, [&settings](std::ofstream& output)
+		{
+			cereal::XMLOutputArchive archive(output);
+			settings.serialize(archive);
+		}))
+		{
+			if (on_error) on_error(L"CV1 Device Error: Couldn't save settings!\n");
+			return;
+		}
+
+		write_cache(settings);
+		mWrites.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// For the XML as it is on disk right now, mWriteMutex held
+	// A stale or missing cache is harmless, it just gets ignored on the next load
+	void write_cache(T& settings)
+	{
+		CacheHeader header;
+		if (!xml_stamp(header.xmlSize, header.xmlWriteTime)) return;
+
+		replace_file(mCachePath, [&settings, &header](std::ofstream& output)
+		{
+			output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+			cereal::BinaryOutputArchive archive(output);
+			settings.serialize(archive);
+		}, true);
+	}
+
+	// Writes next to the target, then swaps it in, so a crash never leaves half a file
+	template <class Writer>
+	static bool replace_file(const std::filesystem::path& path, Writer&& writer, const bool binary = false)
+	{
+		std::filesystem::path temp = path;
+		temp += L".tmp";
+
+		try
+		{
+			std::ofstream output(temp, binary ? std::ios::binary : std::ios::out);
+			if (output.fail()) return false;
+
+			// Archives only finish writing when they go out of scope, i.e. by the time writer() returns
+			// Closing is what writes the rest out: a full disk only shows up there
+			writer(output);
+			output.close();
+			if (!output.fail())
+			{
+				std::filesystem::rename(temp, path); // Replaces the old file
+				return true;
+			}
+		}
+		catch (...)
+		{
+		}
+
+		std::error_code error;
+		std::filesystem::remove(temp, error);
+		return false;
+	}
+
+	std::filesystem::path mXmlPath;
+	std::filesystem::path mCachePath;
+	std::chrono::milliseconds mDebounce;
+
+	std::mutex mMutex;
+	std::mutex mWriteMutex;
+	std::condition_variable mWake;
+	std::optional<T> mPending;
+	std::chrono::steady_clock::time_point mChangedAt;
+	bool mStop = false;
+	std::thread mThread;
+
+	std::atomic<uint64_t> mWrites{0};
+};
@@ -0,0 +1,246 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Shared pose export: the plugin publishes every applied frame into a named shared memory
+// region, any number of local tools read it without ever blocking the plugin
+// Only needs this header, no LibOVR/Amethyst/Eigen; see SharedPoseReader at the bottom
+//
+// Protocol (seqlock): 'generation' is odd while the plugin writes, readers copy what they
+// need and retry unless they saw the same even value before and after copying
+// The layout only ever grows at the end, anything else bumps shared_poses_version
+
+constexpr const char* shared_poses_name = "AmethystCV1Poses"; // Local\ (Windows) or / (POSIX) is added
+constexpr uint32_t shared_poses_version = 1;
+constexpr uint32_t shared_poses_max = 2 + 64; // Touch controllers + VR Objects
+
+struct SharedPose
+{
+	float position[3]; // m, tracking space (floor level)
+	float orientation[4]; // x, y, z, w
+	float linearVelocity[3];
+	float linearAcceleration[3];
+	float angularVelocity[3];
+	float angularAcceleration[3];
+
+	uint32_t device; // 0: left Touch, 1: right Touch, 2 + n: VR Object slot n
+	double sampleTime; // s, SDK clock
+	uint32_t statusFlags; // 0x1: orientation tracked, 0x2: position tracked
+	uint32_t reserved;
+	long long hostTime; // us, same clock as SharedPosesHeader::publishedAt, 0 = unknown
+};
+
+static_assert(sizeof(SharedPose) == 104 && offsetof(SharedPose, hostTime) == 96);
+
+struct SharedPosesHeader
+{
+	char magic[8] = {'C', 'V', '1', 'P', 'O', 'S', 'E', 'S'};
+	uint32_t version = shared_poses_version;
+	uint32_t headerSize = sizeof(SharedPosesHeader);
+	uint32_t poseSize = sizeof(SharedPose);
+	uint32_t maxPoses = shared_poses_max;
+
+	uint64_t generation = 0; // Odd: being written
+	uint64_t frames = 0; // Published so far
+	long long publishedAt = 0; // us, AME_API_GET_TIMESTAMP_NOW
+	double frameTime = 0.0; // s, SDK clock the poses were requested for
+	uint64_t objectMask = 0; // VR Object slots present
+	uint32_t poseCount = 0;
+	uint32_t writerProcess = 0; // Changes when the plugin was restarted
+};
+
+static_assert(sizeof(SharedPosesHeader) == 72);
+
+constexpr size_t shared_poses_size = sizeof(SharedPosesHeader) + sizeof(SharedPose) * shared_poses_max;
+
+// Named shared memory: the writer creates it, readers map it read-only
+class SharedMemory
+{
+public:
+	SharedMemory() = default;
+	SharedMemory(const SharedMemory&) = delete;
+	SharedMemory& operator=(const SharedMemory&) = delete;
+
+	~SharedMemory() { close(); }
+
+	// size: writer only, readers map whatever's there
+	bool open(const char* name, const size_t size, const bool writable)
+	{
+		close();
+		mWritable = writable;
+
+#ifdef _WIN32
+		char path[128];
+		std::snprintf(path, sizeof(path), "Local\\%s", name);
+
+		mMapping = writable
+			           ? CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+			                                0, static_cast<DWORD>(size), path)
+			           : OpenFileMappingA(FILE_MAP_READ, FALSE, path);
+		if (!mMapping) return false;
+
+		mData = static_cast<uint8_t*>(MapViewOfFile(
+			mMapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, writable ? size : 0));
+
+		MEMORY_BASIC_INFORMATION info{};
+		if (mData && VirtualQuery(mData, &info, sizeof(info)))
+			mSize = writable ? size : info.RegionSize;
+#else
+		std::snprintf(mName, sizeof(mName), "/%s", name);
+
+		const int file = shm_open(mName, writable ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+		if (file < 0) return false;
+
+		struct stat info{};
+		if (writable ? ftruncate(file, static_cast<off_t>(size)) == 0 : fstat(file, &info) == 0)
+		{
+			mSize = writable ? size : static_cast<size_t>(info.st_size);
+			void* data = mSize > 0
+				             ? mmap(nullptr, mSize, writable ? PROT_READ | PROT_WRITE : PROT_READ,
+				                    MAP_SHARED, file, 0)
+				             : MAP_FAILED;
+			mData = data == MAP_FAILED ? nullptr : static_cast<uint8_t*>(data);
+		}
+		::close(file); // The mapping keeps it alive
+#endif
+
+		if (!mData)
+		{
+			close();
+			return false;
+		}
+		return true;
+	}
+
+	void close()
+	{
+#ifdef _WIN32
+		if (mData) UnmapViewOfFile(mData);
+		if (mMapping) CloseHandle(mMapping);
+		mMapping = nullptr;
+#else
+		if (mData) munmap(mData, mSize);
+
+		// The writer takes the name with it, readers keep their mapping until they close
+		if (mData && mWritable) shm_unlink(mName);
+#endif
+		mData = nullptr;
+		mSize = 0;
+	}
+
+	[[nodiscard]] bool is_open() const { return mData != nullptr; }
+	[[nodiscard]] uint8_t* data() const { return mData; }
+	[[nodiscard]] size_t size() const { return mSize; }
+
+private:
+#ifdef _WIN32
+	HANDLE mMapping = nullptr;
+#else
+	char mName[128] = {};
+#endif
+
+	bool mWritable = false;
+	uint8_t* mData = nullptr;
+	size_t mSize = 0;
+};
+
+// Everything one read() copies out
+struct SharedPoseSnapshot
+{
+	uint64_t generation = 0;
+	uint64_t frames = 0;
+	long long publishedAt = 0;
+	double frameTime = 0.0;
+	uint64_t objectMask = 0;
+	uint32_t poseCount = 0;
+	uint32_t writerProcess = 0;
+	SharedPose poses[shared_poses_max] = {};
+};
+
+// The reader library: open() once, then read() as often as you like
+// Lock-free, the plugin never waits on readers and readers never wait on each other
+class SharedPoseReader
+{
+public:
+	enum ReadResult
+	{
+		Read_Ok,
+		Read_Unchanged, // Nothing new since the snapshot's generation
+		Read_Busy, // The plugin kept writing through every retry, try again later
+		Read_Closed // Not open, or the layout isn't one we know
+	};
+
+	// False while the plugin isn't running (or its layout is newer than ours)
+	bool open(const char* name = shared_poses_name)
+	{
+		if (!mMemory.open(name, 0, false)) return false;
+
+		const SharedPosesHeader& header = *reinterpret_cast<const SharedPosesHeader*>(mMemory.data());
+		if (mMemory.size() < shared_poses_size ||
+			std::memcmp(header.magic, SharedPosesHeader{}.magic, sizeof(header.magic)) != 0 ||
+			header.version != shared_poses_version || header.headerSize != sizeof(SharedPosesHeader) ||
+			header.poseSize != sizeof(SharedPose) || header.maxPoses != shared_poses_max)
+		{
+			mMemory.close();
+			return false;
+		}
+		return true;
+	}
+
+	void close() { mMemory.close(); }
+	[[nodiscard]] bool is_open() const { return mMemory.is_open(); }
+
+	// Latest frame into 'out', unless it already holds it (same generation)
+	ReadResult read(SharedPoseSnapshot& out, const int retries = 64) const
+	{
+		if (!is_open()) return Read_Closed;
+
+		SharedPosesHeader& header = *reinterpret_cast<SharedPosesHeader*>(mMemory.data());
+		const SharedPose* poses = reinterpret_cast<const SharedPose*>(mMemory.data() + sizeof(SharedPosesHeader));
+		std::atomic_ref<uint64_t> generation(header.generation);
+
+		for (int attempt = 0; attempt <= retries; attempt++)
+		{
+			const uint64_t before = generation.load(std::memory_order_acquire);
+			if (before & 1)
+			{
+				std::this_thread::yield(); // Mid-write, let the plugin finish
+				continue;
+			}
+			if (before == out.generation && before != 0) return Read_Unchanged;
+
+			const uint32_t count = std::min<uint32_t>(header.poseCount, shared_poses_max);
+			out.frames = header.frames;
+			out.publishedAt = header.publishedAt;
+			out.frameTime = header.frameTime;
+			out.objectMask = header.objectMask;
+			out.writerProcess = header.writerProcess;
+			std::memcpy(out.poses, poses, sizeof(SharedPose) * count);
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (generation.load(std::memory_order_relaxed) != before) continue; // Torn, again
+
+			out.poseCount = count;
+			out.generation = before;
+			return Read_Ok;
+		}
+		return Read_Busy;
+	}
+
+private:
+	SharedMemory mMemory;
+};
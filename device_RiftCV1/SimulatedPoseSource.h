@@ -0,0 +1,284 @@
+#pragma once
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+#include <utility>
+#include <algorithm>
+
+#include "PoseSource.h"
+
+// What the simulated headset does, all of it deterministic for a given seed
+struct SimulationSettings
+{
+	uint32_t objects = 4; // VR Objects, besides the two Touch controllers
+	double sensorRate = 1000.0; // Hz, sample times snap to this like real IMU samples
+
+	double orbitRadius = 0.15; // m
+	double orbitSpeed = 1.5; // rad/s
+	double spinSpeed = 0.8; // rad/s, around a fixed axis per device
+	double shakeAmplitude = 0.002; // m, per-sample jitter on top of the orbit
+
+	double dropoutEvery = 8.0; // s between tracking losses per device, 0 = never
+	double dropoutLength = 0.4; // s
+
+	double spikeEvery = 0.0; // s between stalled SDK calls, 0 = never
+	double spikeLength = 0.005; // s
+
+	// Lost sessions, each one a different way: stalled sample times, ShouldRecreate,
+	// DisplayLost, failing calls, then round again
+	double sessionLossEvery = 0.0; // s between lost sessions, 0 = never
+	uint32_t recreateFailures = 0; // Recreate attempts that fail before one goes through
+	double recreateSeconds = 0.0; // How long every recreate attempt takes
+
+	uint64_t seed = 1;
+};
+
+// Stand-in for LibOVR with procedural motion: every device orbits its own spot in
+// a tilted plane while spinning, shakes a little, drops out now and then, and the
+// 'SDK' stalls (or loses its session) every so often. Runs anywhere, so the whole pipeline can be loaded
+// without an Oculus runtime
+class SimulatedPoseSource : public IPoseSource
+{
+public:
+	enum SessionFault
+	{
+		Fault_None,
+		Fault_Stall,
+		Fault_Recreate,
+		Fault_DisplayLost,
+		Fault_Errors,
+		Fault_Count
+	};
+
+	explicit SimulatedPoseSource(const SimulationSettings& settings = {}) :
+		mSettings(settings), mObjects(first_object_slots(settings.objects)),
+		mFailuresLeft(settings.recreateFailures)
+	{
+	}
+
+	void set_settings(const SimulationSettings& settings)
+	{
+		mSettings = settings;
+		mObjects = first_object_slots(settings.objects);
+		mFault = Fault_None;
+		mNextFault = Fault_Stall;
+		mNextLoss = 0.0;
+		mFailuresLeft = settings.recreateFailures;
+	}
+
+	// Plugging VR Objects in and out while running, any of the 64 slots
+	void connect(const uint32_t slot) { mObjects |= 1ull << slot; }
+	void disconnect(const uint32_t slot) { mObjects &= ~(1ull << slot); }
+
+	[[nodiscard]] const SimulationSettings& settings() const { return mSettings; }
+
+	// Seconds per time_seconds() call, for runs that have to come out the same every time
+	// 0 = follow the real clock
+	void set_fixed_step(const double step)
+	{
+		mFixedStep = step;
+		mFixedTime = 0.0;
+	}
+
+	double time_seconds() override
+	{
+		mCalls++;
+
+		const double now = mFixedStep > 0.0
+			                   ? mFixedTime += mFixedStep
+			                   : std::chrono::duration<double>(
+				                   std::chrono::steady_clock::now().time_since_epoch()).count();
+
+		// Timing spike: the call that crosses the next spike time stalls
+		if (mSettings.spikeEvery > 0.0)
+		{
+			if (now >= mNextSpike)
+			{
+				if (mNextSpike > 0.0)
+					std::this_thread::sleep_for(std::chrono::duration<double>(mSettings.spikeLength));
+				mNextSpike = now + mSettings.spikeEvery;
+			}
+		}
+
+		// Session loss: from here on nothing moves until it's recreated
+		if (mSettings.sessionLossEvery > 0.0 && mFault == Fault_None)
+		{
+			if (mNextLoss == 0.0)
+				mNextLoss = now + mSettings.sessionLossEvery;
+			else if (now >= mNextLoss)
+			{
+				mFault = mNextFault;
+				mFaultTime = now;
+				mNextFault = static_cast<SessionFault>(mNextFault % (Fault_Count - 1) + 1);
+			}
+		}
+
+		mNow = now;
+		return now;
+	}
+
+	void hand_poses(const double time, JointSample hands[2]) override
+	{
+		mCalls++;
+		for (uint32_t i = 0; i < 2; i++)
+			synthesize(i, time, hands[i]);
+	}
+
+	uint64_t connected_objects() override { return mObjects.load(std::memory_order_relaxed); }
+
+	bool object_poses(const double time, uint64_t slots, JointSample* objects) override
+	{
+		mCalls++;
+		for (; slots; slots &= slots - 1)
+			synthesize(2 + std::countr_zero(slots), time, *objects++);
+		return mFault != Fault_Errors;
+	}
+
+	SessionSignals session_signals() override
+	{
+		SessionSignals signals;
+		signals.shouldRecreate = mFault == Fault_Recreate;
+		signals.displayLost = mFault == Fault_DisplayLost;
+		signals.errors = std::exchange(mErrors, 0);
+		return signals;
+	}
+
+	bool recreate_session() override
+	{
+		if (mSettings.recreateSeconds > 0.0)
+			std::this_thread::sleep_for(std::chrono::duration<double>(mSettings.recreateSeconds));
+
+		if (mFailuresLeft > 0)
+		{
+			mFailuresLeft--;
+			return false;
+		}
+
+		mFault = Fault_None;
+		mFailuresLeft = mSettings.recreateFailures;
+		mNextLoss = 0.0; // Counts from the next call on
+		return true;
+	}
+
+	[[nodiscard]] uint64_t calls() const { return mCalls; }
+
+	// The session that's lost right now and since when (time_seconds() clock), Fault_None if it's fine
+	[[nodiscard]] SessionFault fault() const { return mFault; }
+	[[nodiscard]] double fault_time() const { return mFaultTime; }
+
+private:
+	// Same input, same output: splitmix64 to [-1, 1]
+	[[nodiscard]] double noise(const uint64_t device, const uint64_t sample, const uint64_t channel) const
+	{
+		uint64_t x = mSettings.seed ^ (device << 40) ^ (channel << 56) ^ sample;
+		x += 0x9E3779B97F4A7C15ull;
+		x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+		x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+		x ^= x >> 31;
+		return static_cast<double>(x >> 11) * (2.0 / 9007199254740992.0) - 1.0;
+	}
+
+	void synthesize(const uint32_t device, double time, JointSample& sample)
+	{
+		// A dead session hands out the last poses it had, untracked
+		if (mFault != Fault_None)
+		{
+			time = mFaultTime;
+			if (mFault == Fault_Errors) mErrors++;
+		}
+
+		const double rate = std::max(mSettings.sensorRate, 1.0);
+
+		// Latest sensor sample at or before the requested time, and never one past the last
+		// clock reading: later times are predicted from what's there, like the SDK does
+		const double sampled = mNow > 0.0 ? std::min(time, mNow) : time;
+		auto sample_index = static_cast<int64_t>(std::floor(sampled * rate));
+		double sample_time = static_cast<double>(sample_index) / rate;
+
+		// Dropouts: tracking is lost and the pose freezes where it was
+		bool tracked = true;
+		if (mSettings.dropoutEvery > 0.0)
+		{
+			const double offset = device * 1.37 + noise(device, 0, 7) * mSettings.dropoutEvery;
+			const double into = std::fmod(sample_time + std::abs(offset), mSettings.dropoutEvery);
+			if (into < mSettings.dropoutLength)
+			{
+				tracked = false;
+				sample_time -= into;
+				sample_index = static_cast<int64_t>(std::floor(sample_time * rate));
+			}
+		}
+
+		// Orbit in a plane tilted differently for every device
+		const double tilt = 0.3 + device * 0.4;
+		const double phase = sample_time * mSettings.orbitSpeed + device * 0.9;
+		const double radius = mSettings.orbitRadius;
+
+		const double center[3] = {
+			device < 2 ? (device == 0 ? -0.2 : 0.2) : (device - 2) % 8 * 0.3 - 1.05,
+			device < 2 ? 1.0 : 0.5 + (device - 2) / 8 * 0.2,
+			-0.5
+		};
+
+		const double c = std::cos(phase), s = std::sin(phase);
+		const double offset[3] = {radius * c, radius * s * std::cos(tilt), radius * s * std::sin(tilt)};
+		const double velocity[3] = {
+			-radius * mSettings.orbitSpeed * s,
+			radius * mSettings.orbitSpeed * c * std::cos(tilt),
+			radius * mSettings.orbitSpeed * c * std::sin(tilt)
+		};
+
+		for (int i = 0; i < 3; i++)
+		{
+			const double shake = mSettings.shakeAmplitude * noise(device, sample_index, i);
+			sample.position[i] = static_cast<float>(center[i] + offset[i] + shake);
+			sample.linearVelocity[i] = tracked ? static_cast<float>(velocity[i]) : 0.f;
+			sample.linearAcceleration[i] = tracked
+				                               ? static_cast<float>(-offset[i] * mSettings.orbitSpeed *
+					                               mSettings.orbitSpeed)
+				                               : 0.f;
+			sample.angularAcceleration[i] = 0.f;
+		}
+
+		// Spin around a fixed, normalized axis
+		double axis[3] = {std::sin(device * 0.7), 1.0, std::cos(device * 1.3)};
+		const double length = std::sqrt(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+		for (double& a : axis) a /= length;
+
+		// Like the SDK: predicted for the requested time, from the sample
+		const double ahead = tracked ? std::max(time - sample_time, 0.0) : 0.0;
+		const double half_angle = (sample_time + ahead) * mSettings.spinSpeed * 0.5 + device * 0.25;
+
+		for (int i = 0; i < 3; i++)
+		{
+			sample.orientation[i] = static_cast<float>(axis[i] * std::sin(half_angle));
+			sample.angularVelocity[i] = tracked ? static_cast<float>(axis[i] * mSettings.spinSpeed) : 0.f;
+			sample.position[i] += static_cast<float>(velocity[i] * ahead);
+		}
+		sample.orientation[3] = static_cast<float>(std::cos(half_angle));
+
+		sample.sampleTime = sample_time;
+		sample.statusFlags = tracked && mFault == Fault_None ? status_orientation_tracked | status_position_tracked : 0;
+	}
+
+	SimulationSettings mSettings;
+	std::atomic<uint64_t> mObjects{0}; // Connected slots, scanned from another thread
+
+	double mFixedStep = 0.0;
+	double mFixedTime = 0.0;
+	double mNow = 0.0; // Last time_seconds()
+	double mNextSpike = 0.0;
+
+	// Only ever touched by one thread at a time: sampling stops while the session's recreated
+	SessionFault mFault = Fault_None;
+	SessionFault mNextFault = Fault_Stall;
+	double mFaultTime = 0.0;
+	double mNextLoss = 0.0; // 0 = start counting at the next call
+	uint32_t mFailuresLeft = 0;
+	uint32_t mErrors = 0;
+
+	uint64_t mCalls = 0;
+};
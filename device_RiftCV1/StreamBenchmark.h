@@ -0,0 +1,118 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BenchmarkSetup.h"
+#include "PoseStream.h"
+
+// Pose stream encoding, then the same frames over localhost
+struct StreamBenchmarkResult
+{
+	uint32_t joints = 0;
+	uint32_t frames = 0;
+
+	double bytesPerFrame = 0.0;
+	double rawBytesPerFrame = 0.0; // JointSample per joint
+	double encodeNs = 0.0;
+	double decodeNs = 0.0;
+
+	uint32_t loopbackSent = 0;
+	uint32_t loopbackReceived = 0;
+};
+
+// Encode/decode for 2..66 joints over a set of recorded frames, then 'loopback' frames
+// each through a real socket on 'port' (localhost)
+inline std::vector<StreamBenchmarkResult> benchmark_stream(const BenchmarkSetup& setup, const uint32_t loopback = 2000,
+                                                           const uint16_t port = pose_stream_port + 1)
+{
+	using clock = std::chrono::steady_clock;
+	std::vector<StreamBenchmarkResult> results;
+
+	for (const uint32_t joints : {2u, 8u, 32u, max_frame_joints})
+	{
+		const std::unique_ptr<IPoseSource> source = setup.make_source(joints - 2);
+
+		std::vector<JointFrame> recorded(256);
+		for (JointFrame& frame : recorded)
+		{
+			acquire_frame(*source, frame, setup.prediction, first_object_slots(joints - 2));
+			std::this_thread::sleep_for(std::chrono::microseconds(500)); // Let the poses move
+		}
+
+		StreamBenchmarkResult& result = results.emplace_back();
+		result.joints = joints;
+		result.frames = setup.frames;
+		result.rawBytesPerFrame = static_cast<double>(sizeof(JointSample) * joints);
+
+		// Encode everything up front, then decode it all, in order like it'd arrive
+		PoseEncoder encoder;
+		PoseDecoder decoder;
+		std::vector<uint8_t> encoded(pose_codec::max_bytes * recorded.size());
+		std::vector<size_t> sizes(recorded.size());
+		JointFrame decoded;
+		long long timestamp = 0;
+
+		clock::duration encoding{}, decoding{};
+		uint64_t bytes = 0;
+		for (uint32_t done = 0; done < setup.frames; done += static_cast<uint32_t>(recorded.size()))
+		{
+			const auto start = clock::now();
+			for (size_t i = 0; i < recorded.size(); i++)
+				sizes[i] = encoder.encode(recorded[i], 0, &encoded[i * pose_codec::max_bytes],
+				                          pose_codec::max_bytes);
+			const auto encoded_all = clock::now();
+			for (size_t i = 0; i < recorded.size(); i++)
+				decoder.decode(&encoded[i * pose_codec::max_bytes], sizes[i], decoded, timestamp);
+
+			encoding += encoded_all - start;
+			decoding += clock::now() - encoded_all;
+			for (const size_t size : sizes) bytes += size;
+		}
+
+		const auto rounds = static_cast<double>((setup.frames + recorded.size() - 1) / recorded.size() * recorded.size());
+		result.encodeNs = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(encoding).count()) / rounds;
+		result.decodeNs = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(decoding).count()) / rounds;
+		result.bytesPerFrame = static_cast<double>(bytes) / rounds;
+
+		// Same frames through the network stack, paced so the receiver keeps up
+		PoseStreamReceiver receiver;
+		PoseStreamSender sender;
+		if (!receiver.open(port) || !sender.open("127.0.0.1", port)) continue;
+
+		std::thread receiving([&]
+		{
+			JointFrame frame;
+			long long sent_at = 0;
+			while (receiver.stats().frames < loopback && receiver.receive(frame, sent_at, 200))
+			{
+			}
+		});
+
+		for (uint32_t i = 0; i < loopback; i++)
+		{
+			sender.send(recorded[i % recorded.size()], i);
+			if (i % 16 == 15) std::this_thread::sleep_for(std::chrono::microseconds(200));
+		}
+		receiving.join();
+
+		result.loopbackSent = static_cast<uint32_t>(sender.sent());
+		result.loopbackReceived = static_cast<uint32_t>(receiver.stats().frames);
+	}
+	return results;
+}
+
+inline std::string to_json(const StreamBenchmarkResult& result)
+{
+	char json[384];
+	std::snprintf(json, sizeof(json),
+	              "{\"joints\": %u, \"frames\": %u, \"bytes_per_frame\": %.1f, \"raw_bytes_per_frame\": %.0f, "
+	              "\"encode_ns\": %.1f, \"decode_ns\": %.1f, \"loopback_sent\": %u, \"loopback_received\": %u}",
+	              result.joints, result.frames, result.bytesPerFrame, result.rawBytesPerFrame,
+	              result.encodeNs, result.decodeNs, result.loopbackSent, result.loopbackReceived);
+	return json;
+}
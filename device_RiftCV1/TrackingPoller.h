@@ -0,0 +1,201 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <timeapi.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
+#include "JointFrame.h"
+
+// Wait-free single producer / single consumer triple buffer
+// The writer always owns one slot, the reader owns another
+// and the third one is swapped between them with a single atomic exchange,
+// so neither side ever blocks or sees a half-written value
+template <typename T>
+class TripleBuffer
+{
+public:
+	// Producer: slot to fill in, then publish()
+	T& write_buffer() { return mBuffers[mWriteIndex]; }
+
+	void publish()
+	{
+		const uint8_t previous = mMiddle.exchange(
+			mWriteIndex | dirty_bit, std::memory_order_acq_rel);
+		mWriteIndex = previous & index_mask;
+	}
+
+	// Consumer: returns true if a newer value has been picked up
+	bool fetch()
+	{
+		if (!(mMiddle.load(std::memory_order_relaxed) & dirty_bit))
+			return false;
+
+		const uint8_t previous = mMiddle.exchange(
+			mReadIndex, std::memory_order_acq_rel);
+		mReadIndex = previous & index_mask;
+		return true;
+	}
+
+	const T& read_buffer() const { return mBuffers[mReadIndex]; }
+
+private:
+	static constexpr uint8_t index_mask = 0x3;
+	static constexpr uint8_t dirty_bit = 0x4;
+
+	std::array<T, 3> mBuffers{};
+
+	alignas(64) std::atomic<uint8_t> mMiddle{1};
+	alignas(64) uint8_t mWriteIndex = 0;
+	alignas(64) uint8_t mReadIndex = 2;
+};
+
+// Waits for a deadline sleeping, and spins (yields) only for however much the OS sleep
+// might overshoot by. On Windows that's a high resolution waitable timer, or 1 ms
+// timer resolution (timeBeginPeriod) where there isn't one; one waiter per thread
+class PeriodWaiter
+{
+public:
+	using clock = std::chrono::steady_clock;
+
+	PeriodWaiter()
+	{
+#ifdef _WIN32
+		mTimer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+		if (mTimer)
+			mMargin = std::chrono::microseconds(500);
+		else
+		{
+			timeBeginPeriod(1);
+			mMargin = std::chrono::microseconds(1000);
+		}
+#endif
+	}
+
+	PeriodWaiter(const PeriodWaiter&) = delete;
+	PeriodWaiter& operator=(const PeriodWaiter&) = delete;
+
+	~PeriodWaiter()
+	{
+#ifdef _WIN32
+		if (mTimer) CloseHandle(mTimer);
+		else timeEndPeriod(1);
+#endif
+	}
+
+	// How early the sleep stops, the rest is spun
+	[[nodiscard]] clock::duration margin() const { return mMargin; }
+
+	void wait_until(const clock::time_point deadline, const std::atomic<bool>& stop) const
+	{
+		if (const auto remaining = deadline - clock::now(); remaining > mMargin)
+			sleep(remaining - mMargin);
+
+		while (clock::now() < deadline && !stop)
+			std::this_thread::yield();
+	}
+
+private:
+	void sleep(const clock::duration duration) const
+	{
+#ifdef _WIN32
+		if (mTimer)
+		{
+			LARGE_INTEGER due; // Relative, in 100 ns
+			due.QuadPart = -std::chrono::duration_cast<std::chrono::duration<long long, std::ratio<1, 10'000'000>>>(
+				duration).count();
+			if (SetWaitableTimerEx(mTimer, &due, 0, nullptr, nullptr, nullptr, 0))
+			{
+				WaitForSingleObject(mTimer, INFINITE);
+				return;
+			}
+		}
+#endif
+		std::this_thread::sleep_for(duration);
+	}
+
+#ifdef _WIN32
+	HANDLE mTimer = nullptr;
+#endif
+	clock::duration mMargin = std::chrono::microseconds(200); // nanosleep's overshoot, give or take
+};
+
+// Plugin-owned thread sampling the tracking state at a fixed rate
+// and publishing complete frames through the triple buffer above
+class TrackingPoller
+{
+public:
+	using Sampler = std::function<void(JointFrame&)>;
+
+	~TrackingPoller() { stop(); }
+
+	void start(Sampler sampler, const uint32_t rate_hz)
+	{
+		stop();
+
+		mSampler = std::move(sampler);
+		mPeriod = std::chrono::nanoseconds(
+			1'000'000'000 / std::clamp<uint32_t>(rate_hz, 1, 2000));
+		mStop = false;
+
+		mThread = std::thread([this] { poll_loop(); });
+	}
+
+	void stop()
+	{
+		mStop = true;
+		if (mThread.joinable())
+			mThread.join();
+	}
+
+	[[nodiscard]] bool running() const { return mThread.joinable(); }
+
+	// Consumer side, never blocks the poller
+	bool fetch() { return mFrames.fetch(); }
+	[[nodiscard]] const JointFrame& latest() const { return mFrames.read_buffer(); }
+
+	[[nodiscard]] uint64_t frames_published() const { return mPublished.load(std::memory_order_relaxed); }
+
+private:
+	void poll_loop()
+	{
+		using clock = PeriodWaiter::clock;
+		const PeriodWaiter waiter;
+		auto next = clock::now();
+
+		while (!mStop)
+		{
+			JointFrame& frame = mFrames.write_buffer();
+			mSampler(frame);
+			frame.sequence = mPublished.fetch_add(1, std::memory_order_relaxed) + 1;
+			mFrames.publish();
+
+			next += mPeriod;
+			const auto now = clock::now();
+
+			// Don't try to catch up after a stall, just skip ahead
+			if (next < now)
+				next = now;
+
+			// Asleep for all but the last bit of the period, even at 1-2 kHz
+			waiter.wait_until(next, mStop);
+		}
+	}
+
+	Sampler mSampler;
+	std::chrono::nanoseconds mPeriod{2'000'000};
+
+	TripleBuffer<JointFrame> mFrames;
+	std::atomic<uint64_t> mPublished{0};
+
+	std::atomic<bool> mStop{false};
+	std::thread mThread;
+};
@@ -0,0 +1,352 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+
+#include <Eigen/Dense>
+
+#include "JointFrame.h"
+#include "JointLanes.h"
+#include "SampleWindow.h"
+
+// Per-joint tracking quality, for when a puck "feels floaty" and we need numbers
+// Every device (Touch left/right, VR Object slot n) is one lane, so each frame is a
+// gather followed by a handful of vectorized passes over all of them
+// Windows are exponential with a time constant of 'window' seconds of sample time:
+// constant memory, O(1) per sample, nothing allocated after construction
+class TrackingQuality
+{
+public:
+	struct Settings
+	{
+		float window = 2.0f; // s, time constant of the windowed statistics
+
+		// At rest: slower than this, jitter is only measured then
+		float restSpeed = 0.02f; // m/s
+		float restAngularSpeed = 0.1f; // rad/s
+
+		float gapFactor = 4.0f; // A sample this many mean intervals late is a gap
+		float outlierSigma = 6.0f; // Further than this from the windowed mean is an outlier
+		float outlierSamples = 32.0f; // Samples before anything counts as an outlier
+	};
+
+	// One device's numbers, see summary()
+	struct JointQuality
+	{
+		uint64_t samples = 0; // New samples seen
+		bool tracked = false; // Position tracked as of the last frame
+
+		// Windowed, at rest
+		double positionJitter = 0.0; // mm RMS around the resting position
+		double angularJitter = 0.0; // deg RMS around the resting orientation
+
+		uint64_t dropouts = 0; // Times position tracking went away
+		double dropoutSeconds = 0.0; // Total, ongoing one included
+		double longestDropout = 0.0; // s
+
+		double meanInterval = 0.0; // ms between samples, windowed
+		double peakInterval = 0.0; // ms, decays over the window
+		uint64_t gaps = 0; // Intervals past gapFactor x mean
+
+		uint64_t velocityOutliers = 0;
+		uint64_t accelerationOutliers = 0;
+		double outlierRate = 0.0; // Share of samples with either, windowed
+	};
+
+	using Summary = std::array<JointQuality, max_frame_joints>;
+
+	Settings settings;
+
+	TrackingQuality() { reset(); }
+
+	void reset()
+	{
+		std::lock_guard lock(mMutex);
+
+		mPosition.setZero();
+		mPositionMean.setZero();
+		mPositionVariance.setZero();
+		mOrientation.setZero();
+		mOrientationMean.setZero();
+		mOrientationVariance.setZero();
+
+		mSpeed.setZero();
+		mSpeedMean.setZero();
+		mSpeedVariance.setZero();
+		mAcceleration.setZero();
+		mAccelerationMean.setZero();
+		mAccelerationVariance.setZero();
+		mOutlierRate.setZero();
+
+		mLastSample.setZero();
+		mInterval.setZero();
+		mMeanInterval.setZero();
+		mPeakInterval.setZero();
+
+		mPresent.setZero();
+		mPrimed.setZero();
+		mWarm.setZero();
+		mTracked.setZero();
+		mWasTracked.setOnes();
+		mWasResting.setZero();
+
+		mDropoutTime.setZero();
+		mDropoutTotal.setZero();
+		mLongestDropout.setZero();
+
+		mSamples.setZero();
+		mDropouts.setZero();
+		mGaps.setZero();
+		mVelocityOutliers.setZero();
+		mAccelerationOutliers.setZero();
+
+		mLastFrameTime = 0.0;
+	}
+
+	// Raw frames, before any smoothing; any thread, one at a time
+	void observe(const JointFrame& frame)
+	{
+		std::lock_guard lock(mMutex);
+
+		gather(frame);
+
+		const double frame_dt = mLastFrameTime > 0.0 ? frame.frameTime - mLastFrameTime : 0.0;
+		mLastFrameTime = frame.frameTime;
+
+		// Only lanes with a new sample and one before it (primed) move the windows
+		const Mask& primed = mPrimed;
+		const Lanes& dt = mInterval;
+
+		// Weight of this sample in every window, 0 where there's nothing new
+		const Lanes alpha = primed * window_weight(dt, settings.window);
+
+		// Sample intervals, the first one seeds the mean
+		const Mask gap = primed * (mMeanInterval > 0.f).cast<float>() *
+			(dt > mMeanInterval * settings.gapFactor).cast<float>();
+		mGaps += gap.cast<double>();
+		mMeanInterval = (mMeanInterval > 0.f).select(mMeanInterval + alpha * (dt - mMeanInterval), dt);
+		mPeakInterval = (mPeakInterval * (1.f - alpha)).max(dt);
+
+		// Dropouts: present but without position tracking, timed on the frame clock
+		const Mask lost = mPresent * (1.f - mTracked);
+		mDropouts += (lost * mWasTracked).cast<double>();
+		mDropoutTime = lost * (mDropoutTime + static_cast<float>(frame_dt));
+		mDropoutTotal += lost.cast<double>() * frame_dt;
+		mLongestDropout = mLongestDropout.max(mDropoutTime);
+		mWasTracked = (mPresent > 0.f).select(mTracked, mWasTracked);
+
+		// Velocity/acceleration against their own windows, once those mean something
+		const Mask measured = primed * mTracked;
+		const Mask warm = measured * mWarm;
+		const Mask speed_outlier = warm * outlier(mSpeed, mSpeedMean, mSpeedVariance, 0.05f);
+		const Mask acceleration_outlier = warm * outlier(mAcceleration, mAccelerationMean, mAccelerationVariance, 0.5f);
+		mVelocityOutliers += speed_outlier.cast<double>();
+		mAccelerationOutliers += acceleration_outlier.cast<double>();
+		mOutlierRate += alpha * (speed_outlier.max(acceleration_outlier) - mOutlierRate);
+
+		const Lanes measured_alpha = alpha * measured;
+		accumulate(mSpeed, mSpeedMean, mSpeedVariance, measured_alpha);
+		accumulate(mAcceleration, mAccelerationMean, mAccelerationVariance, measured_alpha);
+
+		// Jitter at rest, around the pose the joint settled at
+		// A rest period starts over from the current pose instead of dragging the old one along
+		const Mask resting = measured * (mSpeed < settings.restSpeed).cast<float>() *
+			(mAngularSpeed < settings.restAngularSpeed).cast<float>();
+		const Mask settling = resting * (1.f - mWasResting);
+		mWasResting = (primed > 0.f).select(resting, mWasResting);
+
+		settle(mPosition, mPositionMean, settling);
+
+		// Same hemisphere as the mean, then small deviations are ~half the angle
+		Lanes dot = Lanes::Zero();
+		for (int row = 0; row < 4; row++)
+			dot += joint_lanes::row(mOrientation, row) * joint_lanes::row(mOrientationMean, row);
+		const Lanes sign = (settling > 0.f || dot >= 0.f).select(Lanes::Ones(), -Lanes::Ones());
+		for (int row = 0; row < 4; row++)
+			joint_lanes::row(mOrientation, row) *= sign;
+		settle(mOrientation, mOrientationMean, settling);
+
+		const Lanes rest_alpha = alpha * resting * (1.f - settling);
+		accumulate_rows(mPosition, mPositionMean, mPositionVariance, rest_alpha);
+		accumulate_rows(mOrientation, mOrientationMean, mOrientationVariance, rest_alpha);
+	}
+
+	// Everything observe() has, for display or a dump
+	void summary(Summary& out) const
+	{
+		std::lock_guard lock(mMutex);
+
+		for (int i = 0; i < static_cast<int>(max_frame_joints); i++)
+		{
+			JointQuality& joint = out[i];
+			joint.samples = static_cast<uint64_t>(mSamples[i]);
+			joint.tracked = mTracked[i] > 0.f;
+
+			joint.positionJitter = std::sqrt(static_cast<double>(mPositionVariance[i])) * 1000.0;
+			joint.angularJitter = 2.0 * std::sqrt(static_cast<double>(mOrientationVariance[i])) * 180.0 / 3.14159265358979;
+
+			joint.dropouts = static_cast<uint64_t>(mDropouts[i]);
+			joint.dropoutSeconds = mDropoutTotal[i];
+			joint.longestDropout = mLongestDropout[i];
+
+			joint.meanInterval = mMeanInterval[i] * 1000.0;
+			joint.peakInterval = mPeakInterval[i] * 1000.0;
+			joint.gaps = static_cast<uint64_t>(mGaps[i]);
+
+			joint.velocityOutliers = static_cast<uint64_t>(mVelocityOutliers[i]);
+			joint.accelerationOutliers = static_cast<uint64_t>(mAccelerationOutliers[i]);
+			joint.outlierRate = mOutlierRate[i];
+		}
+	}
+
+	// Devices that ever sent a sample, "device" as in SharedPose::device
+	static std::string to_json(const Summary& summary)
+	{
+		std::string json = "{\"tracking_quality\": [\n";
+		bool first = true;
+
+		for (size_t i = 0; i < summary.size(); i++)
+		{
+			const JointQuality& joint = summary[i];
+			if (joint.samples == 0) continue;
+
+			char line[640];
+			std::snprintf(line, sizeof(line),
+			              "%s  {\"device\": %zu, \"samples\": %llu, \"tracked\": %s, "
+			              "\"position_jitter_mm\": %.3f, \"angular_jitter_deg\": %.3f, "
+			              "\"dropouts\": %llu, \"dropout_s\": %.3f, \"longest_dropout_s\": %.3f, "
+			              "\"mean_interval_ms\": %.3f, \"peak_interval_ms\": %.3f, \"gaps\": %llu, "
+			              "\"velocity_outliers\": %llu, \"acceleration_outliers\": %llu, \"outlier_rate\": %.5f}",
+			              first ? "" : ",\n", i, static_cast<unsigned long long>(joint.samples),
+			              joint.tracked ? "true" : "false",
+			              joint.positionJitter, joint.angularJitter,
+			              static_cast<unsigned long long>(joint.dropouts), joint.dropoutSeconds, joint.longestDropout,
+			              joint.meanInterval, joint.peakInterval, static_cast<unsigned long long>(joint.gaps),
+			              static_cast<unsigned long long>(joint.velocityOutliers),
+			              static_cast<unsigned long long>(joint.accelerationOutliers), joint.outlierRate);
+			json += line;
+			first = false;
+		}
+		return json + "\n]}\n";
+	}
+
+private:
+	static constexpr int lanes = joint_lanes::count;
+
+	using Lanes = joint_lanes::Lanes;
+	using Mask = Lanes; // 0 or 1 per lane
+	using Times = Eigen::Array<double, lanes, 1>;
+	using Counts = Eigen::Array<double, lanes, 1>; // Exact for longer than anyone plays, and no integer conversions
+	template <int Rows>
+	using Channels = joint_lanes::Channels<Rows>;
+
+	// Frame joints -> device lanes, absent devices keep whatever they had
+	// Sample times stay doubles, so whether a sample is new (and how long after the last
+	// one it came) is worked out here, per joint, and only the float interval goes on
+	void gather(const JointFrame& frame)
+	{
+		mPresent.setZero();
+		mPrimed.setZero();
+		mInterval.setZero();
+
+		uint64_t objects = frame.objectMask;
+		for (uint32_t i = 0; i < frame.jointCount; i++)
+		{
+			int lane = static_cast<int>(i);
+			if (i >= 2)
+			{
+				if (objects == 0) break;
+				lane = 2 + std::countr_zero(objects);
+				objects &= objects - 1;
+			}
+
+			const JointSample& sample = frame.joints[i];
+			mPresent[lane] = 1.f;
+			mTracked[lane] = sample.statusFlags & status_position_tracked ? 1.f : 0.f;
+
+			// New samples only, the same one twice would count as perfectly still
+			if (sample.sampleTime > mLastSample[lane])
+			{
+				if (mLastSample[lane] > 0.0)
+				{
+					mPrimed[lane] = 1.f;
+					mInterval[lane] = static_cast<float>(sample.sampleTime - mLastSample[lane]);
+				}
+				mLastSample[lane] = sample.sampleTime;
+				mSamples[lane] += 1.0;
+				mWarm[lane] = mSamples[lane] > settings.outlierSamples ? 1.f : 0.f;
+			}
+
+			mPosition.col(lane) = Eigen::Map<const Eigen::Array3f>(sample.position);
+			mOrientation.col(lane) = Eigen::Map<const Eigen::Array4f>(sample.orientation);
+			mSpeed[lane] = Eigen::Map<const Eigen::Vector3f>(sample.linearVelocity).norm();
+			mAcceleration[lane] = Eigen::Map<const Eigen::Vector3f>(sample.linearAcceleration).norm();
+			mAngularSpeed[lane] = Eigen::Map<const Eigen::Vector3f>(sample.angularVelocity).norm();
+		}
+	}
+
+	// 1 where 'value' is further than outlierSigma deviations (plus a floor) from its mean
+	Lanes outlier(const Lanes& value, const Lanes& mean, const Lanes& variance, const float floor) const
+	{
+		return ((value - mean).abs() > variance.sqrt() * settings.outlierSigma + floor).cast<float>();
+	}
+
+	// Exponentially weighted mean/variance, 'alpha' 0 leaves a lane alone
+	static void accumulate(const Lanes& value, Lanes& mean, Lanes& variance, const Lanes& alpha)
+	{
+		const Lanes delta = value - mean;
+		mean += alpha * delta;
+		variance = (1.f - alpha) * (variance + alpha * delta.square());
+	}
+
+	// Same, summing the variance over every component
+	template <int Rows>
+	static void accumulate_rows(const Channels<Rows>& value, Channels<Rows>& mean, Lanes& variance,
+	                            const Lanes& alpha)
+	{
+		Lanes squared = Lanes::Zero();
+		for (int row = 0; row < Rows; row++)
+		{
+			const Lanes delta = joint_lanes::row(value, row) - joint_lanes::row(mean, row);
+			joint_lanes::row(mean, row) += alpha * delta;
+			squared += delta.square();
+		}
+		variance = (1.f - alpha) * (variance + alpha * squared);
+	}
+
+	// Mean jumps to the value where 'settling' is 1
+	template <int Rows>
+	static void settle(const Channels<Rows>& value, Channels<Rows>& mean, const Mask& settling)
+	{
+		for (int row = 0; row < Rows; row++)
+			joint_lanes::row(mean, row) += settling * (joint_lanes::row(value, row) - joint_lanes::row(mean, row));
+	}
+
+	mutable std::mutex mMutex;
+
+	Channels<3> mPosition, mPositionMean;
+	Channels<4> mOrientation, mOrientationMean;
+	Lanes mPositionVariance, mOrientationVariance;
+
+	Lanes mSpeed, mSpeedMean, mSpeedVariance;
+	Lanes mAcceleration, mAccelerationMean, mAccelerationVariance;
+	Lanes mAngularSpeed = Lanes::Zero();
+	Lanes mOutlierRate;
+
+	Times mLastSample; // s, SDK clock
+	Lanes mInterval, mMeanInterval, mPeakInterval; // s, this frame's is 0 without a new sample
+
+	Mask mPresent, mPrimed, mWarm, mTracked, mWasTracked, mWasResting;
+
+	Lanes mDropoutTime; // s, ongoing dropout
+	Times mDropoutTotal;
+	Lanes mLongestDropout;
+
+	Counts mSamples, mDropouts, mGaps, mVelocityOutliers, mAccelerationOutliers;
+
+	double mLastFrameTime = 0.0;
+};
@@ -0,0 +1,194 @@
+// The plugin's benchmarks without Amethyst, LibOVR or a debug CRT, results as JSON on stdout
+//   pose_bench [--frames N] [--filter none|oneeuro|kalman] [benchmark...]
+// Benchmarks: ingest load conversion recovery stream dead_reckoning extrapolation (all if none given)
+// The plugin's own joints aren't here, 'apply' and 'conversion' write plain double poses instead
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "BenchmarkSetup.h"
+#include "ConversionBenchmark.h"
+#include "ExtrapolationBenchmark.h"
+#include "IngestBenchmark.h"
+#include "JointBatch.h"
+#include "LoadBenchmark.h"
+#include "PoseFilterBank.h"
+#include "ReckoningBenchmark.h"
+#include "RecoveryBenchmark.h"
+#include "SimulatedPoseSource.h"
+#include "StreamBenchmark.h"
+
+// Every heap allocation in the process, any build
+std::atomic<uint64_t> heap_allocations = 0;
+
+void* counted_allocation(const std::size_t size, const std::size_t alignment)
+{
+	heap_allocations.fetch_add(1, std::memory_order_relaxed);
+
+	void* memory = nullptr;
+	if (alignment <= alignof(std::max_align_t))
+		memory = std::malloc(size ? size : 1);
+	else
+	{
+#ifdef _WIN32
+		memory = _aligned_malloc(size ? size : 1, alignment);
+#else
+		if (posix_memalign(&memory, alignment, size ? size : 1) != 0) memory = nullptr;
+#endif
+	}
+
+	if (!memory) throw std::bad_alloc();
+	return memory;
+}
+
+void* operator new(const std::size_t size) { return counted_allocation(size, 0); }
+
+void* operator new(const std::size_t size, const std::align_val_t alignment)
+{
+	return counted_allocation(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+
+void operator delete(void* memory, const std::align_val_t alignment) noexcept
+{
+#ifdef _WIN32
+	if (static_cast<std::size_t>(alignment) > alignof(std::max_align_t))
+	{
+		_aligned_free(memory);
+		return;
+	}
+#endif
+	(void)alignment;
+	std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t, const std::align_val_t alignment) noexcept
+{
+	operator delete(memory, alignment);
+}
+
+// What a K2TrackedJoint keeps, near enough
+struct PlainJoint
+{
+	double position[3];
+	double orientation[4]; // wxyz
+	double linearVelocity[3];
+	double linearAcceleration[3];
+	double angularVelocity[3];
+	double angularAcceleration[3];
+};
+
+int main(const int argc, char** argv)
+{
+	BenchmarkSetup setup;
+	int filter_mode = PoseFilterBank::Filter_OneEuro;
+	std::vector<std::string> selected;
+
+	for (int i = 1; i < argc; i++)
+	{
+		if (!std::strcmp(argv[i], "--frames") && i + 1 < argc)
+			setup.frames = static_cast<uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+		else if (!std::strcmp(argv[i], "--filter") && i + 1 < argc)
+		{
+			const std::string mode = argv[++i];
+			filter_mode = mode == "none"
+				              ? PoseFilterBank::Filter_None
+				              : mode == "kalman"
+				              ? PoseFilterBank::Filter_Kalman
+				              : PoseFilterBank::Filter_OneEuro;
+		}
+		else if (argv[i][0] == '-')
+		{
+			std::fprintf(stderr, "usage: %s [--frames N] [--filter none|oneeuro|kalman] [benchmark...]\n", argv[0]);
+			return 2;
+		}
+		else
+			selected.emplace_back(argv[i]);
+	}
+	if (setup.frames == 0) setup.frames = 1;
+
+	const auto wanted = [&selected](const char* name)
+	{
+		if (selected.empty()) return true;
+		for (const std::string& entry : selected)
+			if (entry == name) return true;
+		return false;
+	};
+
+	auto filter = std::make_unique<PoseFilterBank>();
+	filter->set_mode(filter_mode);
+
+	std::vector<PlainJoint> joints(max_frame_joints);
+	JointBatch batch;
+
+	const auto convert_batch = [&](const JointFrame& frame)
+	{
+		batch.convert(frame, [&](const uint32_t i, const JointBatch::Pose& pose)
+		{
+			PlainJoint& joint = joints[i];
+			for (int c = 0; c < 3; c++)
+			{
+				joint.position[c] = pose[JointBatch::Position + c];
+				joint.linearVelocity[c] = pose[JointBatch::LinearVelocity + c];
+				joint.linearAcceleration[c] = pose[JointBatch::LinearAcceleration + c];
+				joint.angularVelocity[c] = pose[JointBatch::AngularVelocity + c];
+				joint.angularAcceleration[c] = pose[JointBatch::AngularAcceleration + c];
+			}
+			joint.orientation[0] = pose[JointBatch::Orientation + 3];
+			for (int c = 0; c < 3; c++)
+				joint.orientation[c + 1] = pose[JointBatch::Orientation + c];
+		});
+	};
+
+	setup.filter = [&](JointFrame& frame) { filter->filter(frame); };
+	setup.apply = convert_batch;
+	setup.convert_batch = convert_batch;
+	setup.convert_scalar = [&](const JointFrame& frame)
+	{
+		for (uint32_t i = 0; i < frame.jointCount && i < joints.size(); i++)
+		{
+			const JointSample& pose = frame.joints[i];
+			joints[i] = {
+				{pose.position[0], pose.position[1], pose.position[2]},
+				{pose.orientation[3], pose.orientation[0], pose.orientation[1], pose.orientation[2]},
+				{pose.linearVelocity[0], pose.linearVelocity[1], pose.linearVelocity[2]},
+				{pose.linearAcceleration[0], pose.linearAcceleration[1], pose.linearAcceleration[2]},
+				{pose.angularVelocity[0], pose.angularVelocity[1], pose.angularVelocity[2]},
+				{pose.angularAcceleration[0], pose.angularAcceleration[1], pose.angularAcceleration[2]}
+			};
+		}
+	};
+	setup.allocations = [] { return heap_allocations.load(std::memory_order_relaxed); };
+	setup.source = [](const uint32_t objects) -> std::unique_ptr<IPoseSource>
+	{
+		SimulationSettings settings;
+		settings.objects = objects;
+		return std::make_unique<SimulatedPoseSource>(settings);
+	};
+
+	BenchmarkReport report("pose_ingest");
+	if (wanted("ingest"))
+		report.add("results", json_array(benchmark_ingest(setup)));
+	if (wanted("load"))
+		report.add("load", to_json(benchmark_load(setup, max_frame_joints - 2, 2000, 5.0)));
+	if (wanted("conversion"))
+		report.add("conversion", json_array(benchmark_conversion(setup)));
+	if (wanted("recovery"))
+		report.add("recovery", json_array(benchmark_recovery()));
+	if (wanted("stream"))
+		report.add("stream", json_array(benchmark_stream(setup)));
+	if (wanted("dead_reckoning"))
+		report.add("dead_reckoning", to_json(benchmark_dead_reckoning()));
+	if (wanted("extrapolation"))
+		report.add("extrapolation", json_array(benchmark_extrapolation(setup)));
+
+	std::fputs(report.json().c_str(), stdout);
+	return 0;
+}
@@ -0,0 +1,188 @@
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "AsyncLogSink.h"
+
+namespace
+{
+	using namespace std::chrono_literals;
+
+	// The host's three callbacks, writing down what they got at which level
+	class HostLog
+	{
+	public:
+		HostLog() :
+			info([this](std::wstring message) { add(Log_Info, std::move(message)); }),
+			warning([this](std::wstring message) { add(Log_Warning, std::move(message)); }),
+			error([this](std::wstring message) { add(Log_Error, std::move(message)); })
+		{
+		}
+
+		void start(AsyncLogSink& sink) { sink.start(info, warning, error); }
+
+		[[nodiscard]] std::vector<std::pair<LogLevel, std::wstring>> messages()
+		{
+			std::lock_guard lock(mMutex);
+			return mMessages;
+		}
+
+		AsyncLogSink::Callback info, warning, error;
+
+	private:
+		void add(const LogLevel level, std::wstring message)
+		{
+			std::lock_guard lock(mMutex);
+			mMessages.emplace_back(level, std::move(message));
+		}
+
+		std::mutex mMutex;
+		std::vector<std::pair<LogLevel, std::wstring>> mMessages;
+	};
+}
+
+TEST(AsyncLogSink, GoesToTheSitesLevelWithItsDetails)
+{
+	LogSite info_site(L"Started", Log_Info);
+	LogSite error_site(L"Couldn't submit", Log_Error);
+	HostLog host;
+	AsyncLogSink sink;
+	host.start(sink);
+
+	sink.log(info_site);
+	sink.log(error_site, L"error %d", -3000);
+	sink.stop();
+
+	const auto messages = host.messages();
+	ASSERT_EQ(messages.size(), 2u);
+	EXPECT_EQ(messages[0], std::make_pair(Log_Info, std::wstring(L"Started")));
+	EXPECT_EQ(messages[1], std::make_pair(Log_Error, std::wstring(L"Couldn't submit: error -3000")));
+}
+
+TEST(AsyncLogSink, StopFlushesWhatsQueued)
+{
+	LogSite site(L"Frame", Log_Info, 0s);
+	HostLog host;
+	AsyncLogSink sink;
+	host.start(sink);
+
+	// Well within one drain period, stop() has to hand them all over itself
+	for (int n = 0; n < 100; n++)
+		sink.log(site, L"%d", n);
+	sink.stop();
+
+	const auto messages = host.messages();
+	ASSERT_EQ(messages.size(), 100u);
+	for (int n = 0; n < 100; n++)
+		EXPECT_EQ(messages[n].second, L"Frame: " + std::to_wstring(n));
+	EXPECT_EQ(sink.dropped(), 0u);
+}
+
+TEST(AsyncLogSink, DropsWhenTheRingIsFull)
+{
+	LogSite site(L"Frame", Log_Warning, 0s);
+	HostLog host;
+	AsyncLogSink sink;
+
+	// Nothing draining yet: the ring fills up, the rest is dropped rather than waited on
+	for (size_t n = 0; n < AsyncLogSink::capacity + 10; n++)
+		sink.log(site, L"%zu", n);
+	EXPECT_EQ(sink.dropped(), 10u);
+
+	// The oldest ones made it, in order
+	host.start(sink);
+	sink.stop();
+	const auto messages = host.messages();
+	ASSERT_EQ(messages.size(), AsyncLogSink::capacity);
+	EXPECT_EQ(messages.front().second, L"Frame: 0");
+	EXPECT_EQ(messages.back().second, L"Frame: " + std::to_wstring(AsyncLogSink::capacity - 1));
+
+	// And there's room again
+	host.start(sink);
+	sink.log(site, L"again");
+	sink.stop();
+	EXPECT_EQ(host.messages().back().second, L"Frame: again");
+	EXPECT_EQ(sink.dropped(), 10u);
+}
+
+TEST(AsyncLogSink, CoalescesRepeatsWithinTheWindow)
+{
+	LogSite site(L"Poses failed", Log_Warning, 1s);
+	HostLog host;
+	AsyncLogSink sink;
+	host.start(sink);
+
+	for (int n = 0; n < 900; n++)
+		sink.log(site, L"error %d", n);
+
+	// The window closes on the drain thread, with a summary of what it held back
+	std::this_thread::sleep_for(1500ms);
+	auto messages = host.messages();
+	ASSERT_EQ(messages.size(), 2u);
+	EXPECT_EQ(messages[0].second, L"Poses failed: error 0");
+	EXPECT_EQ(messages[1], std::make_pair(Log_Warning, std::wstring(L"Poses failed (repeated 899x in last 1 s)")));
+
+	// Then the next one opens a window of its own, and stopping flushes its repeats
+	sink.log(site, L"error %d", 900);
+	sink.log(site, L"error %d", 901);
+	sink.log(site, L"error %d", 902);
+	sink.stop();
+
+	messages = host.messages();
+	ASSERT_EQ(messages.size(), 4u);
+	EXPECT_EQ(messages[2].second, L"Poses failed: error 900");
+	EXPECT_EQ(messages[3].second, L"Poses failed (repeated 2x in last 1 s)");
+	EXPECT_EQ(sink.dropped(), 0u);
+}
+
+TEST(AsyncLogSink, EverySiteHasItsOwnWindow)
+{
+	LogSite first(L"First", Log_Info, 10s);
+	LogSite second(L"Second", Log_Info, 10s);
+	HostLog host;
+	AsyncLogSink sink;
+	host.start(sink);
+
+	for (int n = 0; n < 5; n++)
+	{
+		sink.log(first);
+		sink.log(second);
+	}
+	sink.stop();
+
+	const auto messages = host.messages();
+	ASSERT_EQ(messages.size(), 4u);
+	EXPECT_EQ(messages[0].second, L"First");
+	EXPECT_EQ(messages[1].second, L"Second");
+	EXPECT_EQ(messages[2].second, L"First (repeated 4x in last 10 s)");
+	EXPECT_EQ(messages[3].second, L"Second (repeated 4x in last 10 s)");
+}
+
+TEST(AsyncLogSink, LogsFromManyThreads)
+{
+	LogSite site(L"Worker", Log_Info, 0s);
+	HostLog host;
+	AsyncLogSink sink;
+	host.start(sink);
+
+	constexpr int threads = 4, per_thread = 50;
+	std::vector<std::thread> workers;
+	for (int t = 0; t < threads; t++)
+		workers.emplace_back([&sink, &site, t]
+		{
+			for (int n = 0; n < per_thread; n++)
+				sink.log(site, L"%d", t);
+		});
+	for (auto& worker : workers)
+		worker.join();
+	sink.stop();
+
+	// Fits in the ring even if the drain thread never got a look in
+	EXPECT_EQ(host.messages().size(), static_cast<size_t>(threads * per_thread));
+	EXPECT_EQ(sink.dropped(), 0u);
+}
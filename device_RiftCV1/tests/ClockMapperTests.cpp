@@ -0,0 +1,205 @@
+#include <cmath>
+#include <cstdint>
+
+#include <gtest/gtest.h>
+
+#include "ClockMapper.h"
+#include "JointFrame.h"
+#include "PoseExtrapolator.h"
+
+namespace
+{
+	// Host clock 1000 s ahead of the SDK's, running at the same rate
+	ClockMapping offset_mapping()
+	{
+		ClockMapping mapping;
+		mapping.valid = true;
+		mapping.sdkReference = 50.0;
+		mapping.hostReference = 1050'000'000;
+		return mapping;
+	}
+
+	// Host clock as a test scripts it: offset and rate against the SDK's, maybe a jump
+	struct HostClock
+	{
+		long long offset = 1000'000'000; // us at SDK time 0
+		double rate = 1.0;
+		double stepAt = 1e9; // SDK time the host clock jumps by 'step'
+		long long step = 0;
+
+		[[nodiscard]] long long at(const double sdk_time) const
+		{
+			return offset + std::llround(sdk_time * rate * 1e6) + (sdk_time >= stepAt ? step : 0);
+		}
+	};
+
+	// 500 Hz of reads for ['from', 'to'), each bracketed by 10 us
+	// 'late': extra us on every read in a slot, like a stale SDK time would look, every 'every'th slot
+	void feed(ClockMapper& mapper, const HostClock& host, const double from, const double to,
+	          const long long late = 0, const int every = 0)
+	{
+		for (double t = from; t < to; t += 0.002)
+		{
+			const auto slot = static_cast<int>(std::floor(t / ClockMapper::slot_seconds));
+			const long long host_time = host.at(t) + (every && slot % every == 0 ? late : 0);
+			mapper.add(t, host_time - 5, host_time + 5);
+		}
+	}
+}
+
+TEST(PoseHostTime, IsWhenThePredictedPoseIsFor)
+{
+	// Sampled 4 ms before the frame was requested, then predicted on per joint
+	JointFrame frame;
+	frame.clock = offset_mapping();
+	frame.frameTime = 60.0;
+	frame.jointCount = 3;
+	for (uint32_t i = 0; i < frame.jointCount; i++)
+		frame.joints[i].sampleTime = 59.996;
+
+	PoseExtrapolator::Horizons horizons{};
+	horizons[1] = 0.011f;
+	horizons[2] = 0.05f;
+
+	PoseExtrapolator extrapolator;
+	extrapolator.load(frame);
+	JointFrame predicted;
+	extrapolator.extrapolate(horizons, predicted);
+
+	// Sample times stay behind, the stamp follows the horizon
+	for (uint32_t i = 0; i < predicted.jointCount; i++)
+	{
+		EXPECT_EQ(predicted.joints[i].sampleTime, 59.996);
+		EXPECT_EQ(pose_host_time(predicted, horizons[i], 0), 1060'000'000 + std::llround(horizons[i] * 1e6)) << i;
+	}
+}
+
+TEST(PoseHostTime, FallsBackUntilTheClocksAreMapped)
+{
+	JointFrame frame;
+	frame.frameTime = 60.0;
+	EXPECT_EQ(pose_host_time(frame, 0.011, 12345), 12345);
+
+	frame.clock = offset_mapping();
+	EXPECT_NE(pose_host_time(frame, 0.011, 12345), 12345);
+}
+
+TEST(ClockMapper, NotTrustedUntilItHasEnoughSlots)
+{
+	ClockMapper mapper;
+	feed(mapper, HostClock{}, 0.0, ClockMapper::slot_seconds * (ClockMapper::min_slots - 1));
+	EXPECT_FALSE(mapper.mapping().valid);
+
+	feed(mapper, HostClock{}, ClockMapper::slot_seconds * (ClockMapper::min_slots - 1), 1.0);
+	EXPECT_TRUE(mapper.mapping().valid);
+}
+
+TEST(ClockMapper, FitsOffsetAndDrift)
+{
+	HostClock host;
+	host.rate = 1.0 + 50e-6;
+
+	ClockMapper mapper;
+	feed(mapper, host, 0.0, 8.0);
+	ASSERT_TRUE(mapper.mapping().valid);
+
+	EXPECT_NEAR(mapper.drift_ppm(), 50.0, 2.0);
+	EXPECT_LT(mapper.residual_us(), 5.0);
+	EXPECT_EQ(mapper.rejected(), 0u);
+	for (const double t : {7.0, 7.95, 8.1})
+		EXPECT_NEAR(static_cast<double>(mapper.mapping().to_host(t)), static_cast<double>(host.at(t)), 5.0) << t;
+}
+
+TEST(ClockMapper, KeepsTheFastestReadOfEverySlot)
+{
+	HostClock host;
+	ClockMapper mapper;
+
+	// Every other read preempted for 2 ms between the two host readings
+	bool slow = false;
+	for (double t = 0.0; t < 3.0; t += 0.002, slow = !slow)
+	{
+		const long long host_time = host.at(t);
+		mapper.add(t, host_time - 5, host_time + 5 + (slow ? 2000 : 0));
+	}
+
+	ASSERT_TRUE(mapper.mapping().valid);
+	EXPECT_NEAR(static_cast<double>(mapper.mapping().to_host(3.0)), static_cast<double>(host.at(3.0)), 5.0);
+}
+
+TEST(ClockMapper, RejectsSlotsOffTheLine)
+{
+	HostClock host;
+	host.rate = 1.0 - 20e-6;
+
+	// Every 10th slot half a millisecond late: below a clock step, way off the line
+	ClockMapper mapper;
+	feed(mapper, host, 0.0, 8.0, 500, 10);
+	ASSERT_TRUE(mapper.mapping().valid);
+
+	EXPECT_GT(mapper.rejected(), 0u);
+	EXPECT_EQ(mapper.steps(), 0u);
+	EXPECT_NEAR(mapper.drift_ppm(), -20.0, 2.0);
+	EXPECT_LT(mapper.residual_us(), 5.0); // Only what was kept
+	EXPECT_NEAR(static_cast<double>(mapper.mapping().to_host(8.0)), static_cast<double>(host.at(8.0)), 5.0);
+}
+
+TEST(ClockMapper, ClampsDriftNoClockReallyHas)
+{
+	HostClock host;
+	host.rate = 1.05;
+
+	ClockMapper mapper;
+	feed(mapper, host, 0.0, 3.0);
+	ASSERT_TRUE(mapper.mapping().valid);
+	EXPECT_EQ(mapper.mapping().rate, 1.0);
+	EXPECT_EQ(mapper.drift_ppm(), 0.0);
+}
+
+TEST(ClockMapper, FollowsTheHostClockWhenItJumps)
+{
+	for (const long long step : {2'000'000LL, -2'000'000LL})
+	{
+		HostClock host;
+		host.rate = 1.0 + 30e-6;
+		host.stepAt = 4.0;
+		host.step = step;
+
+		ClockMapper mapper;
+		feed(mapper, host, 0.0, 4.0);
+		ASSERT_TRUE(mapper.mapping().valid);
+
+		// A couple of slots later it's on the new clock already, not once most of the history is
+		feed(mapper, host, 4.0, 4.25);
+		EXPECT_EQ(mapper.steps(), 1u) << step;
+		EXPECT_TRUE(mapper.mapping().valid);
+		EXPECT_NEAR(static_cast<double>(mapper.mapping().to_host(4.25)), static_cast<double>(host.at(4.25)), 50.0)
+			<< step;
+
+		// Then fits on the new clock only
+		feed(mapper, host, 4.25, 8.0);
+		EXPECT_EQ(mapper.steps(), 1u);
+		EXPECT_EQ(mapper.rejected(), 0u);
+		EXPECT_NEAR(mapper.drift_ppm(), 30.0, 3.0) << step;
+		EXPECT_NEAR(static_cast<double>(mapper.mapping().to_host(8.0)), static_cast<double>(host.at(8.0)), 5.0)
+			<< step;
+	}
+}
+
+TEST(ClockMapper, ResetForgetsEverything)
+{
+	ClockMapper mapper;
+	feed(mapper, HostClock{}, 0.0, 2.0);
+	ASSERT_TRUE(mapper.mapping().valid);
+
+	mapper.reset();
+	EXPECT_FALSE(mapper.mapping().valid);
+	EXPECT_EQ(mapper.steps(), 0u);
+
+	// Another session's clock, nothing of the old one left in the fit
+	HostClock other;
+	other.offset = 5000'000'000;
+	feed(mapper, other, 10.0, 12.0);
+	EXPECT_EQ(mapper.steps(), 0u);
+	EXPECT_NEAR(static_cast<double>(mapper.mapping().to_host(12.0)), static_cast<double>(other.at(12.0)), 5.0);
+}
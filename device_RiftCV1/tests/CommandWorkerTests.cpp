@@ -0,0 +1,280 @@
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "CommandWorker.h"
+
+namespace
+{
+	using namespace std::chrono_literals;
+
+	// Stands in for the ODT steps: every action just notes down that it ran
+	class ActionLog
+	{
+	public:
+		CommandWorker::Command action(std::string name)
+		{
+			return [this, name = std::move(name)]
+			{
+				std::lock_guard lock(mMutex);
+				mRan.push_back(name);
+				mThreads.push_back(std::this_thread::get_id());
+			};
+		}
+
+		[[nodiscard]] std::vector<std::string> ran() const
+		{
+			std::lock_guard lock(mMutex);
+			return mRan;
+		}
+
+		[[nodiscard]] size_t count(const std::string& name) const
+		{
+			std::lock_guard lock(mMutex);
+			return std::count(mRan.begin(), mRan.end(), name);
+		}
+
+		[[nodiscard]] std::vector<std::thread::id> threads() const
+		{
+			std::lock_guard lock(mMutex);
+			return mThreads;
+		}
+
+		// Until 'name' ran 'times', or a few seconds went by
+		void wait_for(const std::string& name, const size_t times = 1) const
+		{
+			const auto until = std::chrono::steady_clock::now() + 5s;
+			while (count(name) < times && std::chrono::steady_clock::now() < until)
+				std::this_thread::sleep_for(1ms);
+		}
+
+	private:
+		mutable std::mutex mMutex;
+		std::vector<std::string> mRan;
+		std::vector<std::thread::id> mThreads;
+	};
+}
+
+TEST(CommandWorker, PostedCommandsRunInOrderOnTheWorker)
+{
+	ActionLog log;
+	CommandWorker worker;
+	worker.start();
+
+	for (const char* name : {"a", "b", "c", "d"})
+		worker.post(log.action(name));
+	log.wait_for("d");
+	worker.stop();
+
+	EXPECT_EQ(log.ran(), (std::vector<std::string>{"a", "b", "c", "d"}));
+	for (const std::thread::id id : log.threads())
+		EXPECT_NE(id, std::this_thread::get_id());
+}
+
+TEST(CommandWorker, CommandsPostedBeforeStartRunOnceItsUp)
+{
+	ActionLog log;
+	CommandWorker worker;
+	worker.post(log.action("early"));
+	worker.schedule(20ms, log.action("early timer"));
+
+	std::this_thread::sleep_for(30ms);
+	EXPECT_TRUE(log.ran().empty());
+	EXPECT_EQ(worker.pending(), 2u);
+
+	worker.start();
+	log.wait_for("early timer");
+	worker.stop();
+	EXPECT_EQ(log.ran(), (std::vector<std::string>{"early", "early timer"}));
+}
+
+TEST(CommandWorker, TimersFireInDelayOrderAndNotEarly)
+{
+	ActionLog log;
+	CommandWorker worker;
+	worker.start();
+
+	const auto start = std::chrono::steady_clock::now();
+	std::atomic<std::chrono::steady_clock::duration> fired{};
+	worker.schedule(60ms, log.action("third"));
+	worker.schedule(20ms, log.action("first"));
+	worker.schedule(40ms, [&] { fired = std::chrono::steady_clock::now() - start; });
+	worker.schedule(40ms, log.action("second"));
+
+	log.wait_for("third");
+	worker.stop();
+
+	EXPECT_EQ(log.ran(), (std::vector<std::string>{"first", "second", "third"}));
+	EXPECT_GE(fired.load(), 40ms);
+}
+
+TEST(CommandWorker, DelaysLongerThanOneTurnOfTheWheelWait)
+{
+	ActionLog log;
+	CommandWorker worker;
+	worker.start();
+
+	// One full turn plus a bit: lands in a slot that comes round earlier, one round ahead
+	const auto delay = CommandWorker::tick * (CommandWorker::wheel_slots + 5);
+	const auto start = std::chrono::steady_clock::now();
+	worker.schedule(std::chrono::duration_cast<std::chrono::milliseconds>(delay), log.action("late"));
+	worker.schedule(50ms, log.action("soon"));
+
+	log.wait_for("late");
+	const auto took = std::chrono::steady_clock::now() - start;
+	worker.stop();
+
+	EXPECT_EQ(log.ran(), (std::vector<std::string>{"soon", "late"}));
+	EXPECT_GE(took, delay);
+}
+
+TEST(CommandWorker, CancelledTimersNeverRun)
+{
+	ActionLog log;
+	CommandWorker worker;
+	worker.start();
+
+	const CommandWorker::TimerId cancelled = worker.schedule(30ms, log.action("cancelled"));
+	worker.schedule(60ms, log.action("kept"));
+	worker.cancel(cancelled);
+	worker.cancel(cancelled); // Twice is fine
+	worker.cancel(12345); // So is one that never existed
+
+	log.wait_for("kept");
+	std::this_thread::sleep_for(20ms);
+	worker.stop();
+
+	EXPECT_EQ(log.ran(), (std::vector<std::string>{"kept"}));
+}
+
+TEST(CommandWorker, PeriodicTimerRepeatsUntilCancelledFromItsOwnCommand)
+{
+	ActionLog log;
+	CommandWorker worker;
+	worker.start();
+
+	std::atomic<CommandWorker::TimerId> id = 0;
+	std::atomic<int> runs = 0;
+	id = worker.schedule(0ms, [&]
+	{
+		if (++runs == 3)
+			worker.cancel(id); // The keep-alive poke stops itself like this
+		log.action("poke")();
+	}, 10ms);
+
+	log.wait_for("poke", 3);
+	std::this_thread::sleep_for(60ms);
+	worker.stop();
+
+	EXPECT_EQ(log.count("poke"), 3u);
+}
+
+TEST(CommandWorker, StepsCanScheduleTheNextStep)
+{
+	ActionLog log;
+	CommandWorker worker;
+	worker.start();
+
+	// Like keepRiftAlive: every step arms the one after it
+	CommandWorker::TimerId step = 0;
+	worker.post([&]
+	{
+		log.action("close")();
+		step = worker.schedule(10ms, [&]
+		{
+			log.action("launch")();
+			step = worker.schedule(10ms, [&]
+			{
+				log.action("check")();
+			});
+		});
+	});
+
+	log.wait_for("check");
+	worker.stop();
+	EXPECT_EQ(log.ran(), (std::vector<std::string>{"close", "launch", "check"}));
+}
+
+TEST(CommandWorker, StopDropsEverythingPendingAndWaitsOutTheRunningCommand)
+{
+	ActionLog log;
+	CommandWorker worker;
+	worker.start();
+
+	std::atomic<bool> running = false;
+	worker.post([&]
+	{
+		running = true;
+		std::this_thread::sleep_for(50ms);
+		log.action("slow")();
+	});
+	worker.post(log.action("queued"));
+	worker.schedule(10ms, log.action("timer"));
+
+	while (!running) std::this_thread::sleep_for(1ms);
+	worker.stop();
+
+	// The slow one finished, nothing after it started
+	EXPECT_EQ(log.ran(), (std::vector<std::string>{"slow"}));
+	EXPECT_EQ(worker.pending(), 0u);
+	EXPECT_FALSE(worker.running());
+}
+
+TEST(CommandWorker, RunsAgainAfterARestart)
+{
+	ActionLog log;
+	CommandWorker worker;
+	worker.start();
+	worker.post(log.action("first"));
+	log.wait_for("first");
+	worker.stop();
+
+	worker.start();
+	worker.schedule(10ms, log.action("second"));
+	log.wait_for("second");
+	worker.stop();
+
+	EXPECT_EQ(log.ran(), (std::vector<std::string>{"first", "second"}));
+}
+
+TEST(CommandWorker, SleepsUntilTheNextTimerIsDue)
+{
+	ActionLog log;
+	CommandWorker worker;
+	worker.start();
+
+	// The scan worker's 1 Hz timer: not a wakeup every tick in between
+	worker.schedule(1000ms, log.action("scan"), 1000ms);
+	std::this_thread::sleep_for(500ms);
+	EXPECT_LE(worker.wakeups(), 5u);
+
+	log.wait_for("scan");
+	worker.stop();
+	EXPECT_EQ(log.count("scan"), 1u);
+	EXPECT_LE(worker.wakeups(), 10u);
+}
+
+TEST(CommandWorker, SoonerTimersCutTheSleepShort)
+{
+	ActionLog log;
+	CommandWorker worker;
+	worker.start();
+
+	worker.schedule(5000ms, log.action("late"));
+	std::this_thread::sleep_for(20ms); // Asleep until the late one by now
+
+	const auto start = std::chrono::steady_clock::now();
+	worker.schedule(30ms, log.action("soon"));
+	log.wait_for("soon");
+	const auto took = std::chrono::steady_clock::now() - start;
+	worker.stop();
+
+	EXPECT_EQ(log.ran(), (std::vector<std::string>{"soon"}));
+	EXPECT_GE(took, 30ms);
+	EXPECT_LT(took, 1000ms);
+}
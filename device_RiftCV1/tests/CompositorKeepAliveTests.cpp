@@ -0,0 +1,135 @@
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "CompositorKeepAlive.h"
+
+namespace
+{
+	// Counts submissions, fails or pretends the compositor's paced on request
+	class FakeSubmitter : public IFrameSubmitter
+	{
+	public:
+		bool submit_frame() override
+		{
+			submitted_on = std::this_thread::get_id();
+			if (const auto block = block_for.load(); block.count() > 0)
+				std::this_thread::sleep_for(block);
+
+			calls++;
+			return !failing;
+		}
+
+		bool wants_frame() override
+		{
+			asked++;
+			return wanting;
+		}
+
+		std::atomic<uint64_t> calls = 0;
+		std::atomic<uint64_t> asked = 0;
+		std::atomic<bool> failing = false;
+		std::atomic<bool> wanting = true;
+		std::atomic<std::chrono::milliseconds> block_for{std::chrono::milliseconds(0)};
+		std::atomic<std::thread::id> submitted_on{};
+	};
+
+	void wait_for(const std::atomic<uint64_t>& counter, const uint64_t target)
+	{
+		const auto until = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+		while (counter < target && std::chrono::steady_clock::now() < until)
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+}
+
+TEST(CompositorKeepAlive, SubmitsAtTheRequestedRateOnItsOwnThread)
+{
+	FakeSubmitter submitter;
+	CompositorKeepAlive keep_alive;
+
+	const auto started = std::chrono::steady_clock::now();
+	keep_alive.start(&submitter, 100);
+	std::this_thread::sleep_for(std::chrono::milliseconds(300));
+	keep_alive.stop();
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+	// 100 Hz, with plenty of room for a loaded machine
+	EXPECT_GE(submitter.calls.load(), 10u);
+	EXPECT_LE(static_cast<double>(submitter.calls.load()), seconds * 100.0 + 2.0);
+	EXPECT_EQ(keep_alive.frames_submitted(), submitter.calls.load());
+	EXPECT_EQ(keep_alive.frames_failed(), 0u);
+	EXPECT_NE(submitter.submitted_on.load(), std::this_thread::get_id());
+}
+
+TEST(CompositorKeepAlive, CountsFailedSubmissions)
+{
+	FakeSubmitter submitter;
+	submitter.failing = true;
+
+	CompositorKeepAlive keep_alive;
+	keep_alive.start(&submitter, 200);
+	wait_for(submitter.calls, 5);
+	keep_alive.stop();
+
+	EXPECT_GE(keep_alive.frames_failed(), 5u);
+	EXPECT_EQ(keep_alive.frames_submitted(), 0u);
+}
+
+TEST(CompositorKeepAlive, OnDemandOnlySubmitsWhenAsked)
+{
+	FakeSubmitter submitter;
+	submitter.wanting = false;
+
+	CompositorKeepAlive keep_alive;
+	keep_alive.start(&submitter, 0);
+	wait_for(submitter.asked, 3);
+
+	// The first one always goes out (nothing was ever submitted), then nothing for a second
+	std::this_thread::sleep_for(std::chrono::milliseconds(300));
+	EXPECT_EQ(submitter.calls.load(), 1u);
+
+	submitter.wanting = true;
+	wait_for(submitter.calls, 3);
+	keep_alive.stop();
+	EXPECT_GE(submitter.calls.load(), 3u);
+}
+
+TEST(CompositorKeepAlive, BlockingSubmitsDontPileUp)
+{
+	FakeSubmitter submitter;
+	submitter.block_for = std::chrono::milliseconds(20); // 'vsync' way below the requested rate
+
+	CompositorKeepAlive keep_alive;
+	const auto started = std::chrono::steady_clock::now();
+	keep_alive.start(&submitter, 240);
+	std::this_thread::sleep_for(std::chrono::milliseconds(200));
+	keep_alive.stop();
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+	// No catching up in a burst: never more than the submitter lets through
+	EXPECT_LE(static_cast<double>(submitter.calls.load()), seconds / 0.02 + 1.0);
+	EXPECT_GE(submitter.calls.load(), 3u);
+}
+
+TEST(CompositorKeepAlive, StopWaitsForTheThreadAndCanRestart)
+{
+	FakeSubmitter submitter;
+	CompositorKeepAlive keep_alive;
+
+	keep_alive.start(&submitter, 100);
+	EXPECT_TRUE(keep_alive.running());
+	keep_alive.stop();
+	EXPECT_FALSE(keep_alive.running());
+
+	const uint64_t calls = submitter.calls;
+	std::this_thread::sleep_for(std::chrono::milliseconds(30));
+	EXPECT_EQ(submitter.calls.load(), calls);
+
+	keep_alive.start(&submitter, 100);
+	wait_for(submitter.calls, calls + 2);
+	keep_alive.stop();
+	EXPECT_GE(submitter.calls.load(), calls + 2);
+}
@@ -0,0 +1,209 @@
+#include <cmath>
+#include <cstdint>
+
+#include <gtest/gtest.h>
+
+#include "DeadReckoning.h"
+#include "ReckoningBenchmark.h"
+
+namespace
+{
+	constexpr uint32_t tracked = status_orientation_tracked | status_position_tracked;
+	constexpr double step = 0.001; // s per frame
+
+	// Both hands and one VR Object (slot 0) gliding along x at 1 m/s
+	// 'flags' is what the hands report, the object always keeps tracking
+	void scripted_frame(JointFrame& frame, const int n, const uint32_t flags)
+	{
+		frame = {};
+		frame.frameTime = n * step;
+		frame.jointCount = 3;
+		frame.objectMask = 1;
+		for (uint32_t i = 0; i < frame.jointCount; i++)
+		{
+			JointSample& sample = frame.joints[i];
+			sample.position[0] = static_cast<float>(n * step);
+			sample.position[1] = static_cast<float>(i);
+			sample.orientation[3] = 1.f;
+			sample.linearVelocity[0] = 1.f;
+			sample.sampleTime = frame.frameTime;
+			sample.statusFlags = i < 2 ? flags : tracked;
+		}
+	}
+
+	// Frames [from, to) through 'reckoning', the hands dropping out for [lost, back)
+	void run(DeadReckoning& reckoning, JointFrame& frame, const int from, const int to, const int lost, const int back)
+	{
+		for (int n = from; n < to; n++)
+		{
+			scripted_frame(frame, n, n >= lost && n < back ? 0 : tracked);
+			reckoning.apply(frame);
+		}
+	}
+}
+
+TEST(DeadReckoning, GoesThroughEveryPhaseOfADropout)
+{
+	DeadReckoning reckoning;
+	JointFrame frame;
+
+	run(reckoning, frame, 0, 100, 1000, 1000);
+	EXPECT_EQ(reckoning.phase(0), DeadReckoning::Phase_Tracked);
+
+	// Lost at 100: extrapolated and reported inferred while there's budget left
+	run(reckoning, frame, 100, 150, 100, 1000);
+	EXPECT_EQ(reckoning.phase(0), DeadReckoning::Phase_Reckoning);
+	EXPECT_EQ(frame.joints[0].statusFlags, status_orientation_tracked);
+	EXPECT_EQ(reckoning.phase(2), DeadReckoning::Phase_Tracked); // The object never lost it
+
+	// Past the budget: not tracked, holding still
+	const int expires = 99 + static_cast<int>(std::ceil(reckoning.settings.budget / step)) + 2;
+	run(reckoning, frame, 150, expires, 100, 1000);
+	EXPECT_EQ(reckoning.phase(0), DeadReckoning::Phase_Lost);
+	EXPECT_EQ(frame.joints[0].statusFlags, 0u);
+	const float held = frame.joints[0].position[0];
+	run(reckoning, frame, expires, expires + 20, 100, 1000);
+	EXPECT_EQ(frame.joints[0].position[0], held);
+
+	// Back: eases onto it, then it's tracked like nothing happened
+	const int back = expires + 20;
+	run(reckoning, frame, back, back + 10, 100, back);
+	EXPECT_EQ(reckoning.phase(0), DeadReckoning::Phase_Blending);
+	EXPECT_EQ(frame.joints[0].statusFlags, tracked);
+	run(reckoning, frame, back + 10, back + 10 + static_cast<int>(reckoning.settings.blendSeconds / step) + 2, 100, back);
+	EXPECT_EQ(reckoning.phase(0), DeadReckoning::Phase_Tracked);
+
+	scripted_frame(frame, 5000, tracked);
+	const float truth = frame.joints[0].position[0];
+	reckoning.apply(frame);
+	EXPECT_EQ(frame.joints[0].position[0], truth);
+
+	// Two hands: every count is per device
+	EXPECT_EQ(reckoning.stats().losses, 2u);
+	EXPECT_EQ(reckoning.stats().expired, 2u);
+	EXPECT_EQ(reckoning.stats().blended, 2u);
+}
+
+TEST(DeadReckoning, ExtrapolatesWithDampedVelocity)
+{
+	DeadReckoning reckoning;
+	const double T = reckoning.settings.damping;
+	JointFrame frame;
+	run(reckoning, frame, 0, 100, 1000, 1000);
+	const double last = frame.joints[0].position[0];
+
+	for (int n = 100; n < 150; n++)
+	{
+		scripted_frame(frame, n, 0);
+		const double truth = frame.joints[0].position[0];
+		reckoning.apply(frame);
+
+		// 1 m/s dying away with T: x0 + T (1 - e^(-t/T)), always closer than holding still
+		const double elapsed = (n - 99) * step;
+		const double expected = last + T * (1.0 - std::exp(-elapsed / T));
+		EXPECT_NEAR(frame.joints[0].position[0], expected, 1e-5);
+		EXPECT_LT(std::abs(frame.joints[0].position[0] - truth), std::abs(last - truth));
+		EXPECT_NEAR(frame.joints[0].linearVelocity[0], std::exp(-elapsed / T), 1e-5);
+		EXPECT_NEAR(frame.joints[0].sampleTime, 0.099 + elapsed, 1e-9);
+	}
+}
+
+TEST(DeadReckoning, BlendsBackWithoutAJump)
+{
+	DeadReckoning reckoning;
+	JointFrame frame;
+	run(reckoning, frame, 0, 200, 100, 1000);
+	const float out = frame.joints[0].position[0];
+
+	// Real pose is centimetres ahead by now, the first frame back barely moves
+	scripted_frame(frame, 200, tracked);
+	const float truth = frame.joints[0].position[0];
+	ASSERT_GT(truth - out, 0.02f);
+	reckoning.apply(frame);
+	EXPECT_NEAR(frame.joints[0].position[0], out, 0.002);
+
+	// Then closes in a bit more every frame, never past it
+	float previous_gap = truth - frame.joints[0].position[0];
+	for (int n = 201; reckoning.phase(0) == DeadReckoning::Phase_Blending && n < 1000; n++)
+	{
+		scripted_frame(frame, n, tracked);
+		const float real = frame.joints[0].position[0];
+		reckoning.apply(frame);
+		const float gap = real - frame.joints[0].position[0];
+		EXPECT_LE(gap, previous_gap + 1e-6f);
+		EXPECT_GE(gap, -1e-6f);
+		previous_gap = gap;
+	}
+	EXPECT_EQ(reckoning.phase(0), DeadReckoning::Phase_Tracked);
+}
+
+TEST(DeadReckoning, LongLossesSnapBack)
+{
+	DeadReckoning reckoning;
+	JointFrame frame;
+	const int back = 100 + static_cast<int>(reckoning.settings.blendWithin / step) + 10;
+	run(reckoning, frame, 0, back, 100, back);
+	ASSERT_EQ(reckoning.phase(0), DeadReckoning::Phase_Lost);
+
+	scripted_frame(frame, back, tracked);
+	const float truth = frame.joints[0].position[0];
+	reckoning.apply(frame);
+	EXPECT_EQ(reckoning.phase(0), DeadReckoning::Phase_Tracked);
+	EXPECT_EQ(frame.joints[0].position[0], truth);
+	EXPECT_EQ(reckoning.stats().blended, 0u);
+}
+
+TEST(DeadReckoning, KeepsTheImuOrientationWhilePositionIsLost)
+{
+	DeadReckoning reckoning;
+	JointFrame frame;
+	run(reckoning, frame, 0, 100, 1000, 1000);
+
+	// Touch lost the cameras, not its IMU
+	scripted_frame(frame, 100, status_orientation_tracked);
+	const Eigen::Quaternionf turned(Eigen::AngleAxisf(0.5f, Eigen::Vector3f::UnitY()));
+	Eigen::Map<Eigen::Quaternionf>(frame.joints[0].orientation) = turned;
+	reckoning.apply(frame);
+
+	EXPECT_EQ(reckoning.phase(0), DeadReckoning::Phase_Reckoning);
+	EXPECT_TRUE(Eigen::Map<const Eigen::Quaternionf>(frame.joints[0].orientation).isApprox(turned));
+}
+
+TEST(DeadReckoning, NoBudgetLeavesFramesAlone)
+{
+	DeadReckoning reckoning;
+	reckoning.settings.budget = 0.0;
+	JointFrame frame;
+	run(reckoning, frame, 0, 150, 100, 1000);
+
+	EXPECT_EQ(reckoning.phase(0), DeadReckoning::Phase_Tracked);
+	EXPECT_EQ(frame.joints[0].statusFlags, 0u);
+	EXPECT_EQ(frame.joints[0].position[0], static_cast<float>(149 * step));
+	EXPECT_EQ(reckoning.stats().losses, 0u);
+}
+
+TEST(DeadReckoning, NothingToExtrapolateFromBeforeTheFirstGoodSample)
+{
+	DeadReckoning reckoning;
+	JointFrame frame;
+	run(reckoning, frame, 0, 50, 0, 50);
+
+	EXPECT_EQ(reckoning.phase(0), DeadReckoning::Phase_Tracked);
+	EXPECT_EQ(frame.joints[0].statusFlags, 0u);
+	EXPECT_EQ(reckoning.stats().losses, 0u);
+}
+
+TEST(DeadReckoning, BeatsHoldingStillOnSimulatedDropouts)
+{
+	const ReckoningBenchmarkResult result = benchmark_dead_reckoning(5.0);
+	EXPECT_GT(result.losses, 0u);
+	EXPECT_GT(result.expired, 0u);
+
+	// However far into a loss, closer than holding the last good pose
+	for (int s = 0; s < ReckoningBenchmarkResult::spans; s++)
+	{
+		EXPECT_GT(result.heldMm[s], 0.0) << s;
+		EXPECT_LT(result.reckonedMm[s], result.heldMm[s]) << s;
+	}
+	EXPECT_LT(result.blendStepMm, result.snapMm);
+}
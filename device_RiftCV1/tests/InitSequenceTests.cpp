@@ -0,0 +1,252 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "InitSequence.h"
+
+namespace
+{
+	using namespace std::chrono_literals;
+
+	// Stands in for the start-up steps: every stage notes down that it ran, and where
+	class StageLog
+	{
+	public:
+		std::function<bool()> stage(std::string name, const bool succeeds = true)
+		{
+			return [this, name = std::move(name), succeeds]
+			{
+				std::lock_guard lock(mMutex);
+				mRan.push_back(name);
+				mThreads[name] = std::this_thread::get_id();
+				return succeeds;
+			};
+		}
+
+		[[nodiscard]] std::vector<std::string> ran() const
+		{
+			std::lock_guard lock(mMutex);
+			return mRan;
+		}
+
+		[[nodiscard]] bool ran(const std::string& name) const
+		{
+			std::lock_guard lock(mMutex);
+			return std::find(mRan.begin(), mRan.end(), name) != mRan.end();
+		}
+
+		[[nodiscard]] size_t position(const std::string& name) const
+		{
+			std::lock_guard lock(mMutex);
+			return std::find(mRan.begin(), mRan.end(), name) - mRan.begin();
+		}
+
+		[[nodiscard]] std::thread::id thread(const std::string& name) const
+		{
+			std::lock_guard lock(mMutex);
+			return mThreads.at(name);
+		}
+
+	private:
+		mutable std::mutex mMutex;
+		std::vector<std::string> mRan;
+		std::map<std::string, std::thread::id> mThreads;
+	};
+
+	// Until 'done' says so, or a few seconds went by
+	template <class Done>
+	bool wait_until(Done done)
+	{
+		const auto until = std::chrono::steady_clock::now() + 5s;
+		while (!done() && std::chrono::steady_clock::now() < until)
+			std::this_thread::sleep_for(1ms);
+		return done();
+	}
+}
+
+TEST(InitSequence, StagesRunAfterWhatTheyDependOn)
+{
+	StageLog log;
+	InitSequence sequence;
+	const auto runtime = sequence.add(L"runtime", log.stage("runtime"));
+	const auto window = sequence.add(L"window", log.stage("window"));
+	const auto device = sequence.add(L"device", log.stage("device"), {runtime, window});
+	sequence.add(L"targets", log.stage("targets"), {device});
+	sequence.add(L"objects", log.stage("objects"), {runtime});
+
+	sequence.start();
+	sequence.wait();
+
+	EXPECT_EQ(sequence.state(), InitSequence::Init_Succeeded);
+	EXPECT_EQ(sequence.progress(), 100);
+	ASSERT_EQ(log.ran().size(), 5u);
+	EXPECT_LT(log.position("runtime"), log.position("device"));
+	EXPECT_LT(log.position("window"), log.position("device"));
+	EXPECT_LT(log.position("device"), log.position("targets"));
+	EXPECT_LT(log.position("runtime"), log.position("objects"));
+
+	// All of them timed, in the order they were added
+	const auto timings = sequence.timings();
+	ASSERT_EQ(timings.size(), 5u);
+	EXPECT_EQ(timings[2].name, L"device");
+	for (const auto& timing : timings)
+		EXPECT_TRUE(timing.succeeded);
+	EXPECT_TRUE(sequence.failed_stages().empty());
+}
+
+TEST(InitSequence, IndependentStagesRunAtTheSameTime)
+{
+	// Each one waits for the other to have started: only done if they overlap
+	std::atomic<int> started = 0;
+	const auto meet = [&started]
+	{
+		++started;
+		return wait_until([&started] { return started == 2; });
+	};
+
+	InitSequence sequence;
+	sequence.add(L"runtime", meet);
+	sequence.add(L"ODT lookup", meet);
+	sequence.start();
+	sequence.wait();
+
+	EXPECT_EQ(sequence.state(), InitSequence::Init_Succeeded);
+}
+
+TEST(InitSequence, PinnedStagesRunOnTheHomeThread)
+{
+	StageLog log;
+	InitSequence sequence;
+	std::atomic<std::thread::id> idle_thread;
+	std::atomic<int> idled = 0;
+	sequence.idle = [&]
+	{
+		idle_thread = std::this_thread::get_id();
+		++idled;
+	};
+	sequence.idle_interval = 1ms;
+
+	const auto window = sequence.add(L"window", log.stage("window"), {}, true);
+	const auto device = sequence.add(L"device", log.stage("device"), {window});
+	sequence.add(L"targets", log.stage("targets"), {device}, true);
+	sequence.start();
+	sequence.wait();
+
+	// Both on the same thread, neither the caller's nor the helper the other stage got
+	ASSERT_EQ(sequence.state(), InitSequence::Init_Succeeded);
+	EXPECT_EQ(log.thread("window"), log.thread("targets"));
+	EXPECT_NE(log.thread("window"), std::this_thread::get_id());
+	EXPECT_NE(log.thread("window"), log.thread("device"));
+
+	// Still up and pumping afterwards, for whatever the window needs
+	const int before = idled;
+	EXPECT_TRUE(wait_until([&] { return idled > before + 2; }));
+	EXPECT_EQ(idle_thread.load(), log.thread("window"));
+
+	sequence.stop();
+	const int stopped = idled;
+	std::this_thread::sleep_for(20ms);
+	EXPECT_EQ(idled, stopped);
+}
+
+TEST(InitSequence, AFailedStageStopsWhatDependsOnIt)
+{
+	StageLog log;
+	InitSequence sequence;
+	const auto runtime = sequence.add(L"runtime", log.stage("runtime", false));
+	sequence.add(L"device", log.stage("device"), {runtime});
+	const auto odt = sequence.add(L"ODT lookup", [] () -> bool { throw std::runtime_error("no ODT"); });
+	sequence.add(L"objects", log.stage("objects"), {odt});
+
+	sequence.start();
+	sequence.wait();
+
+	// Thrown is failed too
+	EXPECT_EQ(sequence.state(), InitSequence::Init_Failed);
+	EXPECT_EQ(sequence.failed_stages(), L"runtime, ODT lookup");
+	EXPECT_FALSE(log.ran("device"));
+	EXPECT_FALSE(log.ran("objects"));
+	EXPECT_EQ(sequence.progress(), 50);
+
+	const auto timings = sequence.timings();
+	ASSERT_EQ(timings.size(), 2u);
+	EXPECT_FALSE(timings[0].succeeded);
+	EXPECT_FALSE(timings[1].succeeded);
+}
+
+TEST(InitSequence, NothingNewStartsOnceSomethingFailed)
+{
+	StageLog log;
+	InitSequence sequence;
+	std::atomic<bool> failed = false;
+
+	// 'device' doesn't depend on 'runtime', but only gets ready after it failed
+	const auto slow = sequence.add(L"slow", [&failed] { return wait_until([&failed] { return failed.load(); }); });
+	sequence.add(L"runtime", [&failed] { failed = true; return false; });
+	sequence.add(L"device", log.stage("device"), {slow});
+
+	sequence.start();
+	sequence.wait();
+
+	EXPECT_EQ(sequence.state(), InitSequence::Init_Failed);
+	EXPECT_FALSE(log.ran("device"));
+}
+
+TEST(InitSequence, CancelLetsRunningStagesFinish)
+{
+	StageLog log;
+	InitSequence sequence;
+	std::atomic<bool> running = false, release = false, saw_cancel = false;
+
+	const auto runtime = sequence.add(L"runtime", [&]
+	{
+		running = true;
+		wait_until([&release] { return release.load(); });
+		saw_cancel = sequence.cancelled();
+		return true;
+	});
+	sequence.add(L"device", log.stage("device"), {runtime});
+	sequence.start();
+
+	ASSERT_TRUE(wait_until([&running] { return running.load(); }));
+	EXPECT_EQ(sequence.running_stages(), L"runtime");
+	sequence.cancel();
+	release = true;
+	sequence.wait();
+
+	// It got to know, and what came after it never ran
+	EXPECT_EQ(sequence.state(), InitSequence::Init_Cancelled);
+	EXPECT_TRUE(saw_cancel);
+	EXPECT_FALSE(log.ran("device"));
+	ASSERT_EQ(sequence.timings().size(), 1u);
+	EXPECT_TRUE(sequence.timings()[0].succeeded);
+}
+
+TEST(InitSequence, StartsOverFromScratch)
+{
+	StageLog log;
+	InitSequence sequence;
+	const auto runtime = sequence.add(L"runtime", log.stage("runtime"));
+	sequence.add(L"device", log.stage("device"), {runtime});
+
+	sequence.start();
+	sequence.cancel(); // Maybe before anything ran, maybe after
+	sequence.wait();
+
+	sequence.start();
+	sequence.wait();
+	EXPECT_EQ(sequence.state(), InitSequence::Init_Succeeded);
+	EXPECT_EQ(sequence.timings().size(), 2u);
+
+	sequence.clear();
+	EXPECT_EQ(sequence.state(), InitSequence::Init_Idle);
+	EXPECT_EQ(sequence.progress(), 0);
+}
@@ -0,0 +1,141 @@
+#include <cmath>
+#include <cstdint>
+
+#include <gtest/gtest.h>
+
+#include "JointBatch.h"
+#include "SimulatedPoseSource.h"
+
+namespace
+{
+	// What update_joints_scalar() hands K2TrackedJoint::update() for a sample, the reference
+	struct ScalarJoint
+	{
+		Eigen::Vector3d position, linearVelocity, linearAcceleration, angularVelocity, angularAcceleration;
+		Eigen::Quaterniond orientation;
+	};
+
+	ScalarJoint update_scalar(const JointSample& pose)
+	{
+		return {
+			{pose.position[0], pose.position[1], pose.position[2]},
+			{pose.linearVelocity[0], pose.linearVelocity[1], pose.linearVelocity[2]},
+			{pose.linearAcceleration[0], pose.linearAcceleration[1], pose.linearAcceleration[2]},
+			{pose.angularVelocity[0], pose.angularVelocity[1], pose.angularVelocity[2]},
+			{pose.angularAcceleration[0], pose.angularAcceleration[1], pose.angularAcceleration[2]},
+			{pose.orientation[3], pose.orientation[0], pose.orientation[1], pose.orientation[2]}
+		};
+	}
+
+	Eigen::Vector3d channel(const JointBatch::Pose& pose, const int first)
+	{
+		return {pose[first], pose[first + 1], pose[first + 2]};
+	}
+
+	Eigen::Quaterniond orientation(const JointBatch::Pose& pose)
+	{
+		return {pose[JointBatch::Orientation + 3], pose[JointBatch::Orientation],
+		        pose[JointBatch::Orientation + 1], pose[JointBatch::Orientation + 2]};
+	}
+}
+
+TEST(JointBatch, MatchesTheScalarUpdate)
+{
+	SimulationSettings settings;
+	settings.objects = max_frame_joints - 2;
+	settings.orbitSpeed = 3.0;
+	settings.spinSpeed = 3.0;
+	SimulatedPoseSource source(settings);
+	source.set_fixed_step(0.002);
+
+	JointBatch batch;
+	JointFrame frame;
+	for (int n = 0; n < 200; n++)
+	{
+		acquire_frame(source, frame, 0.0, first_object_slots(settings.objects));
+
+		uint32_t written = 0;
+		batch.convert(frame, [&](const uint32_t i, const JointBatch::Pose& pose)
+		{
+			ASSERT_EQ(i, written++);
+			const ScalarJoint scalar = update_scalar(frame.joints[i]);
+
+			// Same widening, so exactly the same numbers
+			EXPECT_EQ(channel(pose, JointBatch::Position), scalar.position) << i;
+			EXPECT_EQ(channel(pose, JointBatch::LinearVelocity), scalar.linearVelocity) << i;
+			EXPECT_EQ(channel(pose, JointBatch::LinearAcceleration), scalar.linearAcceleration) << i;
+			EXPECT_EQ(channel(pose, JointBatch::AngularVelocity), scalar.angularVelocity) << i;
+			EXPECT_EQ(channel(pose, JointBatch::AngularAcceleration), scalar.angularAcceleration) << i;
+
+			// Same rotation, normalized, either sign
+			EXPECT_NEAR(orientation(pose).norm(), 1.0, 1e-12) << i;
+			EXPECT_NEAR(std::abs(orientation(pose).dot(scalar.orientation.normalized())), 1.0, 1e-12) << i;
+		});
+		EXPECT_EQ(written, frame.jointCount);
+	}
+}
+
+TEST(JointBatch, KeepsEveryJointOnOneHemisphere)
+{
+	JointFrame frame;
+	frame.jointCount = 2;
+
+	JointBatch batch;
+	double last[2] = {};
+	for (int n = 0; n < 20; n++)
+	{
+		// Joint 0 flips sign every frame, joint 1 never does
+		const float sign = n % 2 ? -1.f : 1.f;
+		frame.joints[0].orientation[1] = sign * 0.6f;
+		frame.joints[0].orientation[3] = sign * 0.8f;
+		frame.joints[1].orientation[3] = 1.f;
+
+		batch.convert(frame, [&](const uint32_t i, const JointBatch::Pose& pose)
+		{
+			if (n > 0)
+			{
+				EXPECT_GT(pose[JointBatch::Orientation + 3] * last[i], 0.0) << n;
+			}
+			last[i] = pose[JointBatch::Orientation + 3];
+		});
+	}
+	EXPECT_GT(last[0], 0.0);
+}
+
+TEST(JointBatch, UnsetOrientationsBecomeIdentity)
+{
+	JointFrame frame;
+	frame.jointCount = 1;
+	for (int c = 0; c < 4; c++)
+		frame.joints[0].orientation[c] = 0.f;
+
+	JointBatch batch;
+	batch.convert(frame, [&](uint32_t, const JointBatch::Pose& pose)
+	{
+		EXPECT_TRUE(orientation(pose).isApprox(Eigen::Quaterniond::Identity()));
+	});
+}
+
+TEST(JointBatch, ForgetsOrientationsWhenJointsMoveAround)
+{
+	JointFrame frame;
+	frame.jointCount = 3;
+	frame.objectMask = 1;
+	frame.joints[2].orientation[1] = 0.6f;
+	frame.joints[2].orientation[3] = 0.8f;
+
+	JointBatch batch;
+	batch.convert(frame, [](uint32_t, const JointBatch::Pose&) {});
+
+	// Slot 1's object now: lined up with identity like any first pose, not with slot 0's last one
+	frame.objectMask = 2;
+	frame.joints[2].orientation[1] = 0.96f;
+	frame.joints[2].orientation[3] = -0.28f;
+	batch.convert(frame, [&](const uint32_t i, const JointBatch::Pose& pose)
+	{
+		if (i == 2)
+		{
+			EXPECT_NEAR(pose[JointBatch::Orientation + 3], 0.28, 1e-6);
+		}
+	});
+}
@@ -0,0 +1,125 @@
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "KeepAliveTargets.h"
+
+namespace
+{
+	// Records what was asked of it, fails on request
+	class FakeGraphics : public IKeepAliveGraphics
+	{
+	public:
+		struct Call
+		{
+			int eye, width, height;
+		};
+
+		int create_color_chain(const int eye, const int width, const int height) override
+		{
+			colorCalls.push_back({eye, width, height});
+			return failColor ? 0 : textures;
+		}
+
+		bool create_depth_target(const int eye, const int width, const int height) override
+		{
+			depthCalls.push_back({eye, width, height});
+			return !failDepth;
+		}
+
+		int textures = 3;
+		bool failColor = false;
+		bool failDepth = false;
+		std::vector<Call> colorCalls;
+		std::vector<Call> depthCalls;
+	};
+
+	constexpr int ideal_sizes[KeepAliveTargets::eye_count][2] = {{1344, 1600}, {1344, 1600}};
+}
+
+TEST(KeepAliveTargets, FullSizeTargetsGetColorAndDepth)
+{
+	FakeGraphics graphics;
+	KeepAliveTargets targets;
+	ASSERT_TRUE(targets.create(graphics, ideal_sizes, false));
+
+	ASSERT_EQ(graphics.colorCalls.size(), 2u);
+	ASSERT_EQ(graphics.depthCalls.size(), 2u);
+	for (int eye = 0; eye < KeepAliveTargets::eye_count; eye++)
+	{
+		EXPECT_EQ(graphics.colorCalls[eye].eye, eye);
+		EXPECT_EQ(graphics.colorCalls[eye].width, 1344);
+		EXPECT_EQ(graphics.colorCalls[eye].height, 1600);
+		EXPECT_EQ(targets.eye(eye).textureCount, 3);
+		EXPECT_TRUE(targets.eye(eye).hasDepth);
+	}
+
+	EXPECT_FALSE(targets.headless());
+	EXPECT_TRUE(targets.needs_clear());
+
+	// 3 colour textures + depth per eye, 4 bytes a pixel each
+	const uint64_t pixels = 1344ull * 1600;
+	EXPECT_EQ(targets.allocated_bytes(), 2 * pixels * (3 * 4 + 4));
+}
+
+TEST(KeepAliveTargets, HeadlessUsesTinyChainsWithoutDepth)
+{
+	FakeGraphics graphics;
+	KeepAliveTargets targets;
+	ASSERT_TRUE(targets.create(graphics, ideal_sizes, true));
+
+	ASSERT_EQ(graphics.colorCalls.size(), 2u);
+	EXPECT_TRUE(graphics.depthCalls.empty());
+	for (const FakeGraphics::Call& call : graphics.colorCalls)
+	{
+		EXPECT_EQ(call.width, KeepAliveTargets::headless_size);
+		EXPECT_EQ(call.height, KeepAliveTargets::headless_size);
+	}
+
+	EXPECT_TRUE(targets.headless());
+	EXPECT_FALSE(targets.needs_clear());
+
+	const uint64_t pixels = KeepAliveTargets::headless_size * KeepAliveTargets::headless_size;
+	EXPECT_EQ(targets.allocated_bytes(), 2 * pixels * 3 * 4);
+
+	// Orders of magnitude below the full-size targets
+	FakeGraphics full_graphics;
+	KeepAliveTargets full;
+	ASSERT_TRUE(full.create(full_graphics, ideal_sizes, false));
+	EXPECT_LT(targets.allocated_bytes() * 1000, full.allocated_bytes());
+}
+
+TEST(KeepAliveTargets, FailedColorChainFails)
+{
+	FakeGraphics graphics;
+	graphics.failColor = true;
+
+	KeepAliveTargets targets;
+	EXPECT_FALSE(targets.create(graphics, ideal_sizes, true));
+	EXPECT_EQ(targets.allocated_bytes(), 0u);
+}
+
+TEST(KeepAliveTargets, FailedDepthOnlyMattersWhenItsWanted)
+{
+	FakeGraphics graphics;
+	graphics.failDepth = true;
+
+	KeepAliveTargets targets;
+	EXPECT_FALSE(targets.create(graphics, ideal_sizes, false));
+	EXPECT_FALSE(targets.eye(0).hasDepth);
+
+	FakeGraphics headless_graphics;
+	headless_graphics.failDepth = true;
+	EXPECT_TRUE(targets.create(headless_graphics, ideal_sizes, true));
+}
+
+TEST(KeepAliveTargets, RecreatingStartsTheCountOver)
+{
+	FakeGraphics graphics;
+	KeepAliveTargets targets;
+	ASSERT_TRUE(targets.create(graphics, ideal_sizes, false));
+	ASSERT_TRUE(targets.create(graphics, ideal_sizes, true));
+
+	const uint64_t pixels = KeepAliveTargets::headless_size * KeepAliveTargets::headless_size;
+	EXPECT_EQ(targets.allocated_bytes(), 2 * pixels * 3 * 4);
+}
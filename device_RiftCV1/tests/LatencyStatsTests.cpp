@@ -0,0 +1,212 @@
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "LatencyStats.h"
+
+namespace
+{
+	// One in 16 at most: the bucket's upper bound, never below the value
+	void expect_bucket_bound(const uint64_t bound, const uint64_t value)
+	{
+		EXPECT_GE(bound, value);
+		EXPECT_LE(bound, value + value / LatencyHistogram::sub_buckets) << value;
+	}
+
+	// A counters file of its own per test, gone afterwards
+	class LatencyStatsTest : public testing::Test
+	{
+	protected:
+		void SetUp() override
+		{
+			path = std::filesystem::temp_directory_path() / (std::string("riftcv1_") +
+				testing::UnitTest::GetInstance()->current_test_info()->name() + ".cv1stats");
+		}
+
+		void TearDown() override
+		{
+			std::error_code error;
+			std::filesystem::remove(path, error);
+		}
+
+		std::filesystem::path path;
+	};
+}
+
+TEST(LatencyHistogram, EmptyIsAllZero)
+{
+	const auto histogram = std::make_unique<LatencyHistogram>();
+	EXPECT_EQ(histogram->count(), 0u);
+	EXPECT_EQ(histogram->peak(), 0u);
+	EXPECT_EQ(histogram->percentile(0.5), 0u);
+}
+
+TEST(LatencyHistogram, SmallValuesAreExact)
+{
+	// Below 2 x sub_buckets every value has a bucket of its own
+	for (uint64_t value = 0; value < 2 * LatencyHistogram::sub_buckets; value++)
+	{
+		LatencyHistogram histogram;
+		histogram.record(value);
+		EXPECT_EQ(histogram.percentile(0.5), value);
+	}
+}
+
+TEST(LatencyHistogram, PercentilesWithinABucket)
+{
+	LatencyHistogram histogram;
+	for (uint64_t value = 1000; value >= 1; value--)
+		histogram.record(value);
+
+	EXPECT_EQ(histogram.count(), 1000u);
+	EXPECT_EQ(histogram.peak(), 1000u);
+	expect_bucket_bound(histogram.percentile(0.50), 500);
+	expect_bucket_bound(histogram.percentile(0.90), 900);
+	expect_bucket_bound(histogram.percentile(0.99), 990);
+	EXPECT_EQ(histogram.percentile(0.0), 1u);
+
+	// Never past the largest value seen, even if its bucket goes further
+	EXPECT_EQ(histogram.percentile(1.0), 1000u);
+}
+
+TEST(LatencyHistogram, LargeValuesKeepTheirResolution)
+{
+	for (const uint64_t value : {12'345ull, 1'000'000ull, 987'654'321ull, 1ull << 38})
+	{
+		LatencyHistogram histogram;
+		histogram.record(value);
+		histogram.record(value / 2);
+
+		// The bucket of the larger value, clamped to it
+		EXPECT_EQ(histogram.percentile(1.0), value);
+		expect_bucket_bound(histogram.percentile(0.0), value / 2);
+	}
+}
+
+TEST(LatencyHistogram, PastTheLastMagnitudeIsTheLastBucket)
+{
+	LatencyHistogram histogram;
+	const uint64_t huge = ~0ull;
+	histogram.record(huge);
+	histogram.record(1);
+
+	EXPECT_EQ(histogram.peak(), huge);
+	EXPECT_EQ(histogram.percentile(1.0), huge);
+	EXPECT_EQ(histogram.percentile(0.0), 1u);
+}
+
+TEST(LatencyHistogram, ResetForgetsEverything)
+{
+	LatencyHistogram histogram;
+	histogram.record(500);
+	histogram.record(70'000);
+	histogram.reset();
+
+	EXPECT_EQ(histogram.count(), 0u);
+	EXPECT_EQ(histogram.peak(), 0u);
+	EXPECT_EQ(histogram.percentile(0.99), 0u);
+
+	histogram.record(20);
+	EXPECT_EQ(histogram.percentile(0.99), 20u);
+}
+
+TEST(LatencyHistogram, RecordsFromManyThreads)
+{
+	LatencyHistogram histogram;
+	constexpr int threads = 4;
+	constexpr uint64_t per_thread = 20'000;
+
+	std::vector<std::thread> recorders;
+	for (int t = 0; t < threads; t++)
+		recorders.emplace_back([&histogram, t]
+		{
+			for (uint64_t n = 0; n < per_thread; n++)
+				histogram.record(n * threads + t);
+		});
+	for (auto& recorder : recorders)
+		recorder.join();
+
+	// Nothing lost, and the peak from whichever thread had it
+	const uint64_t total = threads * per_thread;
+	EXPECT_EQ(histogram.count(), total);
+	EXPECT_EQ(histogram.peak(), total - 1);
+	expect_bucket_bound(histogram.percentile(0.5), total / 2);
+}
+
+TEST(LatencyStats, EveryStageHasAName)
+{
+	for (int i = 0; i < Stage_Count; i++)
+	{
+		ASSERT_NE(latency_stage_name(i), nullptr);
+		EXPECT_GT(std::strlen(latency_stage_name(i)), 0u);
+		EXPECT_LT(std::strlen(latency_stage_name(i)), sizeof(LatencyCountersStage::name));
+		for (int j = 0; j < i; j++)
+			EXPECT_STRNE(latency_stage_name(i), latency_stage_name(j));
+	}
+}
+
+TEST(LatencyStats, RecordsDurationsPerStage)
+{
+	const auto stats = std::make_unique<LatencyStats>();
+	const LatencyStats::clock::time_point start{};
+	stats->record(Stage_JointUpdate, start, start + std::chrono::microseconds(3));
+
+	EXPECT_EQ((*stats)[Stage_JointUpdate].count(), 1u);
+	EXPECT_EQ((*stats)[Stage_JointUpdate].peak(), 3000u);
+	EXPECT_EQ((*stats)[Stage_Export].count(), 0u);
+
+	stats->reset();
+	EXPECT_EQ((*stats)[Stage_JointUpdate].count(), 0u);
+}
+
+TEST_F(LatencyStatsTest, NothingPublishedWithoutAnExport)
+{
+	const auto stats = std::make_unique<LatencyStats>();
+	(*stats)[Stage_Update].record(100);
+	stats->publish(1);
+	EXPECT_FALSE(std::filesystem::exists(path));
+}
+
+TEST_F(LatencyStatsTest, PublishesTheCountersFile)
+{
+	const auto stats = std::make_unique<LatencyStats>();
+	ASSERT_TRUE(stats->open_export(path));
+	for (uint64_t value = 1; value <= 100; value++)
+		(*stats)[Stage_Update].record(value * 1000);
+	(*stats)[Stage_Submit].record(42);
+	stats->publish(123456);
+	stats->close_export();
+
+	// What a dashboard would read
+	LatencyCountersHeader header;
+	LatencyCountersStage stages[Stage_Count];
+	std::ifstream input(path, std::ios::binary);
+	input.read(reinterpret_cast<char*>(&header), sizeof(header));
+	input.read(reinterpret_cast<char*>(stages), sizeof(stages));
+	ASSERT_TRUE(input);
+
+	EXPECT_EQ(std::memcmp(header.magic, "CV1STATS", 8), 0);
+	EXPECT_EQ(header.stageCount, static_cast<uint32_t>(Stage_Count));
+	EXPECT_EQ(header.generation, 2u); // Even: nobody writing
+	EXPECT_EQ(header.updatedAt, 123456);
+
+	for (int i = 0; i < Stage_Count; i++)
+		EXPECT_STREQ(stages[i].name, latency_stage_name(i));
+
+	const LatencyCountersStage& update = stages[Stage_Update];
+	EXPECT_EQ(update.count, 100u);
+	EXPECT_EQ(update.max, 100'000u);
+	expect_bucket_bound(update.p50, 50'000);
+	expect_bucket_bound(update.p99, 99'000);
+
+	EXPECT_EQ(stages[Stage_Submit].count, 1u);
+	EXPECT_EQ(stages[Stage_Submit].p99, 42u);
+	EXPECT_EQ(stages[Stage_Interval].count, 0u);
+}
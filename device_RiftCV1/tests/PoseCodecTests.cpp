@@ -0,0 +1,258 @@
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "PoseCodec.h"
+#include "PoseStream.h"
+#include "SimulatedPoseSource.h"
+
+namespace
+{
+	struct Datagram
+	{
+		std::vector<uint8_t> bytes;
+		JointFrame frame; // What went in
+	};
+
+	// Frames from a steady simulation, each encoded the moment it's taken
+	std::vector<Datagram> encode_frames(PoseEncoder& encoder, const int frames, const uint32_t objects = 3)
+	{
+		SimulationSettings settings;
+		settings.objects = objects;
+		settings.dropoutEvery = 0.0;
+		SimulatedPoseSource source(settings);
+		source.set_fixed_step(0.002);
+
+		std::vector<Datagram> out(frames);
+		for (int n = 0; n < frames; n++)
+		{
+			acquire_frame(source, out[n].frame, 0.0, source.connected_objects());
+			out[n].bytes.resize(pose_codec::max_bytes);
+			out[n].bytes.resize(encoder.encode(out[n].frame, 1000 + n, out[n].bytes.data(), out[n].bytes.size()));
+		}
+		return out;
+	}
+
+	bool keyframe(const Datagram& datagram) { return datagram.bytes[3] & pose_codec::flag_keyframe; }
+
+	// Within what the wire format keeps of each field
+	void expect_close(const JointFrame& decoded, const JointFrame& original, const bool velocities)
+	{
+		ASSERT_EQ(decoded.jointCount, original.jointCount);
+		EXPECT_EQ(decoded.objectMask, original.objectMask);
+		EXPECT_EQ(decoded.frameTime, original.frameTime);
+
+		for (uint32_t i = 0; i < decoded.jointCount; i++)
+		{
+			const JointSample& a = decoded.joints[i];
+			const JointSample& b = original.joints[i];
+			EXPECT_EQ(a.statusFlags, b.statusFlags);
+			EXPECT_NEAR(a.sampleTime, b.sampleTime, 0.5 / pose_codec::time_scale + 1e-9);
+
+			double dot = 0.0;
+			for (int c = 0; c < 4; c++) dot += a.orientation[c] * b.orientation[c];
+			EXPECT_GT(std::abs(dot), 0.99999); // Either sign is the same rotation
+
+			for (int c = 0; c < 3; c++)
+			{
+				EXPECT_NEAR(a.position[c], b.position[c], 0.5 / pose_codec::position_scale + 1e-6);
+				EXPECT_NEAR(a.linearVelocity[c], velocities ? b.linearVelocity[c] : 0.f, 0.5e-3 + 1e-5);
+				EXPECT_NEAR(a.angularVelocity[c], velocities ? b.angularVelocity[c] : 0.f, 0.5e-3 + 1e-5);
+				EXPECT_EQ(a.linearAcceleration[c], 0.f);
+			}
+		}
+	}
+}
+
+TEST(PoseCodec, QuantizeSaturatesAndDropsNonFinite)
+{
+	using pose_codec::quantize;
+	EXPECT_EQ(quantize<int16_t>(std::numeric_limits<double>::quiet_NaN(), 2048.0), 0);
+	EXPECT_EQ(quantize<int16_t>(std::numeric_limits<double>::infinity(), 2048.0), 0);
+	EXPECT_EQ(quantize<int32_t>(-std::numeric_limits<double>::infinity(), 1000.0), 0);
+
+	EXPECT_EQ(quantize<int16_t>(100.0, 2048.0), std::numeric_limits<int16_t>::max());
+	EXPECT_EQ(quantize<int16_t>(-100.0, 2048.0), std::numeric_limits<int16_t>::min());
+	EXPECT_EQ(quantize<int32_t>(1e30, 1000.0), std::numeric_limits<int32_t>::max());
+	EXPECT_EQ(quantize<int32_t>(-1e30, 1000.0), std::numeric_limits<int32_t>::min());
+
+	EXPECT_EQ(quantize<int16_t>(0.25, 10.0), 3);
+	EXPECT_EQ(quantize<int16_t>(-0.25, 10.0), -3);
+	EXPECT_EQ(quantize<int16_t>(0.24, 10.0), 2);
+}
+
+TEST(PoseCodec, VelocityDeltasWrapTheSameBothWays)
+{
+	using namespace pose_codec;
+	const int32_t values[] = {0, 1, -1, std::numeric_limits<int32_t>::max(), std::numeric_limits<int32_t>::min()};
+	for (const int32_t a : values)
+		for (const int32_t b : values)
+			EXPECT_EQ(wrapping_add(b, unzigzag(zigzag(wrapping_sub(a, b)))), a);
+}
+
+TEST(PoseCodec, RoundTripsWithinQuantization)
+{
+	PoseEncoder encoder;
+	PoseDecoder decoder;
+	const std::vector<Datagram> datagrams = encode_frames(encoder, 40);
+
+	JointFrame frame;
+	long long timestamp = 0;
+	for (size_t n = 0; n < datagrams.size(); n++)
+	{
+		ASSERT_FALSE(datagrams[n].bytes.empty());
+		EXPECT_LE(datagrams[n].bytes.size(), pose_codec::max_bytes);
+
+		// First one and every keyframeInterval-th, velocities as deltas in between
+		EXPECT_EQ(keyframe(datagrams[n]), n == 0 || (n + 1) % encoder.keyframeInterval == 0);
+
+		ASSERT_EQ(decoder.decode(datagrams[n].bytes.data(), datagrams[n].bytes.size(), frame, timestamp),
+		          PoseDecoder::Decode_Ok);
+		EXPECT_EQ(frame.sequence, n + 1);
+		EXPECT_EQ(timestamp, 1000 + static_cast<long long>(n));
+		expect_close(frame, datagrams[n].frame, true);
+	}
+}
+
+TEST(PoseCodec, ALostDatagramOnlyCostsVelocitiesUntilTheNextKeyframe)
+{
+	PoseEncoder encoder;
+	PoseDecoder decoder;
+	const std::vector<Datagram> datagrams = encode_frames(encoder, 20);
+	ASSERT_FALSE(keyframe(datagrams[5]));
+	ASSERT_TRUE(keyframe(datagrams[15]));
+
+	JointFrame frame;
+	long long timestamp = 0;
+	for (size_t n = 0; n < datagrams.size(); n++)
+	{
+		if (n == 5) continue; // Lost on the way
+
+		const PoseDecoder::Result result =
+			decoder.decode(datagrams[n].bytes.data(), datagrams[n].bytes.size(), frame, timestamp);
+		const bool missing = n > 5 && n < 15;
+		EXPECT_EQ(result, missing ? PoseDecoder::Decode_NoVelocities : PoseDecoder::Decode_Ok) << n;
+		expect_close(frame, datagrams[n].frame, !missing);
+	}
+}
+
+TEST(PoseCodec, LateDatagramsAreStaleButARestartedSenderIsnt)
+{
+	PoseEncoder encoder;
+	PoseDecoder decoder;
+	const std::vector<Datagram> datagrams = encode_frames(encoder, 100);
+
+	JointFrame frame;
+	long long timestamp = 0;
+	for (const Datagram& datagram : datagrams)
+		decoder.decode(datagram.bytes.data(), datagram.bytes.size(), frame, timestamp);
+
+	EXPECT_EQ(decoder.decode(datagrams[98].bytes.data(), datagrams[98].bytes.size(), frame, timestamp),
+	          PoseDecoder::Decode_Stale);
+	EXPECT_EQ(decoder.decode(datagrams[99].bytes.data(), datagrams[99].bytes.size(), frame, timestamp),
+	          PoseDecoder::Decode_Stale);
+
+	// The plugin came back: sequence 1 again, way behind, but a keyframe
+	PoseEncoder restarted;
+	const std::vector<Datagram> again = encode_frames(restarted, 2);
+	EXPECT_EQ(decoder.decode(again[0].bytes.data(), again[0].bytes.size(), frame, timestamp), PoseDecoder::Decode_Ok);
+	EXPECT_EQ(frame.sequence, 1u);
+	EXPECT_EQ(decoder.decode(again[1].bytes.data(), again[1].bytes.size(), frame, timestamp), PoseDecoder::Decode_Ok);
+	expect_close(frame, again[1].frame, true);
+}
+
+TEST(PoseCodec, AFrameThatDidntFitLeavesTheEncoderAsItWas)
+{
+	PoseEncoder encoder;
+	PoseDecoder decoder;
+	SimulationSettings settings;
+	settings.objects = 3;
+	settings.dropoutEvery = 0.0;
+	SimulatedPoseSource source(settings);
+	source.set_fixed_step(0.002);
+
+	JointFrame original, decoded;
+	long long timestamp = 0;
+	uint8_t buffer[pose_codec::max_bytes];
+	for (int n = 0; n < 10; n++)
+	{
+		acquire_frame(source, original, 0.0, source.connected_objects());
+
+		// Every other frame first goes to a buffer that's too small
+		if (n % 2)
+		{
+			EXPECT_EQ(encoder.encode(original, n, buffer, 40), 0u);
+		}
+
+		const size_t size = encoder.encode(original, n, buffer, sizeof(buffer));
+		ASSERT_GT(size, 0u);
+		ASSERT_EQ(decoder.decode(buffer, size, decoded, timestamp), PoseDecoder::Decode_Ok) << n;
+		expect_close(decoded, original, true);
+	}
+}
+
+TEST(PoseCodec, RejectsWhatIsntAPoseDatagram)
+{
+	PoseEncoder encoder;
+	const std::vector<Datagram> datagrams = encode_frames(encoder, 1);
+	const std::vector<uint8_t>& bytes = datagrams[0].bytes;
+
+	JointFrame frame;
+	long long timestamp = 0;
+	const uint8_t garbage[] = {'G', 'E', 'T', ' ', '/', ' '};
+	EXPECT_EQ(PoseDecoder().decode(garbage, sizeof(garbage), frame, timestamp), PoseDecoder::Decode_Bad);
+
+	// Cut short anywhere
+	for (size_t size = 0; size < bytes.size(); size += 7)
+		EXPECT_EQ(PoseDecoder().decode(bytes.data(), size, frame, timestamp), PoseDecoder::Decode_Bad) << size;
+
+	std::vector<uint8_t> newer = bytes;
+	newer[2] = pose_codec::version + 1;
+	EXPECT_EQ(PoseDecoder().decode(newer.data(), newer.size(), frame, timestamp), PoseDecoder::Decode_Bad);
+}
+
+TEST(PoseStream, SendsFramesOverLocalhost)
+{
+	// Off the default port, a running plugin may have that
+	constexpr uint16_t port = pose_stream_port + 1000;
+	PoseStreamReceiver receiver;
+	ASSERT_TRUE(receiver.open(port));
+
+	PoseStreamSender sender;
+	ASSERT_TRUE(sender.open("127.0.0.1", port));
+	sender.set_origin(0.5f, 1.0f, -0.5f);
+
+	SimulationSettings settings;
+	settings.objects = 2;
+	settings.dropoutEvery = 0.0;
+	SimulatedPoseSource source(settings);
+	source.set_fixed_step(0.002);
+
+	JointFrame sent, received;
+	long long timestamp = 0;
+	for (int n = 0; n < 50; n++)
+	{
+		acquire_frame(source, sent, 0.0, source.connected_objects());
+		sender.send(sent, 7000 + n);
+
+		ASSERT_TRUE(receiver.receive(received, timestamp, 1000)) << n;
+		EXPECT_EQ(timestamp, 7000 + n);
+		expect_close(received, sent, true);
+	}
+
+	EXPECT_EQ(sender.sent(), 50u);
+	EXPECT_EQ(sender.dropped(), 0u);
+	EXPECT_EQ(receiver.stats().frames, 50u);
+	EXPECT_EQ(receiver.stats().lost, 0u);
+
+	// Something else on the port doesn't count as a frame
+	UdpSocket stray;
+	ASSERT_TRUE(stray.open("127.0.0.1", port, false));
+	const uint8_t garbage[] = {1, 2, 3, 4};
+	ASSERT_TRUE(stray.send(garbage, sizeof(garbage)));
+	EXPECT_FALSE(receiver.receive(received, timestamp, 1000));
+	EXPECT_EQ(receiver.stats().bad, 1u);
+}
@@ -0,0 +1,185 @@
+#include <cmath>
+#include <cstdint>
+#include <numbers>
+
+#include <gtest/gtest.h>
+
+#include "ExtrapolationBenchmark.h"
+#include "PoseExtrapolator.h"
+#include "SimulatedPoseSource.h"
+
+namespace
+{
+	// Every joint spinning and moving, like ExtrapolationBenchmark uses
+	JointFrame moving_frame(const uint32_t objects, const int skip = 0)
+	{
+		SimulationSettings settings;
+		settings.objects = objects;
+		settings.orbitSpeed = 3.0;
+		settings.spinSpeed = 3.0;
+		settings.dropoutEvery = 0.0;
+		SimulatedPoseSource source(settings);
+		source.set_fixed_step(0.001);
+
+		JointFrame frame;
+		for (int n = 0; n <= skip; n++)
+			acquire_frame(source, frame, 0.0, first_object_slots(objects));
+		return frame;
+	}
+
+	void expect_same_pose(const JointSample& a, const JointSample& b, const uint32_t joint)
+	{
+		for (int c = 0; c < 3; c++)
+			EXPECT_NEAR(a.position[c], b.position[c], 1e-5) << joint;
+
+		double dot = 0.0;
+		for (int c = 0; c < 4; c++) dot += a.orientation[c] * b.orientation[c];
+		EXPECT_NEAR(std::abs(dot), 1.0, 1e-5) << joint; // Either sign is the same rotation
+	}
+}
+
+TEST(PoseExtrapolator, MatchesTheScalarReference)
+{
+	PoseExtrapolator extrapolator;
+	JointFrame batch, scalar;
+
+	for (const int skip : {0, 250, 1000})
+	{
+		const JointFrame frame = moving_frame(max_frame_joints - 2, skip);
+		extrapolator.load(frame);
+
+		for (const float horizon : {0.0f, 0.005f, 0.011f, 0.02f, 0.05f, 0.2f})
+		{
+			extrapolator.extrapolate(horizon, batch);
+			extrapolate_scalar(frame, horizon, scalar);
+
+			ASSERT_EQ(batch.jointCount, frame.jointCount);
+			for (uint32_t i = 0; i < frame.jointCount; i++)
+				expect_same_pose(batch.joints[i], scalar.joints[i], i);
+		}
+	}
+}
+
+TEST(PoseExtrapolator, EveryJointByItsOwnHorizon)
+{
+	const JointFrame frame = moving_frame(20);
+	PoseExtrapolator extrapolator;
+	extrapolator.load(frame);
+
+	PoseExtrapolator::Horizons horizons{};
+	for (uint32_t i = 0; i < frame.jointCount; i++)
+		horizons[i] = 0.002f * static_cast<float>(i);
+
+	JointFrame batch, scalar;
+	extrapolator.extrapolate(horizons, batch);
+	for (uint32_t i = 0; i < frame.jointCount; i++)
+	{
+		extrapolate_scalar(frame, horizons[i], scalar);
+		expect_same_pose(batch.joints[i], scalar.joints[i], i);
+	}
+}
+
+TEST(PoseExtrapolator, HorizonZeroIsTheLoadedFrame)
+{
+	const JointFrame frame = moving_frame(8);
+	PoseExtrapolator extrapolator;
+	extrapolator.load(frame);
+
+	JointFrame out;
+	extrapolator.extrapolate(0.f, out);
+	for (uint32_t i = 0; i < frame.jointCount; i++)
+	{
+		for (int c = 0; c < 3; c++)
+			EXPECT_EQ(out.joints[i].position[c], frame.joints[i].position[c]);
+		for (int c = 0; c < 4; c++)
+			EXPECT_NEAR(out.joints[i].orientation[c], frame.joints[i].orientation[c], 1e-6);
+	}
+	EXPECT_EQ(extrapolator.frame().jointCount, frame.jointCount);
+}
+
+TEST(PoseExtrapolator, OnlyThePosesMove)
+{
+	const JointFrame frame = moving_frame(4);
+	PoseExtrapolator extrapolator;
+	extrapolator.load(frame);
+
+	JointFrame out;
+	extrapolator.extrapolate(0.05f, out);
+	EXPECT_EQ(out.frameTime, frame.frameTime);
+	EXPECT_EQ(out.objectMask, frame.objectMask);
+	ASSERT_EQ(out.jointCount, frame.jointCount);
+	for (uint32_t i = 0; i < frame.jointCount; i++)
+	{
+		EXPECT_EQ(out.joints[i].sampleTime, frame.joints[i].sampleTime);
+		EXPECT_EQ(out.joints[i].statusFlags, frame.joints[i].statusFlags);
+		for (int c = 0; c < 3; c++)
+		{
+			EXPECT_EQ(out.joints[i].linearVelocity[c], frame.joints[i].linearVelocity[c]);
+			EXPECT_EQ(out.joints[i].angularVelocity[c], frame.joints[i].angularVelocity[c]);
+		}
+	}
+}
+
+TEST(PoseExtrapolator, KnownMotion)
+{
+	JointFrame frame;
+	frame.jointCount = 1;
+	JointSample& sample = frame.joints[0];
+	sample.position[1] = 1.f;
+	sample.linearVelocity[0] = 2.f;
+	sample.linearAcceleration[2] = -4.f;
+	sample.angularVelocity[2] = std::numbers::pi_v<float>; // Half a turn a second around z
+
+	PoseExtrapolator extrapolator;
+	extrapolator.load(frame);
+	JointFrame out;
+	extrapolator.extrapolate(0.5f, out);
+
+	// 2 * 0.5 along x, -4 * 0.5^2 / 2 along z, a quarter turn
+	EXPECT_NEAR(out.joints[0].position[0], 1.0, 1e-6);
+	EXPECT_NEAR(out.joints[0].position[1], 1.0, 1e-6);
+	EXPECT_NEAR(out.joints[0].position[2], -0.5, 1e-6);
+
+	const Eigen::Quaternionf quarter(Eigen::AngleAxisf(std::numbers::pi_v<float> / 2, Eigen::Vector3f::UnitZ()));
+	EXPECT_TRUE(Eigen::Map<const Eigen::Quaternionf>(out.joints[0].orientation).isApprox(quarter, 1e-5f));
+}
+
+TEST(PoseExtrapolator, UnsetOrientationsBecomeIdentity)
+{
+	JointFrame frame;
+	frame.jointCount = 2;
+	for (int c = 0; c < 4; c++)
+		frame.joints[0].orientation[c] = frame.joints[1].orientation[c] = 0.f;
+	frame.joints[0].angularVelocity[1] = 1.f; // Spinning from identity then
+	frame.joints[1].orientation[1] = 2.f; // Not unit, gets normalized
+
+	PoseExtrapolator extrapolator;
+	extrapolator.load(frame);
+	JointFrame out;
+
+	extrapolator.extrapolate(0.f, out);
+	EXPECT_TRUE(Eigen::Map<const Eigen::Quaternionf>(out.joints[0].orientation).isApprox(Eigen::Quaternionf::Identity()));
+	EXPECT_NEAR(out.joints[1].orientation[1], 1.f, 1e-6);
+
+	extrapolator.extrapolate(0.5f, out);
+	const Eigen::Quaternionf turned(Eigen::AngleAxisf(0.5f, Eigen::Vector3f::UnitY()));
+	EXPECT_TRUE(Eigen::Map<const Eigen::Quaternionf>(out.joints[0].orientation).isApprox(turned, 1e-5f));
+	for (int c = 0; c < 4; c++)
+		EXPECT_TRUE(std::isfinite(out.joints[0].orientation[c]));
+}
+
+TEST(PoseExtrapolator, FewerJointsAfterMoreOnlyTouchesThoseLoaded)
+{
+	PoseExtrapolator extrapolator;
+	extrapolator.load(moving_frame(max_frame_joints - 2));
+
+	const JointFrame frame = moving_frame(0, 100);
+	extrapolator.load(frame);
+
+	JointFrame batch, scalar;
+	extrapolator.extrapolate(0.02f, batch);
+	extrapolate_scalar(frame, 0.02f, scalar);
+	ASSERT_EQ(batch.jointCount, 2u);
+	for (uint32_t i = 0; i < 2; i++)
+		expect_same_pose(batch.joints[i], scalar.joints[i], i);
+}
@@ -0,0 +1,200 @@
+#include <cmath>
+#include <cstdint>
+#include <random>
+
+#include <gtest/gtest.h>
+
+#include "PoseFilterBank.h"
+
+namespace
+{
+	constexpr uint32_t tracked = status_orientation_tracked | status_position_tracked;
+	constexpr double step = 0.002; // 500 Hz
+
+	// 'joints' joints at x = 'x' (plus their index along y), frame 'n'
+	void still_frame(JointFrame& frame, const int n, const uint32_t joints, const float x)
+	{
+		frame = {};
+		frame.frameTime = 1.0 + n * step;
+		frame.jointCount = joints;
+		for (uint32_t j = 0; j < joints; j++)
+		{
+			frame.joints[j].position[0] = x;
+			frame.joints[j].position[1] = static_cast<float>(j);
+			frame.joints[j].statusFlags = tracked;
+		}
+	}
+
+	double variance(const std::vector<float>& values)
+	{
+		double mean = 0.0, squares = 0.0;
+		for (const float v : values) mean += v;
+		mean /= static_cast<double>(values.size());
+		for (const float v : values) squares += (v - mean) * (v - mean);
+		return squares / static_cast<double>(values.size());
+	}
+}
+
+TEST(PoseFilterBank, OffLeavesFramesAlone)
+{
+	PoseFilterBank filter;
+	JointFrame frame, original;
+	for (int n = 0; n < 10; n++)
+	{
+		still_frame(frame, n, 2, static_cast<float>(n));
+		original = frame;
+		filter.filter(frame);
+		EXPECT_EQ(frame.joints[0].position[0], original.joints[0].position[0]);
+	}
+}
+
+TEST(PoseFilterBank, BothFiltersSmoothJitterAtRest)
+{
+	for (const int mode : {PoseFilterBank::Filter_OneEuro, PoseFilterBank::Filter_Kalman})
+	{
+		PoseFilterBank filter;
+		filter.set_mode(mode);
+		filter.settings().measurementNoise = 1e-5f; // Matches the jitter below
+
+		std::mt19937 random(7);
+		std::normal_distribution<float> noise(0.f, 0.003f);
+		std::vector<float> in, out;
+
+		JointFrame frame;
+		for (int n = 0; n < 1000; n++)
+		{
+			still_frame(frame, n, 1, 0.5f + noise(random));
+			in.push_back(frame.joints[0].position[0]);
+			filter.filter(frame);
+			out.push_back(frame.joints[0].position[0]);
+		}
+
+		EXPECT_LT(variance(out), variance(in) * 0.5) << mode;
+	}
+}
+
+TEST(PoseFilterBank, BothFiltersFollowSteadyMotion)
+{
+	for (const int mode : {PoseFilterBank::Filter_OneEuro, PoseFilterBank::Filter_Kalman})
+	{
+		PoseFilterBank filter;
+		filter.set_mode(mode);
+
+		// 1 m/s along x for a second: some lag, but it doesn't keep growing
+		JointFrame frame;
+		for (int n = 0; n < 500; n++)
+		{
+			still_frame(frame, n, 1, static_cast<float>(n * step));
+			filter.filter(frame);
+		}
+		EXPECT_NEAR(frame.joints[0].position[0], 499 * step, 0.05) << mode;
+	}
+}
+
+TEST(PoseFilterBank, KeepsOrientationsOnOneHemisphere)
+{
+	PoseFilterBank filter;
+	filter.set_mode(PoseFilterBank::Filter_OneEuro);
+
+	// The same rotation, sign flipping every frame: averaging q and -q would give garbage
+	const float half = std::sqrt(0.5f);
+	JointFrame frame;
+	for (int n = 0; n < 50; n++)
+	{
+		still_frame(frame, n, 1, 0.f);
+		const float sign = n % 2 ? -1.f : 1.f;
+		frame.joints[0].orientation[1] = sign * half;
+		frame.joints[0].orientation[3] = sign * half;
+		filter.filter(frame);
+
+		EXPECT_NEAR(std::abs(frame.joints[0].orientation[1]), half, 1e-5) << n;
+		EXPECT_NEAR(std::abs(frame.joints[0].orientation[3]), half, 1e-5) << n;
+	}
+}
+
+TEST(PoseFilterBank, LostJointsPassThroughAndStartOver)
+{
+	for (const int mode : {PoseFilterBank::Filter_OneEuro, PoseFilterBank::Filter_Kalman})
+	{
+		PoseFilterBank filter;
+		filter.set_mode(mode);
+
+		JointFrame frame;
+		int n = 0;
+		for (; n < 100; n++)
+		{
+			still_frame(frame, n, 2, 0.f);
+			filter.filter(frame);
+		}
+		ASSERT_TRUE(filter.primed(0));
+
+		// Joint 0 loses tracking, its pose freezes somewhere else: left exactly as it comes
+		for (; n < 150; n++)
+		{
+			still_frame(frame, n, 2, 0.f);
+			frame.joints[0].position[0] = 2.f;
+			frame.joints[0].statusFlags = status_orientation_tracked;
+			filter.filter(frame);
+			EXPECT_EQ(frame.joints[0].position[0], 2.f);
+			EXPECT_EQ(frame.joints[0].statusFlags, status_orientation_tracked);
+		}
+		EXPECT_FALSE(filter.primed(0));
+		EXPECT_TRUE(filter.primed(1)); // The other one never noticed
+
+		// Back somewhere else again: no dragging in from where it was before the loss
+		still_frame(frame, n++, 2, 1.f);
+		filter.filter(frame);
+		EXPECT_EQ(frame.joints[0].position[0], 1.f) << mode;
+		EXPECT_TRUE(filter.primed(0));
+
+		still_frame(frame, n++, 2, 1.f);
+		filter.filter(frame);
+		EXPECT_NEAR(frame.joints[0].position[0], 1.f, 1e-4) << mode;
+	}
+}
+
+TEST(PoseFilterBank, JointsThatWentAwayStartOverWhenTheyAreBack)
+{
+	PoseFilterBank filter;
+	filter.set_mode(PoseFilterBank::Filter_Kalman);
+
+	JointFrame frame;
+	int n = 0;
+	for (; n < 100; n++)
+	{
+		still_frame(frame, n, 3, 0.f);
+		filter.filter(frame);
+	}
+
+	// Joint 2 isn't in the frame for a while
+	for (; n < 110; n++)
+	{
+		still_frame(frame, n, 2, 0.f);
+		filter.filter(frame);
+	}
+	EXPECT_FALSE(filter.primed(2));
+
+	still_frame(frame, n, 3, 0.f);
+	frame.joints[2].position[0] = 3.f;
+	filter.filter(frame);
+	EXPECT_EQ(frame.joints[2].position[0], 3.f);
+}
+
+TEST(PoseFilterBank, SwitchingModesStartsOver)
+{
+	PoseFilterBank filter;
+	filter.set_mode(PoseFilterBank::Filter_OneEuro);
+
+	JointFrame frame;
+	for (int n = 0; n < 10; n++)
+	{
+		still_frame(frame, n, 1, 0.f);
+		filter.filter(frame);
+	}
+	filter.set_mode(PoseFilterBank::Filter_Kalman);
+	EXPECT_FALSE(filter.primed(0));
+
+	still_frame(frame, 10, 1, 5.f);
+	filter.filter(frame);
+	EXPECT_EQ(frame.joints[0].position[0], 5.f);
+}
@@ -0,0 +1,249 @@
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <numbers>
+
+#include <gtest/gtest.h>
+
+#include "PoseHistory.h"
+
+namespace
+{
+	constexpr uint32_t tracked = status_orientation_tracked | status_position_tracked;
+
+	// Turned 'angle' around z
+	Eigen::Quaternionf turned(const float angle)
+	{
+		return Eigen::Quaternionf(Eigen::AngleAxisf(angle, Eigen::Vector3f::UnitZ()));
+	}
+
+	// Joint 0 sampled at 'time', x = 'x' and moving at 'x' m/s, turned 'angle'
+	// Joint 1 is another device: half a millisecond later, at twice the x
+	void push(PoseHistory& history, const double time, const float x, const float angle = 0.f,
+	          const uint32_t flags = tracked)
+	{
+		JointFrame frame;
+		frame.jointCount = 2;
+		for (uint32_t i = 0; i < 2; i++)
+		{
+			JointSample& sample = frame.joints[i];
+			sample.sampleTime = time + 0.0005 * i;
+			sample.statusFlags = flags;
+			sample.position[0] = x * static_cast<float>(i + 1);
+			sample.linearVelocity[0] = x;
+			Eigen::Map<Eigen::Quaternionf>(sample.orientation) = turned(angle);
+		}
+		history.push(frame);
+	}
+
+	Eigen::Quaternionf orientation(const JointSample& sample)
+	{
+		return Eigen::Map<const Eigen::Quaternionf>(sample.orientation);
+	}
+
+	// About 300 KB, keep it off the stack
+	std::unique_ptr<PoseHistory> make_history() { return std::make_unique<PoseHistory>(); }
+}
+
+TEST(PoseHistory, NothingToSampleWithoutHistory)
+{
+	const auto history = make_history();
+	JointFrame frame;
+	EXPECT_FALSE(history->sample(1.0, frame));
+	EXPECT_EQ(history->resample(1.0, 0.001, &frame, 1), 0u);
+}
+
+TEST(PoseHistory, InterpolatesEveryJointBetweenItsOwnSamples)
+{
+	const auto history = make_history();
+	push(*history, 1.000, 0.f);
+	push(*history, 1.010, 1.f);
+
+	JointFrame frame;
+	ASSERT_TRUE(history->sample(1.0025, frame));
+	EXPECT_EQ(frame.jointCount, 2u);
+	EXPECT_EQ(frame.frameTime, 1.0025);
+
+	EXPECT_NEAR(frame.joints[0].position[0], 0.25f, 1e-5);
+	EXPECT_NEAR(frame.joints[0].linearVelocity[0], 0.25f, 1e-5);
+	EXPECT_EQ(frame.joints[0].sampleTime, 1.0025);
+
+	// Its samples are at 1.0005 and 1.0105
+	EXPECT_NEAR(frame.joints[1].position[0], 2.f * 0.2f, 1e-5);
+	EXPECT_EQ(frame.joints[1].statusFlags, tracked);
+}
+
+TEST(PoseHistory, ExactlyOnASampleIsThatSample)
+{
+	const auto history = make_history();
+	push(*history, 1.000, 0.f);
+	push(*history, 1.010, 1.f);
+	push(*history, 1.020, 3.f);
+
+	JointFrame frame;
+	ASSERT_TRUE(history->sample(1.010, frame));
+	EXPECT_EQ(frame.joints[0].position[0], 1.f);
+	EXPECT_EQ(frame.joints[0].sampleTime, 1.010);
+}
+
+TEST(PoseHistory, HoldsTheEndsOutsideTheHistory)
+{
+	const auto history = make_history();
+	push(*history, 1.000, 1.f, 0.1f);
+	push(*history, 1.010, 2.f, 0.2f);
+
+	// Before the oldest: the oldest as it was, with its own sample time
+	JointFrame frame;
+	ASSERT_TRUE(history->sample(0.5, frame));
+	EXPECT_EQ(frame.frameTime, 0.5);
+	EXPECT_EQ(frame.joints[0].position[0], 1.f);
+	EXPECT_EQ(frame.joints[0].sampleTime, 1.000);
+	EXPECT_TRUE(orientation(frame.joints[0]).isApprox(turned(0.1f), 1e-5f));
+
+	// After the newest: the newest, never extrapolated
+	ASSERT_TRUE(history->sample(2.0, frame));
+	EXPECT_EQ(frame.joints[0].position[0], 2.f);
+	EXPECT_EQ(frame.joints[0].sampleTime, 1.010);
+	EXPECT_EQ(frame.joints[1].position[0], 4.f);
+	EXPECT_EQ(frame.joints[1].sampleTime, 1.0105);
+	EXPECT_TRUE(orientation(frame.joints[0]).isApprox(turned(0.2f), 1e-5f));
+}
+
+TEST(PoseHistory, SlerpsOrientations)
+{
+	const auto history = make_history();
+	const float quarter = std::numbers::pi_v<float> / 2;
+	push(*history, 1.000, 0.f, 0.f);
+	push(*history, 1.010, 0.f, quarter);
+
+	// A normalized lerp would be off by almost a degree a quarter of the way in
+	JointFrame frame;
+	for (const double weight : {0.25, 0.5, 0.75})
+	{
+		ASSERT_TRUE(history->sample(1.0 + 0.010 * weight, frame));
+		const Eigen::Quaternionf out = orientation(frame.joints[0]);
+		EXPECT_NEAR(out.norm(), 1.f, 1e-5);
+		EXPECT_NEAR(out.angularDistance(turned(quarter * static_cast<float>(weight))), 0.f, 1e-3) << weight;
+	}
+}
+
+TEST(PoseHistory, SlerpsTheShortWayWhateverTheSign)
+{
+	const auto history = make_history();
+	const float quarter = std::numbers::pi_v<float> / 2;
+
+	// The same two rotations, the second one stored as -q: still a quarter turn apart, not 3/4
+	JointFrame frame;
+	frame.jointCount = 1;
+	frame.joints[0].statusFlags = tracked;
+	frame.joints[0].sampleTime = 1.000;
+	Eigen::Map<Eigen::Quaternionf>(frame.joints[0].orientation) = turned(0.f);
+	history->push(frame);
+
+	frame.joints[0].sampleTime = 1.010;
+	Eigen::Map<Eigen::Quaternionf>(frame.joints[0].orientation).coeffs() = -turned(quarter).coeffs();
+	history->push(frame);
+
+	ASSERT_TRUE(history->sample(1.005, frame));
+	EXPECT_NEAR(orientation(frame.joints[0]).angularDistance(turned(quarter / 2)), 0.f, 1e-3);
+}
+
+TEST(PoseHistory, NearlyTheSameOrientationsDontBlowUp)
+{
+	const auto history = make_history();
+	push(*history, 1.000, 0.f, 0.3f);
+	push(*history, 1.010, 0.f, 0.3f + 1e-6f);
+
+	JointFrame frame;
+	ASSERT_TRUE(history->sample(1.005, frame));
+	for (int c = 0; c < 4; c++)
+		EXPECT_TRUE(std::isfinite(frame.joints[0].orientation[c]));
+	EXPECT_TRUE(orientation(frame.joints[0]).isApprox(turned(0.3f), 1e-4f));
+}
+
+TEST(PoseHistory, WrapsAroundKeepingTheNewest)
+{
+	const auto history = make_history();
+	const size_t pushed = PoseHistory::capacity + 50;
+	for (size_t n = 0; n < pushed; n++)
+		push(*history, 1.0 + 0.001 * n, static_cast<float>(n));
+
+	EXPECT_EQ(history->samples(0), PoseHistory::capacity);
+	EXPECT_EQ(history->samples(1), PoseHistory::capacity);
+
+	// The first 50 are gone: anything before is the oldest one left
+	JointFrame frame;
+	ASSERT_TRUE(history->sample(1.0, frame));
+	EXPECT_EQ(frame.joints[0].position[0], 50.f);
+
+	// Across where the ring wrapped (capacity - 1 -> capacity) and everywhere else
+	for (size_t n = 50; n + 1 < pushed; n++)
+	{
+		ASSERT_TRUE(history->sample(1.0 + 0.001 * (static_cast<double>(n) + 0.5), frame));
+		EXPECT_NEAR(frame.joints[0].position[0], static_cast<float>(n) + 0.5f, 1e-3) << n;
+	}
+
+	ASSERT_TRUE(history->sample(10.0, frame));
+	EXPECT_EQ(frame.joints[0].position[0], static_cast<float>(pushed - 1));
+}
+
+TEST(PoseHistory, OnlyTrackedIfBothEndsWere)
+{
+	const auto history = make_history();
+	push(*history, 1.000, 0.f, 0.f, tracked);
+	push(*history, 1.010, 1.f, 0.f, status_orientation_tracked);
+
+	JointFrame frame;
+	ASSERT_TRUE(history->sample(1.005, frame));
+	EXPECT_EQ(frame.joints[0].statusFlags, status_orientation_tracked);
+
+	ASSERT_TRUE(history->sample(0.9, frame));
+	EXPECT_EQ(frame.joints[0].statusFlags, tracked);
+}
+
+TEST(PoseHistory, SkipsSamplesThatDidntMoveOn)
+{
+	const auto history = make_history();
+	push(*history, 1.000, 0.f);
+	push(*history, 1.010, 1.f);
+	push(*history, 1.010, 5.f); // Same sample again
+	push(*history, 1.005, 5.f); // Older than the newest
+
+	EXPECT_EQ(history->samples(0), 2u);
+	JointFrame frame;
+	ASSERT_TRUE(history->sample(2.0, frame));
+	EXPECT_EQ(frame.joints[0].position[0], 1.f);
+}
+
+TEST(PoseHistory, StartsOverWhenJointsMoveAround)
+{
+	const auto history = make_history();
+	push(*history, 1.000, 0.f);
+	push(*history, 1.010, 1.f);
+
+	JointFrame frame;
+	frame.jointCount = 3;
+	frame.objectMask = 1;
+	frame.joints[2].sampleTime = 1.020;
+	history->push(frame);
+
+	EXPECT_EQ(history->joints(), 3u);
+	EXPECT_EQ(history->samples(0), 1u);
+	EXPECT_EQ(history->samples(2), 1u);
+}
+
+TEST(PoseHistory, ResamplesOnAGrid)
+{
+	const auto history = make_history();
+	for (int n = 0; n <= 10; n++)
+		push(*history, 1.0 + 0.002 * n, static_cast<float>(n));
+
+	// Every millisecond, half of them between two samples
+	JointFrame frames[15];
+	ASSERT_EQ(history->resample(1.001, 0.001, frames, 15), 15u);
+	for (size_t f = 0; f < 15; f++)
+	{
+		EXPECT_NEAR(frames[f].frameTime, 1.001 + 0.001 * static_cast<double>(f), 1e-12);
+		EXPECT_NEAR(frames[f].joints[0].position[0], 0.5f * static_cast<float>(f + 1), 1e-3) << f;
+	}
+}
@@ -0,0 +1,98 @@
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "PoseRecording.h"
+#include "SimulatedPoseSource.h"
+
+namespace
+{
+	// A recording of its own per test, gone afterwards
+	class PoseRecordingTest : public testing::Test
+	{
+	protected:
+		void SetUp() override
+		{
+			path = std::filesystem::temp_directory_path() /
+				(std::string("riftcv1_") + testing::UnitTest::GetInstance()->current_test_info()->name() + ".cv1poses");
+		}
+
+		void TearDown() override
+		{
+			std::error_code error;
+			std::filesystem::remove(path, error);
+		}
+
+		std::filesystem::path path;
+	};
+}
+
+TEST_F(PoseRecordingTest, ReplaysHotPluggedSlotsIntoTheirOwnJoints)
+{
+	SimulationSettings settings;
+	settings.objects = 2;
+	settings.dropoutEvery = 0.0;
+	SimulatedPoseSource source(settings);
+	source.set_fixed_step(0.001);
+
+	// Slots come and go while recording, never the first ones in a row
+	std::vector<JointFrame> recorded;
+	{
+		PoseRecorder recorder;
+		ASSERT_TRUE(recorder.start(path));
+
+		JointFrame frame;
+		for (int n = 0; n < 30; n++)
+		{
+			if (n == 10)
+			{
+				source.connect(9);
+				source.disconnect(0);
+			}
+			if (n == 20) source.connect(40);
+
+			acquire_frame(source, frame, 0.0, source.connected_objects());
+			recorder.record(frame);
+			recorded.push_back(frame);
+		}
+		recorder.stop();
+	}
+
+	PoseReplay replay;
+	ASSERT_TRUE(replay.open(path));
+
+	JointFrame frame;
+	for (const JointFrame& original : recorded)
+	{
+		ASSERT_TRUE(replay.next(frame, PoseReplay::Replay_AsFastAsPossible));
+		ASSERT_EQ(frame.jointCount, original.jointCount);
+		EXPECT_EQ(frame.objectMask, original.objectMask);
+		for (uint32_t i = 0; i < frame.jointCount; i++)
+			for (int c = 0; c < 3; c++)
+				EXPECT_EQ(frame.joints[i].position[c], original.joints[i].position[c]);
+	}
+}
+
+TEST_F(PoseRecordingTest, RefusesOtherVersions)
+{
+	{
+		PoseRecorder recorder;
+		ASSERT_TRUE(recorder.start(path));
+		JointFrame frame;
+		frame.jointCount = 2;
+		recorder.record(frame);
+	}
+
+	// Version 1 had no object masks, its records don't line up with these
+	{
+		MappedFile file;
+		ASSERT_TRUE(file.open(path, std::filesystem::file_size(path), true));
+		reinterpret_cast<PoseRecordingHeader*>(file.data())->version = 1;
+	}
+
+	PoseReplay replay;
+	EXPECT_FALSE(replay.open(path));
+}
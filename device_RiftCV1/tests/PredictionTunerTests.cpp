@@ -0,0 +1,171 @@
+#include <cstdint>
+#include <memory>
+
+#include <gtest/gtest.h>
+
+#include "PredictionTuner.h"
+
+namespace
+{
+	constexpr uint32_t tracked = status_orientation_tracked | status_position_tracked;
+	constexpr double step = 0.002; // 500 Hz
+	constexpr double target = 0.011;
+
+	// One Touch gliding along x, frames at horizon 0 like the tuner gets them
+	// 'reported': the share of the real velocity its estimate shows, < 1 for one lagging behind
+	class Glide
+	{
+	public:
+		void run(PredictionTuner& tuner, const double seconds, const float speed, const float reported = 1.f)
+		{
+			for (const double end = mTime + seconds; mTime < end; mTime += step)
+			{
+				JointFrame frame;
+				frame.frameTime = mTime;
+				frame.jointCount = 1;
+				JointSample& sample = frame.joints[0];
+				sample.sampleTime = mTime;
+				sample.statusFlags = tracked;
+				sample.position[0] = static_cast<float>(mPosition);
+				sample.linearVelocity[0] = speed * reported;
+				tuner.observe(frame);
+
+				mPosition += speed * step;
+			}
+		}
+
+	private:
+		double mTime = 1.0;
+		double mPosition = 0.0;
+	};
+
+	// Holds a PoseHistory, about 300 KB
+	std::unique_ptr<PredictionTuner> make_tuner()
+	{
+		auto tuner = std::make_unique<PredictionTuner>();
+		tuner->set_target(target);
+		return tuner;
+	}
+}
+
+TEST(PredictionTuner, TheTargetUntilThereIsEnoughMotion)
+{
+	const auto tuner = make_tuner();
+	EXPECT_FLOAT_EQ(tuner->horizon(0, 0.5f), static_cast<float>(target));
+
+	// Not enough samples yet in the window, even if they say otherwise
+	Glide glide;
+	glide.run(*tuner, 0.2, 0.5f, 0.5f);
+	EXPECT_LT(tuner->band(0, 1).samples, tuner->settings.minSamples);
+	EXPECT_FLOAT_EQ(tuner->horizon(0, 0.5f), static_cast<float>(target));
+}
+
+TEST(PredictionTuner, ConstantVelocityFitsTheTarget)
+{
+	const auto tuner = make_tuner();
+	Glide glide;
+	glide.run(*tuner, 3.0, 0.5f);
+
+	// Extrapolating by exactly the target is exactly right
+	const PredictionTuner::Band band = tuner->band(0, 1);
+	EXPECT_GT(band.samples, tuner->settings.minSamples);
+	EXPECT_NEAR(band.horizon, target, 2e-4);
+	EXPECT_LT(band.targetError, 0.05); // mm
+	EXPECT_NEAR(tuner->horizon(0, 0.5f), target, 2e-4);
+}
+
+TEST(PredictionTuner, LaggingVelocityFitsALongerHorizon)
+{
+	const auto tuner = make_tuner();
+	Glide glide;
+	glide.run(*tuner, 20.0, 0.5f, 0.8f);
+
+	// Only 80% of the speed shows up, so it takes target / 0.8 to land where the device went
+	// Errors are windowed (from 0, and from before the fit was ready) so only close to settled
+	const PredictionTuner::Band band = tuner->band(0, 1);
+	EXPECT_NEAR(band.horizon, target / 0.8, 3e-4);
+	EXPECT_NEAR(band.targetError, 0.5 * 0.2 * target * 1000.0, 0.2); // mm
+	EXPECT_LT(band.fittedError, band.targetError / 3.0);
+}
+
+TEST(PredictionTuner, SpeedBandsFitOnTheirOwn)
+{
+	const auto tuner = make_tuner();
+	Glide glide;
+	glide.run(*tuner, 3.0, 0.1f); // Slow and exact
+	glide.run(*tuner, 3.0, 2.f, 0.8f); // Fast and lagging, 1.6 m/s as far as the tuner can tell
+
+	// The few samples that span the switch pull on the slow band a little, and are all the middle one saw
+	const double lagging = target / 0.8;
+	EXPECT_NEAR(tuner->band(0, 0).horizon, target, 5e-4);
+	EXPECT_NEAR(tuner->band(0, 2).horizon, lagging, 3e-4);
+	EXPECT_LT(tuner->band(0, 1).samples, tuner->settings.minSamples);
+	EXPECT_FLOAT_EQ(static_cast<float>(tuner->band(0, 1).horizon), static_cast<float>(target));
+
+	// Below the first band and past the last, that band; in between, linear between band centers
+	EXPECT_DOUBLE_EQ(tuner->horizon(0, 0.f), tuner->band(0, 0).horizon);
+	EXPECT_DOUBLE_EQ(tuner->horizon(0, 3.f), tuner->band(0, 2).horizon);
+	EXPECT_NEAR(tuner->horizon(0, 0.8f), 0.7 * target + 0.3 * tuner->band(0, 2).horizon, 1e-6);
+}
+
+TEST(PredictionTuner, SamplesBetweenBandsTeachBoth)
+{
+	const auto tuner = make_tuner();
+	Glide glide;
+	glide.run(*tuner, 3.0, 0.2f); // A quarter of the way from band 0 to band 1
+
+	const PredictionTuner::Band slow = tuner->band(0, 0), middle = tuner->band(0, 1);
+	EXPECT_NEAR(slow.samples / middle.samples, 3.0, 1e-3);
+	EXPECT_EQ(tuner->band(0, 2).samples, 0.0);
+	EXPECT_NEAR(slow.horizon, target, 2e-4);
+	EXPECT_NEAR(middle.horizon, target, 2e-4);
+}
+
+TEST(PredictionTuner, ANewTargetStartsOver)
+{
+	const auto tuner = make_tuner();
+	Glide glide;
+	glide.run(*tuner, 3.0, 0.5f, 0.8f);
+	ASSERT_GT(tuner->horizon(0, 0.5f), target * 1.1);
+
+	tuner->set_target(0.02);
+	EXPECT_FLOAT_EQ(tuner->horizon(0, 0.5f), 0.02f);
+	EXPECT_EQ(tuner->band(0, 1).samples, 0.0);
+
+	// Clamped to maxHorizon
+	tuner->set_target(1.0);
+	EXPECT_DOUBLE_EQ(tuner->target(), tuner->settings.maxHorizon);
+}
+
+TEST(PredictionTuner, DeviceLanesFollowObjectSlots)
+{
+	// Touch, then slots 1 and 3
+	uint64_t objects = 0b1010;
+	EXPECT_EQ(PredictionTuner::device_lane(0, objects), 0);
+	EXPECT_EQ(PredictionTuner::device_lane(1, objects), 1);
+	EXPECT_EQ(PredictionTuner::device_lane(2, objects), 3);
+	EXPECT_EQ(PredictionTuner::device_lane(3, objects), 5);
+	EXPECT_EQ(PredictionTuner::device_lane(4, objects), -1);
+	EXPECT_EQ(objects, 0u);
+}
+
+TEST(PredictionTuner, HorizonsGoToEveryJointByItsDevice)
+{
+	const auto tuner = make_tuner();
+	Glide glide;
+	glide.run(*tuner, 3.0, 0.5f, 0.8f); // Only lane 0 learns anything
+
+	JointFrame frame;
+	frame.jointCount = 3;
+	frame.objectMask = 0b100;
+	for (uint32_t i = 0; i < 3; i++)
+		frame.joints[i].linearVelocity[0] = 0.5f;
+
+	PoseExtrapolator::Horizons horizons;
+	horizons.fill(-1.f);
+	tuner->horizons(frame, horizons);
+	EXPECT_FLOAT_EQ(horizons[0], tuner->horizon(0, 0.5f));
+	EXPECT_FLOAT_EQ(horizons[1], static_cast<float>(target));
+	EXPECT_FLOAT_EQ(horizons[2], static_cast<float>(target));
+	EXPECT_EQ(horizons[3], 0.f); // Past the frame's joints
+}
@@ -0,0 +1,237 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "CommandWorker.h"
+#include "SessionWatchdog.h"
+#include "SimulatedPoseSource.h"
+
+namespace
+{
+	using namespace std::chrono_literals;
+
+	// Quick retries, so the backoff can be watched without waiting seconds
+	void retry_quickly(SessionWatchdog& watchdog)
+	{
+		watchdog.settings.retryDelay = 10ms;
+		watchdog.settings.maxRetryDelay = 40ms;
+	}
+
+	// Healthy signals every check, samples moving along with the clock
+	void feed_healthy(SessionWatchdog& watchdog, double& time, const int checks)
+	{
+		for (int i = 0; i < checks; i++)
+		{
+			time += watchdog.settings.checkInterval;
+			SessionSignals signals;
+			signals.sampleTime = time - 0.002;
+			watchdog.observe(time, signals);
+		}
+	}
+
+	bool wait_until_healthy(const SessionWatchdog& watchdog, const std::chrono::milliseconds timeout = 5000ms)
+	{
+		const auto until = std::chrono::steady_clock::now() + timeout;
+		while (watchdog.health() != SessionWatchdog::Session_Healthy && std::chrono::steady_clock::now() < until)
+			std::this_thread::sleep_for(1ms);
+		return watchdog.health() == SessionWatchdog::Session_Healthy;
+	}
+}
+
+TEST(SessionWatchdog, HealthySessionStaysHealthy)
+{
+	SessionWatchdog watchdog;
+	double time = 100.0;
+	feed_healthy(watchdog, time, 100);
+
+	EXPECT_EQ(watchdog.health(), SessionWatchdog::Session_Healthy);
+	EXPECT_EQ(watchdog.stats().losses, 0u);
+}
+
+TEST(SessionWatchdog, NoticesEveryKindOfLoss)
+{
+	const auto lose = [](SessionWatchdog& watchdog, const auto& signal)
+	{
+		double time = 100.0;
+		feed_healthy(watchdog, time, 5);
+
+		SessionSignals signals;
+		signals.sampleTime = time;
+		signal(signals);
+		watchdog.observe(time + watchdog.settings.checkInterval, signals);
+	};
+
+	SessionWatchdog recreate, display;
+	lose(recreate, [](SessionSignals& s) { s.shouldRecreate = true; });
+	EXPECT_EQ(recreate.health(), SessionWatchdog::Session_Lost);
+	EXPECT_EQ(recreate.stats().lastCause, SessionWatchdog::Loss_Recreate);
+
+	lose(display, [](SessionSignals& s) { s.displayLost = true; });
+	EXPECT_EQ(display.health(), SessionWatchdog::Session_Lost);
+	EXPECT_EQ(display.stats().lastCause, SessionWatchdog::Loss_DisplayLost);
+}
+
+TEST(SessionWatchdog, FailingCallsNeedSeveralChecksInARow)
+{
+	SessionWatchdog watchdog;
+	double time = 100.0;
+	feed_healthy(watchdog, time, 5);
+
+	SessionSignals failing;
+	failing.errors = 3;
+
+	// One short, then a clean check starts the count over
+	for (uint32_t i = 0; i + 1 < watchdog.settings.errorChecks; i++)
+	{
+		failing.sampleTime = time += watchdog.settings.checkInterval;
+		watchdog.observe(time, failing);
+	}
+	feed_healthy(watchdog, time, 1);
+	EXPECT_EQ(watchdog.health(), SessionWatchdog::Session_Healthy);
+
+	for (uint32_t i = 0; i < watchdog.settings.errorChecks; i++)
+	{
+		failing.sampleTime = time += watchdog.settings.checkInterval;
+		watchdog.observe(time, failing);
+	}
+	EXPECT_EQ(watchdog.health(), SessionWatchdog::Session_Lost);
+	EXPECT_EQ(watchdog.stats().lastCause, SessionWatchdog::Loss_Errors);
+}
+
+TEST(SessionWatchdog, StalledSampleTimesOnlyCountOnceSamplesCameIn)
+{
+	// Nothing was ever tracked: quiet, but not stalled
+	SessionWatchdog quiet;
+	for (double time = 100.0; time < 102.0; time += quiet.settings.checkInterval)
+		quiet.observe(time, SessionSignals{});
+	EXPECT_EQ(quiet.health(), SessionWatchdog::Session_Healthy);
+
+	// Samples stop moving after they've been coming: lost once stallSeconds went by
+	SessionWatchdog watchdog;
+	double time = 100.0;
+	feed_healthy(watchdog, time, 5);
+
+	SessionSignals frozen;
+	frozen.sampleTime = time;
+	const double stalled_at = time;
+	while (watchdog.health() == SessionWatchdog::Session_Healthy && time < stalled_at + 1.0)
+		watchdog.observe(time += watchdog.settings.checkInterval, frozen);
+
+	EXPECT_EQ(watchdog.health(), SessionWatchdog::Session_Lost);
+	EXPECT_EQ(watchdog.stats().lastCause, SessionWatchdog::Loss_Stalled);
+	EXPECT_GE(time - stalled_at, watchdog.settings.stallSeconds - 1e-9);
+	EXPECT_LE(time - stalled_at, watchdog.settings.stallSeconds + 2 * watchdog.settings.checkInterval);
+}
+
+TEST(SessionWatchdog, RetriesFailedRecreatesWithBackoff)
+{
+	SessionWatchdog watchdog;
+	retry_quickly(watchdog);
+	CommandWorker worker;
+	worker.start();
+
+	double time = 100.0;
+	feed_healthy(watchdog, time, 5);
+	SessionSignals signals;
+	signals.shouldRecreate = true;
+	watchdog.observe(time += 0.02, signals);
+	ASSERT_EQ(watchdog.health(), SessionWatchdog::Session_Lost);
+
+	// Fails 4 times: waits 10 + 20 + 40 + 40 ms (capped) in between
+	std::atomic<int> calls = 0;
+	const auto started = std::chrono::steady_clock::now();
+	watchdog.recover(worker, [&] { return ++calls > 4; });
+	EXPECT_NE(watchdog.health(), SessionWatchdog::Session_Lost);
+
+	ASSERT_TRUE(wait_until_healthy(watchdog));
+	const auto took = std::chrono::steady_clock::now() - started;
+	worker.stop();
+
+	EXPECT_EQ(calls.load(), 5);
+	EXPECT_EQ(watchdog.stats().attempts, 5u);
+	EXPECT_EQ(watchdog.stats().losses, 1u);
+	EXPECT_GE(took, 110ms);
+	EXPECT_GT(watchdog.stats().lastMilliseconds, 0.0);
+
+	// Recovered, so it's watching again from scratch
+	feed_healthy(watchdog, time, 20);
+	EXPECT_EQ(watchdog.health(), SessionWatchdog::Session_Healthy);
+}
+
+TEST(SessionWatchdog, ResetDropsAttemptsInFlight)
+{
+	SessionWatchdog watchdog;
+	retry_quickly(watchdog);
+	CommandWorker worker;
+	worker.start();
+
+	double time = 100.0;
+	feed_healthy(watchdog, time, 5);
+	SessionSignals signals;
+	signals.displayLost = true;
+	watchdog.observe(time += 0.02, signals);
+
+	std::atomic<int> calls = 0;
+	watchdog.recover(worker, [&] { return ++calls, false; });
+	while (calls == 0) std::this_thread::sleep_for(1ms);
+
+	watchdog.reset();
+	const int after_reset = calls;
+	std::this_thread::sleep_for(100ms);
+	worker.stop();
+
+	EXPECT_EQ(watchdog.health(), SessionWatchdog::Session_Healthy);
+	EXPECT_LE(calls.load(), after_reset + 1); // At most the one that was already running
+}
+
+TEST(SessionWatchdog, RecoversSimulatedSessionsThatFailToRecreate)
+{
+	SimulationSettings settings;
+	settings.objects = 2;
+	settings.dropoutEvery = 0.0;
+	settings.sessionLossEvery = 0.2;
+	settings.recreateFailures = 2;
+	SimulatedPoseSource source(settings);
+	source.set_fixed_step(0.001);
+
+	SessionWatchdog watchdog;
+	retry_quickly(watchdog);
+	CommandWorker worker;
+	worker.start();
+
+	// Sample like the poll thread, stop while the session's down like update() does
+	JointFrame frame;
+	uint32_t recovered = 0;
+	for (int n = 0; n < 20000 && recovered < 4; n++)
+	{
+		acquire_frame(source, frame, 0.0, first_object_slots(settings.objects));
+		if (watchdog.due(frame.sdkTime))
+		{
+			SessionSignals signals = source.session_signals();
+			for (uint32_t i = 0; i < frame.jointCount; i++)
+				signals.sampleTime = std::max<double>(signals.sampleTime, frame.joints[i].sampleTime);
+			watchdog.observe(frame.sdkTime, signals);
+		}
+
+		if (watchdog.health() == SessionWatchdog::Session_Lost)
+		{
+			const uint64_t attempts = watchdog.stats().attempts;
+			watchdog.recover(worker, [&source] { return source.recreate_session(); });
+			ASSERT_TRUE(wait_until_healthy(watchdog));
+
+			// Every loss takes two failed attempts before the third goes through
+			EXPECT_EQ(watchdog.stats().attempts - attempts, 3u);
+			recovered++;
+		}
+	}
+	worker.stop();
+
+	EXPECT_EQ(recovered, 4u);
+	EXPECT_EQ(watchdog.stats().losses, 4u);
+
+	// And the source is tracking again
+	acquire_frame(source, frame, 0.0, first_object_slots(settings.objects));
+	EXPECT_TRUE(frame.joints[0].statusFlags & status_position_tracked);
+}
@@ -0,0 +1,215 @@
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "SettingsStore.h"
+
+namespace
+{
+	// What an older build saved: everything up to 'rate'
+	struct OldSettings
+	{
+		int prediction = 11;
+		bool enabled = true;
+		int rate = 500;
+
+		template <class Archive>
+		void serialize(Archive& archive)
+		{
+			settings_fields(archive, CEREAL_NVP(prediction), CEREAL_NVP(enabled), CEREAL_NVP(rate));
+		}
+	};
+
+	// This build's, one field more
+	struct NewSettings
+	{
+		int prediction = 11;
+		bool enabled = true;
+		int rate = 500;
+		std::string address = "127.0.0.1";
+
+		template <class Archive>
+		void serialize(Archive& archive)
+		{
+			settings_fields(archive, CEREAL_NVP(prediction), CEREAL_NVP(enabled), CEREAL_NVP(rate),
+			                CEREAL_NVP(address));
+		}
+	};
+
+	// An XML and cache of their own per test, gone afterwards
+	class SettingsStoreTest : public testing::Test
+	{
+	protected:
+		void SetUp() override
+		{
+			const std::string name = std::string("riftcv1_") +
+				testing::UnitTest::GetInstance()->current_test_info()->name();
+			xml = std::filesystem::temp_directory_path() / (name + ".xml");
+			cache = std::filesystem::temp_directory_path() / (name + ".bin");
+			TearDown();
+		}
+
+		void TearDown() override
+		{
+			std::error_code error;
+			std::filesystem::remove(xml, error);
+			std::filesystem::remove(cache, error);
+		}
+
+		[[nodiscard]] std::string read(const std::filesystem::path& path) const
+		{
+			std::ifstream input(path, std::ios::binary);
+			return {std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>()};
+		}
+
+		template <class T>
+		void save(T settings)
+		{
+			SettingsStore<T> store(xml, cache);
+			store.store(settings);
+			store.flush();
+			ASSERT_EQ(store.writes(), 1u);
+		}
+
+		std::filesystem::path xml;
+		std::filesystem::path cache;
+	};
+}
+
+TEST_F(SettingsStoreTest, MissingAndBrokenFiles)
+{
+	SettingsStore<NewSettings> store(xml, cache);
+	NewSettings settings;
+	EXPECT_EQ(store.load(settings), SettingsStore<NewSettings>::Load_Missing);
+
+	std::ofstream(xml) << "<?xml version=\"1.0\"?><cereal><prediction>";
+	EXPECT_EQ(store.load(settings), SettingsStore<NewSettings>::Load_Failed);
+}
+
+TEST_F(SettingsStoreTest, RoundTripsThroughTheXmlThenTheCache)
+{
+	NewSettings saved;
+	saved.prediction = 20;
+	saved.enabled = false;
+	saved.address = "192.168.1.2";
+	save(saved);
+
+	// Cache written alongside the XML, so no XML parsing at all next time
+	SettingsStore<NewSettings> store(xml, cache);
+	NewSettings loaded;
+	EXPECT_EQ(store.load(loaded), SettingsStore<NewSettings>::Load_Cache);
+	EXPECT_EQ(loaded.prediction, 20);
+	EXPECT_FALSE(loaded.enabled);
+	EXPECT_EQ(loaded.address, "192.168.1.2");
+
+	// Without it the XML says the same
+	std::filesystem::remove(cache);
+	loaded = {};
+	EXPECT_EQ(store.load(loaded), SettingsStore<NewSettings>::Load_Xml);
+	EXPECT_EQ(loaded.prediction, 20);
+	EXPECT_FALSE(loaded.enabled);
+	EXPECT_EQ(loaded.address, "192.168.1.2");
+}
+
+TEST_F(SettingsStoreTest, LoadsWhatAnOlderFileHasAndDefaultsTheRest)
+{
+	OldSettings old;
+	old.prediction = 30;
+	old.rate = 1000;
+	save(old);
+
+	// The cache is the old layout's: rejected by its schema, the XML is read field by field
+	SettingsStore<NewSettings> store(xml, cache);
+	NewSettings loaded;
+	loaded.address = "10.0.0.1"; // Already there, not in the file: left alone
+	EXPECT_EQ(store.load(loaded), SettingsStore<NewSettings>::Load_Xml);
+	EXPECT_EQ(loaded.prediction, 30);
+	EXPECT_TRUE(loaded.enabled);
+	EXPECT_EQ(loaded.rate, 1000);
+	EXPECT_EQ(loaded.address, "10.0.0.1");
+}
+
+TEST_F(SettingsStoreTest, ACacheFromAnotherLayoutIsNeverRead)
+{
+	NewSettings saved;
+	saved.prediction = 40;
+	save(saved);
+
+	// Same XML, the older layout: its binary archive would read garbage
+	SettingsStore<OldSettings> old(xml, cache);
+	OldSettings loaded;
+	EXPECT_EQ(old.load(loaded), SettingsStore<OldSettings>::Load_Xml);
+	EXPECT_EQ(loaded.prediction, 40);
+
+	// And that load left a cache for the older layout, which it reads next time
+	EXPECT_EQ(old.load(loaded), SettingsStore<OldSettings>::Load_Cache);
+
+	// But this build doesn't
+	SettingsStore<NewSettings> current(xml, cache);
+	NewSettings reloaded;
+	EXPECT_EQ(current.load(reloaded), SettingsStore<NewSettings>::Load_Xml);
+	EXPECT_EQ(reloaded.prediction, 40);
+}
+
+TEST_F(SettingsStoreTest, LoadingTheXmlOnlyWritesTheCache)
+{
+	OldSettings old;
+	old.rate = 250;
+	save(old);
+	std::filesystem::remove(cache);
+
+	const std::string before = read(xml);
+	const auto written = std::filesystem::last_write_time(xml);
+	{
+		SettingsStore<NewSettings> store(xml, cache, std::chrono::milliseconds(0));
+		NewSettings loaded;
+		EXPECT_EQ(store.load(loaded), SettingsStore<NewSettings>::Load_Xml);
+		EXPECT_EQ(store.writes(), 0u);
+	}
+
+	// Hand-edited file stays exactly as it was, not rewritten in this build's layout
+	EXPECT_EQ(read(xml), before);
+	EXPECT_EQ(std::filesystem::last_write_time(xml), written);
+	EXPECT_TRUE(std::filesystem::exists(cache));
+
+	SettingsStore<NewSettings> store(xml, cache);
+	NewSettings loaded;
+	EXPECT_EQ(store.load(loaded), SettingsStore<NewSettings>::Load_Cache);
+	EXPECT_EQ(loaded.rate, 250);
+}
+
+TEST_F(SettingsStoreTest, AnEditedXmlWinsOverTheCache)
+{
+	NewSettings saved;
+	saved.prediction = 5;
+	save(saved);
+
+	std::string text = read(xml);
+	const size_t at = text.find(">5<");
+	ASSERT_NE(at, std::string::npos);
+	text.replace(at, 3, ">15<");
+	std::ofstream(xml, std::ios::binary) << text;
+
+	SettingsStore<NewSettings> store(xml, cache);
+	NewSettings loaded;
+	EXPECT_EQ(store.load(loaded), SettingsStore<NewSettings>::Load_Xml);
+	EXPECT_EQ(loaded.prediction, 15);
+}
+
+TEST_F(SettingsStoreTest, SaysSoWhenItCantWrite)
+{
+	const std::filesystem::path nowhere = xml / "not_a_directory" / "settings.xml";
+	SettingsStore<NewSettings> store(nowhere, cache);
+
+	std::wstring error;
+	store.on_error = [&error](std::wstring message) { error = std::move(message); };
+	store.store(NewSettings{});
+	store.flush();
+
+	EXPECT_FALSE(error.empty());
+	EXPECT_EQ(store.writes(), 0u);
+	EXPECT_FALSE(std::filesystem::exists(cache));
+}
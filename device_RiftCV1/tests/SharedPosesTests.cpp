@@ -0,0 +1,205 @@
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+#include "PoseExport.h"
+#include "SharedPoses.h"
+#include "SimulatedPoseSource.h"
+
+namespace
+{
+	// A region of its own per test (and per run), so nothing left behind gets read
+	std::string region_name()
+	{
+#ifdef _WIN32
+		const unsigned long process = GetCurrentProcessId();
+#else
+		const unsigned long process = static_cast<unsigned long>(getpid());
+#endif
+		return std::string("riftcv1_") + testing::UnitTest::GetInstance()->current_test_info()->name() +
+			"_" + std::to_string(process);
+	}
+
+	// Every joint's x is the frame number, so a torn read shows up as a mix
+	void numbered_frame(JointFrame& frame, const uint64_t number, const uint32_t joints)
+	{
+		frame.jointCount = joints;
+		frame.objectMask = first_object_slots(joints - 2);
+		frame.frameTime = static_cast<double>(number);
+		for (uint32_t i = 0; i < joints; i++)
+		{
+			frame.joints[i].position[0] = static_cast<float>(number);
+			frame.joints[i].sampleTime = static_cast<double>(number);
+		}
+	}
+}
+
+TEST(SharedPoseReader, NothingToOpenWithoutThePlugin)
+{
+	SharedPoseReader reader;
+	EXPECT_FALSE(reader.open(region_name().c_str()));
+	EXPECT_FALSE(reader.is_open());
+
+	SharedPoseSnapshot snapshot;
+	EXPECT_EQ(reader.read(snapshot), SharedPoseReader::Read_Closed);
+}
+
+TEST(SharedPoseReader, ReadsWhatWasPublished)
+{
+	const std::string name = region_name();
+	PoseExport exporter;
+	ASSERT_TRUE(exporter.open(name.c_str(), 1234));
+
+	SharedPoseReader reader;
+	ASSERT_TRUE(reader.open(name.c_str()));
+
+	// Nothing published yet: an empty frame, not garbage
+	SharedPoseSnapshot snapshot;
+	EXPECT_EQ(reader.read(snapshot), SharedPoseReader::Read_Ok);
+	EXPECT_EQ(snapshot.poseCount, 0u);
+	EXPECT_EQ(snapshot.writerProcess, 1234u);
+
+	SimulationSettings settings;
+	settings.objects = 0;
+	settings.dropoutEvery = 0.0;
+	SimulatedPoseSource source(settings);
+	source.set_fixed_step(0.001);
+	source.connect(4);
+	source.connect(33);
+
+	JointFrame frame;
+	acquire_frame(source, frame, 0.0, source.connected_objects());
+	exporter.publish(frame, 5000);
+
+	ASSERT_EQ(reader.read(snapshot), SharedPoseReader::Read_Ok);
+	EXPECT_EQ(snapshot.frames, 1u);
+	EXPECT_EQ(snapshot.publishedAt, 5000);
+	EXPECT_EQ(snapshot.frameTime, frame.frameTime);
+	EXPECT_EQ(snapshot.objectMask, frame.objectMask);
+	ASSERT_EQ(snapshot.poseCount, 4u);
+
+	// Hands, then the VR Objects under their own slot numbers
+	const uint32_t devices[] = {0, 1, 2 + 4, 2 + 33};
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		EXPECT_EQ(snapshot.poses[i].device, devices[i]);
+		EXPECT_EQ(snapshot.poses[i].sampleTime, frame.joints[i].sampleTime);
+		EXPECT_EQ(snapshot.poses[i].statusFlags, frame.joints[i].statusFlags);
+		for (int c = 0; c < 3; c++)
+			EXPECT_EQ(snapshot.poses[i].position[c], frame.joints[i].position[c]);
+		for (int c = 0; c < 4; c++)
+			EXPECT_EQ(snapshot.poses[i].orientation[c], frame.joints[i].orientation[c]);
+	}
+
+	// Same frame again is nothing new, the next one is
+	EXPECT_EQ(reader.read(snapshot), SharedPoseReader::Read_Unchanged);
+	acquire_frame(source, frame, 0.0, source.connected_objects());
+	exporter.publish(frame, 6000);
+	EXPECT_EQ(reader.read(snapshot), SharedPoseReader::Read_Ok);
+	EXPECT_EQ(snapshot.frames, 2u);
+}
+
+TEST(SharedPoseReader, RefusesLayoutsItDoesntKnow)
+{
+	const std::string name = region_name();
+	SharedMemory memory;
+	ASSERT_TRUE(memory.open(name.c_str(), shared_poses_size, true));
+
+	SharedPosesHeader& header = *reinterpret_cast<SharedPosesHeader*>(memory.data());
+	header = SharedPosesHeader{};
+	header.version = shared_poses_version + 1;
+
+	SharedPoseReader reader;
+	EXPECT_FALSE(reader.open(name.c_str()));
+
+	header.version = shared_poses_version;
+	header.poseSize = sizeof(SharedPose) + 8;
+	EXPECT_FALSE(reader.open(name.c_str()));
+
+	header.poseSize = sizeof(SharedPose);
+	EXPECT_TRUE(reader.open(name.c_str()));
+}
+
+TEST(SharedPoseReader, NeverSeesAHalfWrittenFrame)
+{
+	const std::string name = region_name();
+	PoseExport exporter;
+	ASSERT_TRUE(exporter.open(name.c_str()));
+
+	SharedPoseReader reader;
+	ASSERT_TRUE(reader.open(name.c_str()));
+
+	// Publishes flat out until the reader got its share of frames in, or time's up
+	std::atomic<bool> done = false;
+	std::atomic<uint64_t> published = 0;
+	std::thread writer([&]
+	{
+		JointFrame frame;
+		for (uint64_t n = 1; !done; n++)
+		{
+			numbered_frame(frame, n, 2 + static_cast<uint32_t>(n % 40));
+			exporter.publish(frame, static_cast<long long>(n));
+			published = n;
+		}
+	});
+
+	// Header and every pose from the one frame, and frames only ever go forward
+	const auto consistent = [](const SharedPoseSnapshot& snapshot, const uint64_t last)
+	{
+		const auto number = static_cast<uint64_t>(snapshot.publishedAt);
+		bool same = snapshot.frames == number && snapshot.poseCount == 2 + number % 40 && number > last;
+		for (uint32_t i = 0; i < snapshot.poseCount; i++)
+			same = same && snapshot.poses[i].position[0] == static_cast<float>(number);
+		return same;
+	};
+
+	SharedPoseSnapshot snapshot;
+	uint64_t reads = 0, torn = 0, last = 0;
+	const auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(300);
+	while (reads < 2000 && std::chrono::steady_clock::now() < until)
+	{
+		if (reader.read(snapshot, 1000) != SharedPoseReader::Read_Ok || snapshot.frames == 0) continue;
+		reads++;
+		if (!consistent(snapshot, last)) torn++;
+		last = static_cast<uint64_t>(snapshot.publishedAt);
+	}
+	done = true;
+	writer.join();
+
+	EXPECT_GT(reads, 0u); // Only a few hundred on a single core
+	EXPECT_EQ(torn, 0u);
+	EXPECT_NE(reader.read(snapshot), SharedPoseReader::Read_Busy);
+	EXPECT_EQ(snapshot.frames, published.load());
+}
+
+TEST(SharedPoseReader, ReadersKeepTheirMappingWhenThePluginGoes)
+{
+	const std::string name = region_name();
+	auto exporter = std::make_unique<PoseExport>();
+	ASSERT_TRUE(exporter->open(name.c_str()));
+
+	JointFrame frame;
+	numbered_frame(frame, 7, 3);
+	exporter->publish(frame, 7);
+
+	SharedPoseReader reader;
+	ASSERT_TRUE(reader.open(name.c_str()));
+	exporter.reset();
+
+	// The name's gone with the plugin, the last frame stays readable
+	SharedPoseReader late;
+	EXPECT_FALSE(late.open(name.c_str()));
+
+	SharedPoseSnapshot snapshot;
+	ASSERT_EQ(reader.read(snapshot), SharedPoseReader::Read_Ok);
+	EXPECT_EQ(snapshot.frames, 1u);
+	EXPECT_EQ(snapshot.poses[2].position[0], 7.0f);
+}
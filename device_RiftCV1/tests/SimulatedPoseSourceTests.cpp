@@ -0,0 +1,115 @@
+#include <bit>
+#include <cstdint>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#include "PredictionTuner.h"
+#include "SimulatedPoseSource.h"
+
+namespace
+{
+	SimulationSettings steady_settings(const uint32_t objects)
+	{
+		SimulationSettings settings;
+		settings.objects = objects;
+		settings.dropoutEvery = 0.0;
+		return settings;
+	}
+}
+
+TEST(SimulatedPoseSource, ConnectAndDisconnectChangeTheScannedSlots)
+{
+	SimulatedPoseSource source(steady_settings(2));
+	EXPECT_EQ(source.connected_objects(), 0b11u);
+
+	source.connect(5);
+	source.connect(63);
+	EXPECT_EQ(source.connected_objects(), 0b11u | 1ull << 5 | 1ull << 63);
+
+	source.disconnect(0);
+	source.disconnect(63);
+	source.disconnect(40); // Never connected, nothing happens
+	EXPECT_EQ(source.connected_objects(), 0b10u | 1ull << 5);
+}
+
+TEST(SimulatedPoseSource, HotPluggedSlotsLandInTheirOwnJoints)
+{
+	// Same clock for both: each frame reads the time once
+	SimulatedPoseSource source(steady_settings(0)), everything(steady_settings(64));
+	source.set_fixed_step(0.001);
+	everything.set_fixed_step(0.001);
+
+	source.connect(3);
+	source.connect(17);
+	source.connect(42);
+
+	JointFrame frame, reference;
+	acquire_frame(source, frame, 0.0, source.connected_objects());
+	acquire_frame(everything, reference, 0.0, everything.connected_objects());
+
+	ASSERT_EQ(frame.jointCount, 5u);
+	EXPECT_EQ(frame.objectMask, 1ull << 3 | 1ull << 17 | 1ull << 42);
+
+	// Lowest slot first, each one the very pose that slot has with everything connected
+	const uint32_t slots[] = {3, 17, 42};
+	for (uint32_t i = 0; i < 3; i++)
+		for (int c = 0; c < 3; c++)
+			EXPECT_FLOAT_EQ(frame.joints[2 + i].position[c], reference.joints[2 + slots[i]].position[c]);
+
+	// And the lanes everything else keys its per-device state on follow the slot
+	uint64_t objects = frame.objectMask;
+	EXPECT_EQ(PredictionTuner::device_lane(0, objects), 0);
+	EXPECT_EQ(PredictionTuner::device_lane(1, objects), 1);
+	EXPECT_EQ(PredictionTuner::device_lane(2, objects), 2 + 3);
+	EXPECT_EQ(PredictionTuner::device_lane(3, objects), 2 + 17);
+	EXPECT_EQ(PredictionTuner::device_lane(4, objects), 2 + 42);
+	EXPECT_EQ(PredictionTuner::device_lane(5, objects), -1);
+}
+
+TEST(SimulatedPoseSource, UnpluggingKeepsTheOthersWhereTheyAre)
+{
+	SimulatedPoseSource source(steady_settings(4));
+	source.set_fixed_step(0.001);
+
+	JointFrame before, after;
+	acquire_frame(source, before, 0.0, source.connected_objects());
+	ASSERT_EQ(before.jointCount, 6u);
+
+	source.disconnect(1);
+	acquire_frame(source, after, 0.0, source.connected_objects());
+	ASSERT_EQ(after.jointCount, 5u);
+	EXPECT_EQ(after.objectMask, 0b1101u);
+
+	// Slots 2 and 3 moved up a joint, but they're still the same devices (1 ms on, barely moved)
+	for (const auto& [joint_before, joint_after] : {std::pair{2, 2}, std::pair{4, 3}, std::pair{5, 4}})
+		for (int c = 0; c < 3; c++)
+			EXPECT_NEAR(after.joints[joint_after].position[c], before.joints[joint_before].position[c], 0.005);
+}
+
+TEST(SimulatedPoseSource, ScanAndSampleFromDifferentThreads)
+{
+	SimulatedPoseSource source(steady_settings(0));
+	std::atomic<bool> done = false;
+
+	// The background scan plugs things in and out while frames are taken
+	std::thread scanner([&]
+	{
+		for (uint32_t n = 0; n < 2000; n++)
+		{
+			source.connect(n % 64);
+			source.disconnect((n + 32) % 64);
+		}
+		done = true;
+	});
+
+	JointFrame frame;
+	while (!done)
+	{
+		const uint64_t objects = source.connected_objects();
+		acquire_frame(source, frame, 0.0, objects);
+		EXPECT_EQ(frame.jointCount, 2u + std::popcount(objects));
+		EXPECT_EQ(frame.objectMask, objects);
+	}
+	scanner.join();
+}
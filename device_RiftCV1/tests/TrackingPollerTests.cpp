@@ -0,0 +1,191 @@
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#ifndef _WIN32
+#include <time.h>
+#endif
+
+#include "TrackingPoller.h"
+
+namespace
+{
+	// Every field carries the same number, a torn read shows up as a mismatch
+	struct Stamped
+	{
+		std::array<uint64_t, 64> values{};
+	};
+
+	// CPU time the calling thread used so far
+	double thread_cpu_seconds()
+	{
+#ifdef _WIN32
+		FILETIME created, exited, kernel, user;
+		GetThreadTimes(GetCurrentThread(), &created, &exited, &kernel, &user);
+		const auto ticks = [](const FILETIME& time)
+		{
+			return static_cast<double>(static_cast<uint64_t>(time.dwHighDateTime) << 32 | time.dwLowDateTime);
+		};
+		return (ticks(kernel) + ticks(user)) * 1e-7;
+#else
+		timespec time{};
+		clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+		return static_cast<double>(time.tv_sec) + static_cast<double>(time.tv_nsec) * 1e-9;
+#endif
+	}
+}
+
+TEST(TripleBuffer, FetchIsFalseUntilSomethingIsPublished)
+{
+	TripleBuffer<int> buffer;
+	EXPECT_FALSE(buffer.fetch());
+
+	buffer.write_buffer() = 7;
+	buffer.publish();
+	EXPECT_TRUE(buffer.fetch());
+	EXPECT_EQ(buffer.read_buffer(), 7);
+
+	// Nothing new, the reader keeps what it has
+	EXPECT_FALSE(buffer.fetch());
+	EXPECT_EQ(buffer.read_buffer(), 7);
+}
+
+TEST(TripleBuffer, ReaderGetsTheNewestOfSeveralPublishes)
+{
+	TripleBuffer<int> buffer;
+	for (int i = 1; i <= 5; i++)
+	{
+		buffer.write_buffer() = i;
+		buffer.publish();
+	}
+
+	ASSERT_TRUE(buffer.fetch());
+	EXPECT_EQ(buffer.read_buffer(), 5);
+}
+
+TEST(TripleBuffer, ConcurrentReaderNeverSeesTornOrOlderValues)
+{
+	TripleBuffer<Stamped> buffer;
+	constexpr uint64_t published = 200000;
+	std::atomic<bool> done = false;
+
+	std::thread writer([&]
+	{
+		for (uint64_t n = 1; n <= published; n++)
+		{
+			buffer.write_buffer().values.fill(n);
+			buffer.publish();
+		}
+		done = true;
+	});
+
+	uint64_t last = 0, fetched = 0;
+	bool torn = false, backwards = false;
+	const auto check = [&]
+	{
+		const Stamped& value = buffer.read_buffer();
+		for (const uint64_t v : value.values)
+			torn |= v != value.values[0];
+		backwards |= value.values[0] < last;
+		last = value.values[0];
+		fetched++;
+	};
+
+	while (!done)
+		if (buffer.fetch()) check();
+	writer.join();
+	if (buffer.fetch()) check();
+
+	EXPECT_FALSE(torn);
+	EXPECT_FALSE(backwards);
+	EXPECT_EQ(last, published); // The very last one always gets through
+	EXPECT_GT(fetched, 0u);
+}
+
+TEST(TrackingPoller, PublishesNumberedFramesFromItsOwnThread)
+{
+	TrackingPoller poller;
+	std::atomic<std::thread::id> sampled_on{};
+
+	poller.start([&](JointFrame& frame)
+	{
+		sampled_on = std::this_thread::get_id();
+		frame.jointCount = 2;
+		frame.frameTime = static_cast<double>(frame.sequence + 1);
+	}, 1000);
+	EXPECT_TRUE(poller.running());
+
+	uint64_t last = 0;
+	const auto until = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	while (last < 20 && std::chrono::steady_clock::now() < until)
+	{
+		if (poller.fetch())
+		{
+			EXPECT_GT(poller.latest().sequence, last);
+			last = poller.latest().sequence;
+			EXPECT_EQ(poller.latest().jointCount, 2u);
+		}
+		std::this_thread::sleep_for(std::chrono::microseconds(200));
+	}
+
+	poller.stop();
+	EXPECT_FALSE(poller.running());
+	EXPECT_GE(last, 20u);
+	EXPECT_GE(poller.frames_published(), last);
+	EXPECT_NE(sampled_on.load(), std::this_thread::get_id());
+
+	// Stopped means stopped
+	const uint64_t published = poller.frames_published();
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	EXPECT_EQ(poller.frames_published(), published);
+}
+
+TEST(PeriodWaiter, NeverWakesEarly)
+{
+	const PeriodWaiter waiter;
+	const std::atomic<bool> stop = false;
+
+	for (const auto wait : {std::chrono::microseconds(100), std::chrono::microseconds(1500),
+	                        std::chrono::microseconds(4000)})
+	{
+		const auto deadline = PeriodWaiter::clock::now() + wait;
+		waiter.wait_until(deadline, stop);
+		EXPECT_GE(PeriodWaiter::clock::now(), deadline);
+	}
+
+	// Already stopping: no spinning out the rest
+	const std::atomic<bool> stopping = true;
+	const auto start = PeriodWaiter::clock::now();
+	waiter.wait_until(start + waiter.margin() / 2, stopping);
+	EXPECT_LT(PeriodWaiter::clock::now() - start, waiter.margin());
+}
+
+TEST(TrackingPoller, SleepsThroughMostOfEveryPeriod)
+{
+	// 500 Hz, the default: used to spin-yield away all of every 2 ms period
+	TrackingPoller poller;
+	std::atomic<uint64_t> samples = 0;
+	std::atomic<double> first_cpu = 0.0, last_cpu = 0.0;
+
+	poller.start([&](JointFrame&)
+	{
+		const double cpu = thread_cpu_seconds();
+		if (samples++ == 0) first_cpu = cpu;
+		last_cpu = cpu;
+	}, 500);
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(600));
+	poller.stop();
+
+	const uint64_t periods = samples - 1;
+	ASSERT_GT(periods, 100u); // Still keeping up, roughly
+	const double cpu_per_period_us = (last_cpu - first_cpu) / static_cast<double>(periods) * 1e6;
+	RecordProperty("cpu_us_per_period", static_cast<int>(cpu_per_period_us));
+
+	// Waking up, sampling and spinning the sleep's margin, out of 2000 us
+	EXPECT_LT(cpu_per_period_us, 1000.0);
+}
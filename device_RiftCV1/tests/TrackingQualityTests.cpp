@@ -0,0 +1,190 @@
+#include <cmath>
+#include <cstdint>
+#include <numbers>
+#include <random>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "TrackingQuality.h"
+
+namespace
+{
+	constexpr uint32_t tracked = status_orientation_tracked | status_position_tracked;
+	constexpr double step = 0.002; // 500 Hz
+
+	// Both Touch sampled at 't', still at the origin unless the test moves them
+	JointFrame touch_frame(const double t, const uint32_t flags = tracked)
+	{
+		JointFrame frame;
+		frame.frameTime = t;
+		frame.jointCount = 2;
+		for (uint32_t i = 0; i < 2; i++)
+		{
+			frame.joints[i].sampleTime = t;
+			frame.joints[i].statusFlags = flags;
+		}
+		return frame;
+	}
+
+	TrackingQuality::JointQuality summary_of(const TrackingQuality& quality, const size_t device)
+	{
+		TrackingQuality::Summary summary;
+		quality.summary(summary);
+		return summary[device];
+	}
+}
+
+TEST(TrackingQuality, CountsAndTimesDropouts)
+{
+	TrackingQuality quality;
+
+	// Tracked, lost for 0.2 s, back, lost for 0.5 s, back
+	int n = 0;
+	const auto run = [&](const int frames, const uint32_t flags)
+	{
+		for (const int end = n + frames; n < end; n++)
+			quality.observe(touch_frame(1.0 + n * step, flags));
+	};
+	run(500, tracked);
+	run(100, status_orientation_tracked);
+	run(500, tracked);
+	run(250, 0);
+
+	// The ongoing one already counts
+	TrackingQuality::JointQuality joint = summary_of(quality, 0);
+	EXPECT_FALSE(joint.tracked);
+	EXPECT_EQ(joint.dropouts, 2u);
+	EXPECT_NEAR(joint.dropoutSeconds, 0.7, 1e-3);
+	EXPECT_NEAR(joint.longestDropout, 0.5, 1e-3);
+
+	run(500, tracked);
+	joint = summary_of(quality, 0);
+	EXPECT_TRUE(joint.tracked);
+	EXPECT_EQ(joint.dropouts, 2u);
+	EXPECT_NEAR(joint.dropoutSeconds, 0.7, 1e-3);
+	EXPECT_EQ(joint.samples, 1850u);
+}
+
+TEST(TrackingQuality, FlagsGapsAgainstTheMeanInterval)
+{
+	TrackingQuality quality;
+	double t = 1.0;
+	for (int n = 0; n < 500; n++, t += step)
+		quality.observe(touch_frame(t));
+
+	TrackingQuality::JointQuality joint = summary_of(quality, 0);
+	EXPECT_NEAR(joint.meanInterval, 2.0, 0.01);
+	EXPECT_EQ(joint.gaps, 0u);
+
+	// Frames keep coming, the samples in them don't: only joint 0's
+	for (int n = 0; n < 10; n++, t += step)
+	{
+		JointFrame frame = touch_frame(t);
+		frame.joints[0].sampleTime = t - n * step;
+		quality.observe(frame);
+	}
+	quality.observe(touch_frame(t));
+
+	joint = summary_of(quality, 0);
+	EXPECT_EQ(joint.gaps, 1u);
+	EXPECT_NEAR(joint.peakInterval, 20.0, 0.5);
+	EXPECT_EQ(joint.dropouts, 0u); // Late isn't lost
+	EXPECT_EQ(summary_of(quality, 1).gaps, 0u);
+
+	// Just a bit late isn't a gap
+	t += 3 * step;
+	quality.observe(touch_frame(t));
+	EXPECT_EQ(summary_of(quality, 0).gaps, 1u);
+}
+
+TEST(TrackingQuality, OutliersOnlyCountOnceWarmedUp)
+{
+	TrackingQuality quality;
+	std::mt19937 random(3);
+	std::normal_distribution<float> noise(0.f, 0.01f);
+
+	// Moving at 0.5 m/s, a bogus 3 m/s sample early on and one much later
+	const auto frame_at = [&](const int n)
+	{
+		JointFrame frame = touch_frame(1.0 + n * step);
+		const bool spike = n == 10 || n == 1000;
+		frame.joints[0].linearVelocity[0] = spike ? 3.f : 0.5f + noise(random);
+		frame.joints[1].linearVelocity[0] = 0.5f + noise(random);
+		return frame;
+	};
+
+	for (int n = 0; n < 999; n++)
+		quality.observe(frame_at(n));
+	EXPECT_EQ(summary_of(quality, 0).velocityOutliers, 0u);
+
+	quality.observe(frame_at(999));
+	quality.observe(frame_at(1000));
+	const TrackingQuality::JointQuality joint = summary_of(quality, 0);
+	EXPECT_EQ(joint.velocityOutliers, 1u);
+	EXPECT_EQ(joint.accelerationOutliers, 0u);
+	EXPECT_GT(joint.outlierRate, 0.0);
+	EXPECT_EQ(summary_of(quality, 1).velocityOutliers, 0u);
+}
+
+TEST(TrackingQuality, MeasuresJitterOnlyAtRest)
+{
+	TrackingQuality quality;
+	std::mt19937 random(5);
+	std::normal_distribution<float> position_noise(0.f, 0.001f); // 1 mm per axis
+	std::normal_distribution<float> angle_noise(0.f, 0.2f * std::numbers::pi_v<float> / 180.f); // 0.2 deg
+
+	for (int n = 0; n < 3000; n++)
+	{
+		JointFrame frame = touch_frame(1.0 + n * step);
+
+		// Joint 0 resting somewhere with a noisy pose
+		JointSample& resting = frame.joints[0];
+		resting.position[0] = 0.3f + position_noise(random);
+		resting.position[1] = 1.2f + position_noise(random);
+		resting.position[2] = -0.4f + position_noise(random);
+		Eigen::Map<Eigen::Quaternionf>(resting.orientation) =
+			Eigen::Quaternionf(Eigen::AngleAxisf(1.f + angle_noise(random), Eigen::Vector3f::UnitY()));
+
+		// Joint 1 the same noise, but moving
+		JointSample& moving = frame.joints[1];
+		moving.position[0] = position_noise(random);
+		moving.linearVelocity[0] = 0.5f;
+
+		quality.observe(frame);
+	}
+
+	// RMS of the 3D deviation: sqrt(3) x per axis
+	const TrackingQuality::JointQuality joint = summary_of(quality, 0);
+	EXPECT_NEAR(joint.positionJitter, std::sqrt(3.0), 0.25);
+	EXPECT_NEAR(joint.angularJitter, 0.2, 0.04);
+
+	EXPECT_EQ(summary_of(quality, 1).positionJitter, 0.0);
+}
+
+TEST(TrackingQuality, ObjectsGoToTheirSlotsLane)
+{
+	TrackingQuality quality;
+	for (int n = 0; n < 10; n++)
+	{
+		JointFrame frame = touch_frame(1.0 + n * step);
+		frame.jointCount = 3;
+		frame.objectMask = 1ull << 3;
+		frame.joints[2].sampleTime = frame.frameTime;
+		frame.joints[2].statusFlags = tracked;
+		quality.observe(frame);
+	}
+
+	TrackingQuality::Summary summary;
+	quality.summary(summary);
+	EXPECT_EQ(summary[2].samples, 0u);
+	EXPECT_EQ(summary[5].samples, 10u);
+
+	const std::string json = TrackingQuality::to_json(summary);
+	EXPECT_NE(json.find("\"device\": 5"), std::string::npos);
+	EXPECT_EQ(json.find("\"device\": 2"), std::string::npos);
+
+	quality.reset();
+	quality.summary(summary);
+	EXPECT_EQ(summary[5].samples, 0u);
+}